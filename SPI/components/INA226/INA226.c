@@ -1,17 +1,19 @@
-#include "ina226.h"
-#include "i2c.h"
+#include "INA226.h"
+#if !defined(ESP_PLATFORM) && !defined(INA226_SIM_HOST)
+#include "main.h"
+#include "INA226_hal.h"
+#endif
 
+#include <assert.h>
+#include <math.h>
+#include <string.h>
 
-/* I2C 传输超时（ms） */
-#ifndef INA226_I2C_TIMEOUT_MS
-#define INA226_I2C_TIMEOUT_MS  500
-#endif
 
 /* Configuration Register 字段位 */
 #define INA226_CFG_RST      (1U<<15)
-#define INA226_CFG_AVG(x)   (((x)&0x7)<<12)
-#define INA226_CFG_VBUSCT(x) (((x)&0x7)<<9)
-#define INA226_CFG_VSHCT(x)  (((x)&0x7)<<6)
+#define INA226_CFG_AVG(x)   (((x)&0x7)<<9)
+#define INA226_CFG_VBUSCT(x) (((x)&0x7)<<6)
+#define INA226_CFG_VSHCT(x)  (((x)&0x7)<<3)
 #define INA226_CFG_MODE(x)   (((x)&0x7)<<0)
 
 /*
@@ -42,33 +44,52 @@ MODE[2:0][Bin]	模式编号[Dec]		模式名称							描述
 
 /* ------------------------------------------------------------------
   低层 I2C 读写
+  寄存器访问全部经由 INA226_Bus 传输层（HAL / ESP-IDF 等后端），
+  仅以地址调用的旧接口走默认总线：STM32 上未设置时自动使用 HAL 后端（hi2c2，与原实现一致），
+  其它平台必须先调用 INA226_SetDefaultBus，否则断言失败，不会静默读出 0
 	 ------------------------------------------------------------------ */
-void INA226_WriteRegister(uint8_t dev_addr, uint8_t reg, uint16_t value)
+static const INA226_Bus *ina226_default_bus = NULL;
+
+/* 设置旧接口（只传 dev_addr）使用的总线 */
+void INA226_SetDefaultBus(const INA226_Bus *bus)
 {
-    uint8_t tx[3];
-    tx[0] = reg;
-    tx[1] = (uint8_t)(value >> 8);
-    tx[2] = (uint8_t)(value & 0xFF);
+    ina226_default_bus = bus;
+}
 
-    uint16_t devAddr8 = (uint16_t)(dev_addr << 1); /* HAL 使用 8-bit 地址 */
+static const INA226_Bus *INA226_LegacyBus(void)
+{
+#if !defined(ESP_PLATFORM) && !defined(INA226_SIM_HOST)
+    if (ina226_default_bus == NULL) ina226_default_bus = INA226_BusHAL_Default();
+#endif
+    assert(ina226_default_bus != NULL && "INA226_SetDefaultBus() not called");
+    return ina226_default_bus;
+}
 
-    HAL_I2C_Master_Transmit(&hi2c2, devAddr8, tx, sizeof(tx), INA226_I2C_TIMEOUT_MS);
+void INA226_WriteRegister(uint8_t dev_addr, uint8_t reg, uint16_t value)
+{
+    const INA226_Bus *bus = INA226_LegacyBus();
+    if (bus == NULL) return;
+    bus->write_reg(bus->ctx, dev_addr, reg, value);
 }
 
 uint16_t INA226_ReadRegister(uint8_t dev_addr, uint8_t reg)
 {
-    uint8_t buf[2] = {0};
-    uint16_t devAddr8 = (uint16_t)(dev_addr << 1);
+    const INA226_Bus *bus = INA226_LegacyBus();
+    uint16_t value = 0;
+    if (bus == NULL) return 0;
+    bus->read_reg(bus->ctx, dev_addr, reg, &value);
+    return value;
+}
 
-    HAL_I2C_Mem_Read(&hi2c2,
-                     devAddr8,
-                     reg,
-                     I2C_MEMADD_SIZE_8BIT,
-                     buf,
-                     2,
-                     INA226_I2C_TIMEOUT_MS);
+/* 设备级寄存器访问，返回 0 成功，-1 失败或超时 */
+int INA226_DevWrite(INA226_Dev *dev, uint8_t reg, uint16_t value)
+{
+    return dev->bus->write_reg(dev->bus->ctx, dev->addr, reg, value);
+}
 
-    return ((uint16_t)buf[0] << 8) | buf[1];
+int INA226_DevRead(INA226_Dev *dev, uint8_t reg, uint16_t *value)
+{
+    return dev->bus->read_reg(dev->bus->ctx, dev->addr, reg, value);
 }
 
 
@@ -96,7 +117,7 @@ void INA226_Configuration(uint8_t dev_addr, uint8_t avgSamples, uint8_t vbusCT,
 void INA226_Init(uint8_t dev_addr, uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode)
 {
     INA226_Reset(dev_addr);
-    HAL_Delay(5);
+    INA226_DELAY_MS(5);
     INA226_Configuration(dev_addr, avgSamples, vbusCT, vshCT, mode);
     INA226_WriteRegister(dev_addr, INA226_REG_CALIBRATION, INA226_CALIBRATION_VALUE);
 }
@@ -132,19 +153,815 @@ float INA226_GetShuntVoltage(uint8_t dev_addr)
     return (float)raw * 2.5f / 1000.0f;  /* 1 LSB = 2.5 µV */
 }
 
+/* Current LSB for the legacy getters, recomputed only when RESISTOR changes */
+static float INA226_LegacyCurrentLSB(void)
+{
+    static float cached_r   = 0.0f;
+    static float cached_lsb = 0.0f;
+
+    if (SHUNT_RESISTOR_VALUE != cached_r) {
+        cached_r   = SHUNT_RESISTOR_VALUE;
+        cached_lsb = 0.00512f / (INA226_CALIBRATION_VALUE * cached_r);
+    }
+    return cached_lsb;
+}
+
+/* 整数换算系数：current_lsb = 0.00512 / (CAL × R)，以 pA 表示，只在校准改变时计算一次 */
+static uint32_t INA226_LsbPicoAmp(uint16_t cal, float shunt_ohm)
+{
+    double pa = 5.12e9 / ((double)cal * shunt_ohm);
+    return (pa >= 4294967295.0) ? 0xFFFFFFFFU : (uint32_t)(pa + 0.5);
+}
+
+static uint32_t INA226_LegacyLsbPicoAmp(void)
+{
+    static float    cached_r  = 0.0f;
+    static uint32_t cached_pa = 0;
+
+    if (SHUNT_RESISTOR_VALUE != cached_r) {
+        cached_r  = SHUNT_RESISTOR_VALUE;
+        cached_pa = INA226_LsbPicoAmp(INA226_CALIBRATION_VALUE, cached_r);
+    }
+    return cached_pa;
+}
+
 /* Compute current using calibration LSB (A) */
 float INA226_GetCurrent(uint8_t dev_addr)
 {
     int16_t raw = (int16_t)INA226_ReadRegister(dev_addr, INA226_REG_CURRENT);
-    float current_lsb = 0.00512f / (INA226_CALIBRATION_VALUE * SHUNT_RESISTOR_VALUE);
-    return (float)raw * current_lsb;
+    return (float)raw * INA226_LegacyCurrentLSB();
 }
 
 /* Compute power using built-in power LSB = 25 × current LSB (W) */
 float INA226_GetPower(uint8_t dev_addr)
 {
     uint16_t raw = INA226_ReadRegister(dev_addr, INA226_REG_POWER);
-    float current_lsb = 0.00512f / (INA226_CALIBRATION_VALUE * SHUNT_RESISTOR_VALUE);
-    float power_lsb   = current_lsb * 25.0f;
-    return (float)raw * power_lsb;
+    return (float)raw * (INA226_LegacyCurrentLSB() * 25.0f);
+}
+
+/* 整数版本：μV / μA / μW */
+int32_t INA226_GetBusVoltage_uV(uint8_t dev_addr)
+{
+    return INA226_BUS_UV(INA226_ReadRegister(dev_addr, INA226_REG_BUSVOLTAGE));
+}
+
+int32_t INA226_GetShuntVoltage_uV(uint8_t dev_addr)
+{
+    int16_t raw = (int16_t)INA226_ReadRegister(dev_addr, INA226_REG_SHUNTVOLTAGE);
+    return INA226_SHUNT_UV(raw);
+}
+
+int32_t INA226_GetCurrent_uA(uint8_t dev_addr)
+{
+    int16_t raw = (int16_t)INA226_ReadRegister(dev_addr, INA226_REG_CURRENT);
+    return INA226_CURRENT_UA(raw, INA226_LegacyLsbPicoAmp());
+}
+
+int64_t INA226_GetPower_uW(uint8_t dev_addr)
+{
+    uint16_t raw = INA226_ReadRegister(dev_addr, INA226_REG_POWER);
+    return INA226_POWER_UW(raw, INA226_LegacyLsbPicoAmp());
+}
+
+
+/* ------------------------------------------------------------------
+  设备上下文 API
+	 ------------------------------------------------------------------ */
+
+/**
+ * @brief 初始化设备上下文：复位 + 配置 + 校准，并一次性算好换算系数
+ * @note  分流电阻仍取 SHUNT_RESISTOR_VALUE，校准值取 INA226_CALIBRATION_VALUE；
+ *        需要充分利用分辨率时随后调用 INA226_Calibrate
+ */
+void INA226_DevInit(INA226_Dev *dev, const INA226_Bus *bus, uint8_t dev_addr,
+                    uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode)
+{
+    dev->bus         = bus;
+    dev->mask        = 0;                   // 复位后 Mask/Enable 为 0
+    dev->addr        = dev_addr;
+    dev->derive      = 0;
+    dev->cal         = INA226_CALIBRATION_VALUE;
+    dev->shunt_ohm   = SHUNT_RESISTOR_VALUE;
+    dev->current_lsb = 0.00512f / ((float)dev->cal * dev->shunt_ohm);
+    dev->power_lsb   = dev->current_lsb * 25.0f;
+    dev->max_current = dev->current_lsb * 32767.0f;
+    dev->current_lsb_pa = INA226_LsbPicoAmp(dev->cal, dev->shunt_ohm);
+    dev->config      = INA226_CFG_AVG(avgSamples) | INA226_CFG_VBUSCT(vbusCT)
+                     | INA226_CFG_VSHCT(vshCT) | INA226_CFG_MODE(mode);
+
+    INA226_DevWrite(dev, INA226_REG_CONFIG, INA226_CFG_RST);
+    INA226_DELAY_MS(5);
+    INA226_DevWrite(dev, INA226_REG_CONFIG, dev->config);
+    INA226_DevWrite(dev, INA226_REG_CALIBRATION, dev->cal);
+}
+
+/**
+ * @brief 一次性读取分流、母线、电流、功率并换算
+ *
+ * INA226 不支持寄存器指针自增，四个寄存器只能分别寻址；这里把四次读取
+ * 紧挨着排在一起，共用一个时间戳，换算只用预先算好的系数（无除法）。
+ * dev->derive 置 1 时只读分流与母线，电流/功率按芯片内部算法推导：
+ *   Current = Shunt × CAL / 2048，Power = Current × Bus / 20000
+ * 结果与芯片寄存器一致，总线事务减半。
+ *
+ * @return 0 成功，-1 任一次 I2C 传输失败
+ */
+static int INA226_ReadSnapshotRaw(INA226_Dev *dev, INA226_Snapshot *snap)
+{
+    uint16_t shunt, bus, current, power;
+
+    snap->t_us = INA226_TIMESTAMP_US();
+
+    if (INA226_DevRead(dev, INA226_REG_SHUNTVOLTAGE, &shunt) != 0) return -1;
+    if (INA226_DevRead(dev, INA226_REG_BUSVOLTAGE,   &bus)   != 0) return -1;
+
+    if (dev->derive) {
+        int32_t cur = ((int32_t)(int16_t)shunt * dev->cal) / 2048;
+        current = (uint16_t)(int16_t)cur;
+        power   = (uint16_t)(((uint32_t)(cur < 0 ? -cur : cur) * bus) / 20000U);
+    } else {
+        if (INA226_DevRead(dev, INA226_REG_CURRENT, &current) != 0) return -1;
+        if (INA226_DevRead(dev, INA226_REG_POWER,   &power)   != 0) return -1;
+    }
+
+    snap->shunt_raw   = (int16_t)shunt;
+    snap->bus_raw     = bus;
+    snap->current_raw = (int16_t)current;
+    snap->power_raw   = power;
+    return 0;
+}
+
+/* 原始值 → μV / μA / μW，只用整数乘除 */
+void INA226_SnapshotToInt(const INA226_Dev *dev, INA226_Snapshot *snap)
+{
+    snap->shunt_uv   = INA226_SHUNT_UV(snap->shunt_raw);
+    snap->bus_uv     = INA226_BUS_UV(snap->bus_raw);
+    snap->current_ua = INA226_CURRENT_UA(snap->current_raw, dev->current_lsb_pa);
+    snap->power_uw   = INA226_POWER_UW(snap->power_raw, dev->current_lsb_pa);
+}
+
+/* 原始值 → V / A / W */
+void INA226_SnapshotToFloat(const INA226_Dev *dev, INA226_Snapshot *snap)
+{
+    snap->shunt_v   = (float)snap->shunt_raw * 2.5e-6f;
+    snap->bus_v     = (float)snap->bus_raw * 1.25e-3f;
+    snap->current_a = (float)snap->current_raw * dev->current_lsb;
+    snap->power_w   = (float)snap->power_raw * dev->power_lsb;
+}
+
+int INA226_ReadSnapshot(INA226_Dev *dev, INA226_Snapshot *snap)
+{
+    if (INA226_ReadSnapshotRaw(dev, snap) != 0) return -1;
+    INA226_SnapshotToInt(dev, snap);
+    INA226_SnapshotToFloat(dev, snap);
+    return 0;
+}
+
+/* 只做整数换算的快照读取（ESP32-C3 等无 FPU 平台），浮点字段不更新 */
+int INA226_ReadSnapshotInt(INA226_Dev *dev, INA226_Snapshot *snap)
+{
+    if (INA226_ReadSnapshotRaw(dev, snap) != 0) return -1;
+    INA226_SnapshotToInt(dev, snap);
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  运行时校准
+	 ------------------------------------------------------------------ */
+
+/**
+ * @brief 按分流电阻与最大期望电流计算校准值并写入芯片
+ *
+ * 电流寄存器为 16 位有符号数，正向最大 32767，最优 Current_LSB = Imax / 32767
+ * （除以 2^15 时 Imax 恰好对应 32768，寄存器饱和在 32767，满量程读不到）；
+ * CAL = 0.00512 / (Current_LSB × Rshunt)，取整后反算实际 LSB，
+ * 使 CURRENT 寄存器在 Imax 处接近满量程，分辨率不浪费。
+ *
+ * @param shunt_ohm     分流电阻（Ω）
+ * @param max_current_a 最大期望电流（A）
+ * @return 0 成功；1 已写入但量程受限（CAL 越界被钳位，或 Imax × R 超出分流 ADC 81.92 mV）；
+ *         -1 参数无效，未写入
+ */
+int INA226_Calibrate(INA226_Dev *dev, float shunt_ohm, float max_current_a)
+{
+    if (!(shunt_ohm > 0.0f) || !(max_current_a > 0.0f)) return -1;
+
+    int limited = 0;
+    float lsb = max_current_a / 32767.0f;
+    float cal = 0.00512f / (lsb * shunt_ohm);
+
+    if (cal > (float)INA226_CAL_MAX) {
+        cal = (float)INA226_CAL_MAX;       // 分辨率受 CAL 上限约束
+        limited = 1;
+    }
+    if (cal < 1.0f) return -1;
+
+    /* 向下取整：实际 LSB 略大于理论值，保证 Imax 不溢出 */
+    dev->cal         = (uint16_t)cal;
+    dev->shunt_ohm   = shunt_ohm;
+    dev->current_lsb = 0.00512f / ((float)dev->cal * shunt_ohm);
+    dev->power_lsb   = dev->current_lsb * 25.0f;
+    dev->current_lsb_pa = INA226_LsbPicoAmp(dev->cal, shunt_ohm);
+    dev->max_current = max_current_a;
+
+    if (max_current_a * shunt_ohm > INA226_SHUNT_FULL_SCALE) {
+        limited = 1;                       // 分流电压先于电流寄存器饱和
+    }
+
+    INA226_DevWrite(dev, INA226_REG_CALIBRATION, dev->cal);
+    return limited;
+}
+
+/**
+ * @brief 运行时切换量程（分流电阻不变）
+ * @note  新的 CAL 从下一次转换开始生效
+ */
+int INA226_SetRange(INA226_Dev *dev, float max_current_a)
+{
+    return INA226_Calibrate(dev, dev->shunt_ohm, max_current_a);
+}
+
+
+/* ------------------------------------------------------------------
+  中断驱动采样（ALERT = Conversion Ready）
+
+  用法：
+    INA226_EnableConvReady(&dev, wake_sampler, NULL);
+    GPIO EXTI 下降沿回调中调用 INA226_AlertISR(&dev);
+    采样任务 / 主循环：
+        while (!dev.ready) { __WFI(); }      // 或等待任务通知
+        INA226_ReadReady(&dev, &snap);
+  每次转换只读取一次，不会重复读到旧数据，也不必按转换时间猜测轮询周期。
+	 ------------------------------------------------------------------ */
+
+/* 打开转换完成告警（ALERT 低有效、非锁存），并清除可能挂起的标志 */
+void INA226_EnableConvReady(INA226_Dev *dev, void (*on_ready)(void *arg), void *arg)
+{
+    dev->on_ready     = on_ready;
+    dev->on_ready_arg = arg;
+    dev->ready        = 0;
+    dev->irq_count    = 0;
+    dev->overrun      = 0;
+    dev->spurious     = 0;
+
+    uint16_t me;
+    dev->mask |= INA226_ME_CNVR;                       // 保留已设置的限值告警
+    INA226_DevWrite(dev, INA226_REG_MASK_ENABLE, dev->mask);
+    (void)INA226_DevRead(dev, INA226_REG_MASK_ENABLE, &me);
+}
+
+void INA226_DisableConvReady(INA226_Dev *dev)
+{
+    dev->mask &= (uint16_t)~INA226_ME_CNVR;
+    INA226_DevWrite(dev, INA226_REG_MASK_ENABLE, dev->mask);
+    dev->on_ready = NULL;
+    dev->ready    = 0;
+}
+
+/* 在 ALERT 引脚的 EXTI 回调中调用：只置标志，不访问 I2C；已布防保护时先执行断开 */
+void INA226_AlertISR(INA226_Dev *dev)
+{
+    INA226_AlertISRAt(dev, INA226_CYCLES());
+}
+
+/**
+ * @brief 同 INA226_AlertISR，边沿时刻由调用者给出
+ * @param edge_cycles EXTI 中断入口第一条语句读取的 INA226_CYCLES()，或定时器输入捕获值；
+ *                    经 HAL 分发到回调后再取会漏掉分发耗时，保护延时统计偏小
+ */
+void INA226_AlertISRAt(INA226_Dev *dev, uint32_t edge_cycles)
+{
+    if (dev->protect && dev->protect->armed) {
+        INA226_ProtectISR(dev, edge_cycles);
+        return;
+    }
+    dev->irq_count++;
+    if (dev->ready) {
+        dev->overrun++;                    // 上一次结果还没被取走
+    }
+    dev->ready = 1;
+    if (dev->on_ready) {
+        dev->on_ready(dev->on_ready_arg);
+    }
+}
+
+/**
+ * @brief 读取一次已完成的转换
+ *
+ * 先读 Mask/Enable：清除 CVRF 并释放 ALERT，同时确认确有新转换；
+ * 再读结果寄存器。若读取期间下一次转换完成，ALERT 会再次触发，不会丢失。
+ *
+ * @return 1 读到新数据；0 无新转换（未触发或误触发）；-1 I2C 失败
+ */
+int INA226_ReadReady(INA226_Dev *dev, INA226_Snapshot *snap)
+{
+    uint16_t me;
+
+    if (!dev->ready) return 0;
+    dev->ready = 0;
+
+    if (INA226_DevRead(dev, INA226_REG_MASK_ENABLE, &me) != 0) return -1;
+    if (!(me & INA226_ME_CVRF)) {
+        dev->spurious++;
+        return 0;
+    }
+
+    return (INA226_ReadSnapshot(dev, snap) == 0) ? 1 : -1;
+}
+
+
+/* ------------------------------------------------------------------
+  限值告警与低延时保护
+
+  Mask/Enable 高 5 位选择一种告警功能，Alert Limit 寄存器与对应结果寄存器同单位比较：
+  SOL/SUL 对比分流电压（2.5μV/LSB，有符号），BOL/BUL 对比母线电压（1.25mV/LSB），
+  POL 对比功率寄存器（power_lsb）。比较在每次转换（含平均）完成后进行，
+  因此保护响应时间 ≥ 一次转换周期，要求快速保护时应配合短转换时间/低平均。
+
+  保护路径：ALERT 边沿 → EXTI → INA226_AlertISRAt → trip()，全程不访问 I2C、不经过任务调度；
+  随后在任务中调用 INA226_AlertAck 读 Mask/Enable 确认原因并释放锁存。
+
+  延时统计从 ALERT 边沿算到 trip() 返回，边沿时刻须在中断入口处取得：
+    void EXTI4_15_IRQHandler(void)
+    {
+        uint32_t edge = INA226_CYCLES();              // 第一条语句
+        if (__HAL_GPIO_EXTI_GET_FALLING_IT(ALERT_Pin)) {
+            __HAL_GPIO_EXTI_CLEAR_FALLING_IT(ALERT_Pin);
+            INA226_AlertISRAt(&dev, edge);
+        }
+        ...                                           // 同一中断线上的其它引脚
+    }
+  ALERT 接在计数定时器的捕获通道上时，可改为传入捕获寄存器值，连中断入栈延时也计入。
+	 ------------------------------------------------------------------ */
+/**
+ * @brief 设置限值告警
+ * @param func INA226_ME_SOL / SUL / BOL / BUL / POL 之一
+ * @param limit 限值（A / V / W，见头文件说明）
+ * @param flags INA226_ALERT_LATCH | INA226_ALERT_ACTIVE_HIGH
+ * @return 0 成功；-1 参数无效或 I2C 失败
+ */
+int INA226_SetAlertLimit(INA226_Dev *dev, uint16_t func, float limit, uint16_t flags)
+{
+    float raw;
+
+    switch (func) {
+    case INA226_ME_SOL:
+    case INA226_ME_SUL: raw = limit * dev->shunt_ohm / 2.5e-6f; break;
+    case INA226_ME_BOL:
+    case INA226_ME_BUL: raw = limit / 1.25e-3f;                 break;
+    case INA226_ME_POL: raw = limit / dev->power_lsb;           break;
+    default:            return -1;
+    }
+
+    int32_t v = (int32_t)(raw >= 0.0f ? raw + 0.5f : raw - 0.5f);
+    if (func == INA226_ME_SOL || func == INA226_ME_SUL) {
+        if (v > 32767)  v = 32767;
+        if (v < -32768) v = -32768;
+    } else {
+        if (v < 0)      v = 0;
+        if (v > (func == INA226_ME_POL ? 0xFFFF : 0x7FFF)) v = (func == INA226_ME_POL ? 0xFFFF : 0x7FFF);
+    }
+
+    /* 先写限值再使能功能，避免用旧限值误触发 */
+    if (INA226_DevWrite(dev, INA226_REG_ALERT_LIMIT, (uint16_t)v) != 0) return -1;
+    dev->mask = (uint16_t)((dev->mask & INA226_ME_CNVR) | func
+                         | (flags & (INA226_ME_APOL | INA226_ME_LEN)));
+    return INA226_DevWrite(dev, INA226_REG_MASK_ENABLE, dev->mask);
+}
+
+int INA226_ClearAlertLimit(INA226_Dev *dev)
+{
+    dev->mask &= INA226_ME_CNVR;
+    return INA226_DevWrite(dev, INA226_REG_MASK_ENABLE, dev->mask);
+}
+
+/**
+ * @brief 布防保护
+ * @note 保护与转换完成中断共用 ALERT 引脚，布防时关闭 CNVR（撤防时恢复），任何 ALERT 边沿都视为越限；
+ *       建议同时使用 INA226_ALERT_LATCH，短暂越限也能保持到软件确认
+ */
+void INA226_ArmProtection(INA226_Dev *dev, INA226_Protect *prot, void (*trip)(void *arg), void *arg)
+{
+    uint16_t me;
+
+#ifdef INA226_CYCLES_ENABLE
+    INA226_CYCLES_ENABLE();
+#endif
+    prot->trip     = trip;
+    prot->trip_arg = arg;
+    prot->tripped  = 0;
+    prot->trips    = 0;
+    prot->lat_last = 0;
+    prot->lat_min  = UINT32_MAX;
+    prot->lat_max  = 0;
+    prot->lat_sum  = 0;
+    prot->cnvr_saved = (dev->mask & INA226_ME_CNVR) ? 1 : 0;
+    dev->protect   = prot;
+
+    if (prot->cnvr_saved) {
+        dev->mask &= (uint16_t)~INA226_ME_CNVR;
+        INA226_DevWrite(dev, INA226_REG_MASK_ENABLE, dev->mask);
+    }
+    (void)INA226_DevRead(dev, INA226_REG_MASK_ENABLE, &me);   // 清除布防前残留的告警
+    prot->armed = 1;
+}
+
+/* 撤防；布防前使用 INA226_EnableConvReady 的设备恢复转换完成告警 */
+void INA226_DisarmProtection(INA226_Dev *dev)
+{
+    INA226_Protect *p = dev->protect;
+    uint16_t me;
+
+    if (!p) return;
+    p->armed     = 0;
+    dev->protect = NULL;
+    if (p->cnvr_saved) {
+        dev->mask |= INA226_ME_CNVR;
+        INA226_DevWrite(dev, INA226_REG_MASK_ENABLE, dev->mask);
+        (void)INA226_DevRead(dev, INA226_REG_MASK_ENABLE, &me);   // 丢弃布防期间残留的 CVRF
+        dev->ready = 0;
+    }
+}
+
+/**
+ * @brief 保护动作，在 ALERT 中断中调用
+ * @param edge_cycles 边沿时刻的 INA226_CYCLES 计数（见 INA226_AlertISRAt）；
+ *                    延时记到 trip() 返回为止，包含断开动作本身的耗时
+ */
+void INA226_ProtectISR(INA226_Dev *dev, uint32_t edge_cycles)
+{
+    INA226_Protect *p = dev->protect;
+
+    p->trip(p->trip_arg);
+    uint32_t lat = (INA226_CYCLES() - edge_cycles) & INA226_CYCLES_MASK;
+
+    p->tripped = 1;
+    p->trips++;
+    p->lat_last = lat;
+    p->lat_sum += lat;
+    if (lat < p->lat_min) p->lat_min = lat;
+    if (lat > p->lat_max) p->lat_max = lat;
+}
+
+/**
+ * @brief 任务中确认告警：读 Mask/Enable（释放锁存），返回原因
+ * @param flags 输出 Mask/Enable 值，AFF 置位表示限值告警
+ * @return 1 限值告警已发生；0 无告警；-1 I2C 失败
+ */
+int INA226_AlertAck(INA226_Dev *dev, uint16_t *flags)
+{
+    uint16_t me;
+    if (INA226_DevRead(dev, INA226_REG_MASK_ENABLE, &me) != 0) return -1;
+    if (flags) *flags = me;
+    if (dev->protect) dev->protect->tripped = 0;
+    return (me & INA226_ME_AFF) ? 1 : 0;
+}
+
+/* 边沿到动作延时统计（μs），未动作过时全部为 0 */
+void INA226_ProtectLatencyUs(const INA226_Protect *prot, float *last, float *min, float *avg, float *max)
+{
+    float k = 1.0f / (float)INA226_CYCLES_PER_US;
+    uint32_t n = prot->trips;
+
+    if (last) *last = n ? prot->lat_last * k : 0.0f;
+    if (min)  *min  = n ? prot->lat_min * k : 0.0f;
+    if (avg)  *avg  = n ? ((float)prot->lat_sum / (float)n) * k : 0.0f;
+    if (max)  *max  = n ? prot->lat_max * k : 0.0f;
+}
+
+
+/* ------------------------------------------------------------------
+  多设备管理
+	 ------------------------------------------------------------------ */
+
+/* 到期但转换未完成时的复查间隔 */
+#define INA226_MGR_RECHECK_US(period)   ((period) / 32 + 20)
+
+static const uint16_t INA226_CT_US[8]  = { 140, 204, 332, 588, 1100, 2116, 4156, 8244 };
+static const uint16_t INA226_AVG_N[8]  = { 1, 4, 16, 64, 128, 256, 512, 1024 };
+
+/* 按配置推算一次完整结果的周期（μs）；Power-down / ADC-OFF 返回 0 */
+uint32_t INA226_ConvPeriodUs(uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode)
+{
+    uint32_t ct = 0;
+    mode &= 0x3;                          // 触发与连续模式的转换时间相同
+    if (mode & 0x1) ct += INA226_CT_US[vshCT & 0x7];
+    if (mode & 0x2) ct += INA226_CT_US[vbusCT & 0x7];
+    return ct * INA226_AVG_N[avgSamples & 0x7];
+}
+
+void INA226_MgrInit(INA226_Manager *m, const INA226_Bus *bus, INA226_Sched policy)
+{
+    memset(m, 0, sizeof(*m));
+    m->bus    = bus;
+    m->policy = (uint8_t)policy;
+}
+
+/* 设置读数发布回调（如 INA226_RingSink + 采样环），NULL 取消 */
+void INA226_MgrSetSink(INA226_Manager *m, INA226_SampleSink sink, void *arg)
+{
+    m->sink     = sink;
+    m->sink_arg = arg;
+}
+
+/* 登记一个设备；返回槽位号，-1 表示已满或重复 */
+int INA226_MgrAdd(INA226_Manager *m, uint8_t dev_addr, uint8_t priority)
+{
+    if (m->count >= INA226_MGR_MAX_DEV) return -1;
+    for (uint8_t i = 0; i < m->count; i++) {
+        if (m->slot[i].dev.addr == dev_addr) return -1;
+    }
+
+    INA226_MgrSlot *sl = &m->slot[m->count];
+    memset(sl, 0, sizeof(*sl));
+    sl->dev.bus  = m->bus;
+    sl->dev.addr = dev_addr;
+    sl->priority = priority;
+    return m->count++;
+}
+
+/**
+ * @brief 扫描 0x40..0x4F，按厂商 ID / 芯片 ID 确认为 INA226 后登记
+ * @return 新登记的设备数
+ */
+int INA226_MgrScan(INA226_Manager *m)
+{
+    int found = 0;
+
+    for (uint8_t addr = INA226_ADDR_FIRST; addr <= INA226_ADDR_LAST; addr++) {
+        uint16_t mfr, die;
+
+        if (m->bus->probe(m->bus->ctx, addr) != 0) continue;
+        if (m->bus->read_reg(m->bus->ctx, addr, INA226_REG_MANUFACTURER, &mfr) != 0) continue;
+        if (m->bus->read_reg(m->bus->ctx, addr, INA226_REG_DIE_ID, &die) != 0) continue;
+        if (mfr != INA226_MANUFACTURER_ID || (die & 0xFFF0) != INA226_DIE_ID) continue;
+
+        if (INA226_MgrAdd(m, addr, 0) >= 0) found++;
+    }
+    return found;
+}
+
+/**
+ * @brief 配置并校准一个槽位，同时推算其转换周期
+ * @return INA226_Calibrate 的返回值；-1 槽位无效
+ */
+int INA226_MgrConfigure(INA226_Manager *m, uint8_t idx,
+                        uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode,
+                        float shunt_ohm, float max_current_a)
+{
+    if (idx >= m->count) return -1;
+
+    INA226_MgrSlot *sl = &m->slot[idx];
+    INA226_DevInit(&sl->dev, m->bus, sl->dev.addr, avgSamples, vbusCT, vshCT, mode);
+    int rc = INA226_Calibrate(&sl->dev, shunt_ohm, max_current_a);
+
+    sl->period_us   = INA226_ConvPeriodUs(avgSamples, vbusCT, vshCT, mode);
+    sl->period_est  = sl->period_us;
+    sl->ready_us    = 0;
+    sl->rechecked   = 0;
+    sl->ready_precise = 0;
+    sl->next_due_us = INA226_TIMESTAMP_US() + sl->period_us;
+    return rc;
+}
+
+/* 选择一个已到期的槽位；无则返回 -1 */
+static int INA226_MgrPick(INA226_Manager *m, uint64_t now)
+{
+    int best = -1;
+
+    for (uint8_t k = 0; k < m->count; k++) {
+        uint8_t i = (uint8_t)((m->rr_next + k) % m->count);
+        INA226_MgrSlot *sl = &m->slot[i];
+
+        if (sl->period_us == 0 || sl->next_due_us > now) continue;
+        if (m->policy == INA226_SCHED_ROUND_ROBIN) return i;
+
+        if (best < 0 ||
+            sl->priority > m->slot[best].priority ||
+            (sl->priority == m->slot[best].priority && sl->next_due_us < m->slot[best].next_due_us)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief 读取一个已完成转换的设备
+ * @param out 读数输出
+ * @param idx 输出读到的槽位号（可为 NULL）
+ * @return 1 读到一次数据；0 暂无已完成的转换（可休眠到 INA226_MgrNextDue）；-1 读取失败
+ * @note 每次读取多一次 Mask/Enable 访问；该读操作会清除锁存的 AFF，标志保存在 me_last
+ */
+int INA226_MgrPoll(INA226_Manager *m, INA226_Snapshot *out, uint8_t *idx)
+{
+    if (m->count == 0) return 0;
+
+    uint64_t now = INA226_TIMESTAMP_US();
+    int i = INA226_MgrPick(m, now);
+    if (i < 0) return 0;
+
+    INA226_MgrSlot *sl = &m->slot[i];
+    m->rr_next = (uint8_t)((i + 1) % m->count);
+    if (idx) *idx = (uint8_t)i;
+
+    /* 读 Mask/Enable 确认转换完成（同时清除 CVRF） */
+    uint16_t me;
+    if (INA226_DevRead(&sl->dev, INA226_REG_MASK_ENABLE, &me) != 0) {
+        sl->errors++;
+        sl->next_due_us = now + INA226_MGR_RECHECK_US(sl->period_us);
+        return -1;
+    }
+    sl->me_last = me;
+    if (!(me & INA226_ME_CVRF)) {
+        sl->early++;
+        sl->rechecked   = 1;
+        sl->next_due_us = now + INA226_MGR_RECHECK_US(sl->period_us);
+        return 0;
+    }
+
+    /* 落后超过一个周期：中间的转换已被覆盖 */
+    if (now > sl->next_due_us + sl->period_us) {
+        sl->skipped += (uint32_t)((now - sl->next_due_us) / sl->period_us);
+    }
+
+    /* 学习实际周期：只用两端都经复查发现（完成时刻已知到一个复查间隔内）的间隔，
+       且在名义值 ±20% 内才采纳 */
+    uint8_t precise = sl->rechecked;
+    if (precise && sl->ready_precise) {
+        uint64_t obs = now - sl->ready_us;
+        if (obs * 5 >= (uint64_t)sl->period_us * 4 && obs * 5 <= (uint64_t)sl->period_us * 6) {
+            sl->period_est = (uint32_t)((int64_t)sl->period_est + ((int64_t)obs - (int64_t)sl->period_est) / 4);
+        }
+    }
+    sl->ready_us      = now;
+    sl->ready_precise = precise;
+    sl->rechecked     = 0;
+
+    /* 重新排期，目标是在完成前一点到期、经一次复查后读取，读取窗口不会跨过下一次完成：
+       完成时刻已知时提前一个复查间隔；未知（到期即已完成，可能已滞后）时提前 1/8 周期 */
+    sl->next_due_us = now + sl->period_est
+                    - (precise ? INA226_MGR_RECHECK_US(sl->period_us) : sl->period_est / 8);
+
+    if (INA226_ReadSnapshot(&sl->dev, out) != 0) {
+        sl->errors++;
+        return -1;
+    }
+    sl->reads++;
+    if (m->sink) m->sink(m->sink_arg, out, (uint8_t)i);
+    return 1;
+}
+
+/* 最近一个到期时间，供调用者休眠等待 */
+uint64_t INA226_MgrNextDue(const INA226_Manager *m)
+{
+    uint64_t t = UINT64_MAX;
+    for (uint8_t i = 0; i < m->count; i++) {
+        if (m->slot[i].period_us && m->slot[i].next_due_us < t) t = m->slot[i].next_due_us;
+    }
+    return t;
+}
+
+/* 写入配置后转换重新开始，按新配置重新排期 */
+int INA226_MgrRetime(INA226_Manager *m, uint8_t idx)
+{
+    if (idx >= m->count) return -1;
+
+    INA226_MgrSlot *sl = &m->slot[idx];
+    uint16_t cfg = sl->dev.config;
+    sl->period_us   = INA226_ConvPeriodUs((cfg >> 9) & 0x7, (cfg >> 6) & 0x7, (cfg >> 3) & 0x7, cfg & 0x7);
+    sl->period_est  = sl->period_us;
+    sl->ready_us    = 0;
+    sl->rechecked   = 0;
+    sl->ready_precise = 0;
+    sl->next_due_us = INA226_TIMESTAMP_US() + sl->period_us;
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  自适应平均 / 转换时间
+	 ------------------------------------------------------------------ */
+/* 只改配置寄存器（不复位、不改校准） */
+int INA226_SetTiming(INA226_Dev *dev, uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode)
+{
+    uint16_t cfg = INA226_CFG_AVG(avgSamples) | INA226_CFG_VBUSCT(vbusCT)
+                 | INA226_CFG_VSHCT(vshCT) | INA226_CFG_MODE(mode);
+    if (INA226_DevWrite(dev, INA226_REG_CONFIG, cfg) != 0) return -1;
+    dev->config = cfg;
+    return 0;
+}
+
+static int INA226_AdaptApply(INA226_Adapt *ad, uint8_t state)
+{
+    const INA226_Timing *tm = &ad->timing[state];
+    if (INA226_SetTiming(ad->dev, tm->avg, tm->vbusCT, tm->vshCT, ad->mode) != 0) return -1;
+    ad->state     = state;
+    ad->calm      = 0;
+    ad->settle    = 0;
+    ad->period_us = INA226_ConvPeriodUs(tm->avg, tm->vbusCT, tm->vshCT, ad->mode);
+    return 0;
+}
+
+/**
+ * @brief 初始化自适应控制并立即写入慢速配置
+ * @param fast 负载变化时使用的配置，如 AVG=1, CT=140μs
+ * @param slow 负载稳定时使用的配置，如 AVG=128, CT=1.1ms
+ * @param slew_up_aps 进入快速状态的电流斜率门限（A/s），退出门限取其 1/4
+ */
+void INA226_AdaptInit(INA226_Adapt *ad, INA226_Dev *dev, INA226_Timing fast, INA226_Timing slow,
+                      uint8_t mode, float slew_up_aps)
+{
+    memset(ad, 0, sizeof(*ad));
+    ad->dev       = dev;
+    ad->timing[INA226_ADAPT_FAST] = fast;
+    ad->timing[INA226_ADAPT_SLOW] = slow;
+    ad->mode      = mode;
+    ad->tau       = 0.05f;
+    ad->alpha     = 0.125f;
+    ad->slew_up   = slew_up_aps;
+    ad->slew_down = slew_up_aps * 0.25f;
+    ad->jump_k    = 6.0f;
+    ad->hold      = 16;
+
+    INA226_AdaptApply(ad, INA226_ADAPT_SLOW);
+}
+
+/**
+ * @brief 输入一次读数，必要时切换配置
+ * @return 1 已切换（使用管理器时需调用 INA226_MgrRetime）；0 未切换；-1 写配置失败
+ */
+int INA226_AdaptFeed(INA226_Adapt *ad, const INA226_Snapshot *snap)
+{
+    float   x   = snap->current_a;
+    uint8_t bit = (uint8_t)(1u << ad->state);
+
+    /* 切换后的第一个样本：可能跨越切换前的负载，只作为新的起点 */
+    if (ad->settle == 0) {
+        ad->mean      = x;
+        ad->trend     = 0.0f;
+        ad->last_x    = x;
+        ad->last_t    = snap->t_us;
+        ad->learn_acc = 0.0f;
+        ad->settle    = 1;
+        return 0;
+    }
+
+    float dt = (float)(snap->t_us - ad->last_t) * 1e-6f;
+    if (dt <= 0.0f) return 0;
+    ad->last_t = snap->t_us;
+
+    /* 噪底学习：相邻差分不受均值跟踪滞后影响，方差为单点的 2 倍 */
+    if (ad->settle <= INA226_ADAPT_LEARN_N) {
+        float d = x - ad->last_x;
+        ad->learn_acc += 0.5f * d * d;
+        if (ad->settle++ == INA226_ADAPT_LEARN_N) {
+            ad->noise_var[ad->state] = ad->learn_acc / INA226_ADAPT_LEARN_N;
+            ad->learned |= bit;
+        }
+    }
+    ad->last_x = x;
+
+    /* 噪底：下限为 1 LSB；尚未学习的状态不做阶跃判定 */
+    float  floor_a = sqrtf(ad->noise_var[ad->state]);
+    if (floor_a < ad->dev->current_lsb) floor_a = ad->dev->current_lsb;
+
+    /* 均值与斜率都按时间常数 tau 平滑，慢速 / 快速配置下同一斜率得到同一判据 */
+    float a     = dt / (ad->tau + dt);
+    float r     = x - ad->mean;
+    float step  = a * r;
+    ad->mean   += step;
+    ad->trend  += a * (step / dt - ad->trend);
+    float slew  = fabsf(ad->trend);
+    int   jump  = (ad->learned & bit) && fabsf(r) > ad->jump_k * floor_a;
+
+    if (!jump && slew < ad->slew_down) {
+        if (ad->settle > INA226_ADAPT_LEARN_N)
+            ad->noise_var[ad->state] += ad->alpha * (r * r - ad->noise_var[ad->state]);
+        if (ad->calm < 0xFFFF) ad->calm++;
+    } else {
+        ad->calm = 0;
+    }
+
+    if (ad->state == INA226_ADAPT_SLOW && (jump || slew > ad->slew_up)) {
+        ad->switches++;
+        return INA226_AdaptApply(ad, INA226_ADAPT_FAST) == 0 ? 1 : -1;
+    }
+    if (ad->state == INA226_ADAPT_FAST && ad->calm >= ad->hold) {
+        ad->switches++;
+        return INA226_AdaptApply(ad, INA226_ADAPT_SLOW) == 0 ? 1 : -1;
+    }
+    return 0;
+}
+
+/* 当前配置下的有效输出速率（次/秒） */
+float INA226_AdaptRateHz(const INA226_Adapt *ad)
+{
+    return ad->period_us ? 1e6f / (float)ad->period_us : 0.0f;
+}
+
+/* 当前配置下测得的电流噪底（A，1σ） */
+float INA226_AdaptNoiseFloor(const INA226_Adapt *ad)
+{
+    return sqrtf(ad->noise_var[ad->state]);
 }
@@ -11,6 +11,27 @@
 #define INA226_REG_POWER          0x03
 #define INA226_REG_CURRENT        0x04
 #define INA226_REG_CALIBRATION    0x05
+#define INA226_REG_MASK_ENABLE    0x06
+#define INA226_REG_ALERT_LIMIT    0x07
+#define INA226_REG_MANUFACTURER   0xFE
+#define INA226_REG_DIE_ID         0xFF
+
+#define INA226_MANUFACTURER_ID    0x5449    // "TI"
+#define INA226_DIE_ID             0x2260
+
+/* Mask/Enable 寄存器位 */
+#define INA226_ME_SOL             (1U<<15)  // 分流电压超上限
+#define INA226_ME_SUL             (1U<<14)  // 分流电压低于下限
+#define INA226_ME_BOL             (1U<<13)  // 母线电压超上限
+#define INA226_ME_BUL             (1U<<12)  // 母线电压低于下限
+#define INA226_ME_POL             (1U<<11)  // 功率超上限
+#define INA226_ME_LIMIT_MASK      0xF800U   // 以上五种告警功能（同时只能选一种）
+#define INA226_ME_CNVR            (1U<<10)  // ALERT 引脚指示转换完成
+#define INA226_ME_AFF             (1U<<4)   // 告警功能标志
+#define INA226_ME_CVRF            (1U<<3)   // 转换完成标志（读 Mask/Enable 清除）
+#define INA226_ME_OVF             (1U<<2)   // 运算溢出
+#define INA226_ME_APOL            (1U<<1)   // ALERT 极性：1 高有效
+#define INA226_ME_LEN             (1U<<0)   // ALERT 锁存
 
 // Calibration & shunt resistor(本代码实现绕过了校准值的计算，无需修改)
 #define INA226_CALIBRATION_VALUE  1024
@@ -18,15 +39,325 @@
 #define SHUNT_RESISTOR_VALUE      RESISTOR
 extern float RESISTOR;
 
+/* 单次 I2C 传输超时（ms）。INA226 一次寄存器读写 < 0.5ms，超时只用于总线卡死时及时返回 */
+#ifndef INA226_I2C_TIMEOUT_MS
+#define INA226_I2C_TIMEOUT_MS     5
+#endif
+
+/* 时间戳来源（μs）与毫秒延时，可在编译选项中替换 */
+#if defined(ESP_PLATFORM)
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#ifndef INA226_TIMESTAMP_US
+#define INA226_TIMESTAMP_US()     ((uint64_t)esp_timer_get_time())
+#endif
+#ifndef INA226_DELAY_MS
+#define INA226_DELAY_MS(ms)       vTaskDelay(pdMS_TO_TICKS(ms) ? pdMS_TO_TICKS(ms) : 1)
+#endif
+#include "esp_cpu.h"
+#ifndef INA226_CYCLES
+#define INA226_CYCLES()           ((uint32_t)esp_cpu_get_cycle_count())
+#define INA226_CYCLES_PER_US      ((uint32_t)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)
+#endif
+#elif defined(INA226_SIM_HOST)
+/* 主机仿真：使用 INA226_sim.c 的仿真时钟 */
+uint64_t INA226_SimClock_Now(void);
+void     INA226_SimClock_Delay(uint32_t ms);
+#ifndef INA226_TIMESTAMP_US
+#define INA226_TIMESTAMP_US()     INA226_SimClock_Now()
+#endif
+#ifndef INA226_DELAY_MS
+#define INA226_DELAY_MS(ms)       INA226_SimClock_Delay(ms)
+#endif
+#ifndef INA226_CYCLES
+#define INA226_CYCLES()           ((uint32_t)INA226_SimClock_Now())
+#define INA226_CYCLES_PER_US      1U
+#endif
+#else
+#ifndef INA226_TIMESTAMP_US
+#define INA226_TIMESTAMP_US()     ((uint64_t)HAL_GetTick() * 1000U)
+#endif
+#ifndef INA226_DELAY_MS
+#define INA226_DELAY_MS(ms)       HAL_Delay(ms)
+#endif
+/* 保护延时计数器，INA226_ArmProtection 中使能。
+   STM32G030（Cortex-M0+）没有 DWT，默认用一个自由运行的 16 位定时器按 TIM 时钟计数
+   （PSC=0，APB 不分频时即内核时钟，64MHz 下约 1ms 回绕，足以覆盖中断延时）；
+   Cortex-M3 及以上可定义 INA226_CYCLES_DWT 改用 DWT 周期计数器 */
+#ifndef INA226_CYCLES
+#if defined(INA226_CYCLES_DWT)
+#define INA226_CYCLES()           (DWT->CYCCNT)
+#define INA226_CYCLES_PER_US      (SystemCoreClock / 1000000U)
+#define INA226_CYCLES_ENABLE()    do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; \
+                                       DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while (0)
+#else
+#ifndef INA226_CYCLES_TIM
+#define INA226_CYCLES_TIM               TIM14
+#define INA226_CYCLES_TIM_CLK_ENABLE()  __HAL_RCC_TIM14_CLK_ENABLE()
+#endif
+#define INA226_CYCLES()           ((uint32_t)INA226_CYCLES_TIM->CNT)
+#define INA226_CYCLES_MASK        0xFFFFU
+#define INA226_CYCLES_PER_US      (SystemCoreClock / 1000000U)
+#define INA226_CYCLES_ENABLE()    do { if (!(INA226_CYCLES_TIM->CR1 & TIM_CR1_CEN)) {          \
+                                           INA226_CYCLES_TIM_CLK_ENABLE();                     \
+                                           INA226_CYCLES_TIM->PSC = 0;                         \
+                                           INA226_CYCLES_TIM->ARR = 0xFFFFU;                   \
+                                           INA226_CYCLES_TIM->EGR = TIM_EGR_UG;                \
+                                           INA226_CYCLES_TIM->CR1 |= TIM_CR1_CEN; } } while (0)
+#endif
+#endif
+#endif
+
+/* 计数器有效位宽，两次读数相减后按此截断以处理回绕 */
+#ifndef INA226_CYCLES_MASK
+#define INA226_CYCLES_MASK        0xFFFFFFFFU
+#endif
+
+/* I2C 传输层：寄存器读写由具体后端实现（INA226_hal.c / INA226_esp.c）
+   所有操作返回 0 成功，-1 失败或超时；超时上限由后端保证，不会无限阻塞 */
+typedef struct {
+    int  (*write_reg)(void *ctx, uint8_t addr, uint8_t reg, uint16_t value);
+    int  (*read_reg)(void *ctx, uint8_t addr, uint8_t reg, uint16_t *value);
+    int  (*probe)(void *ctx, uint8_t addr);     // 地址应答检测
+    void  *ctx;                                 // 后端私有数据
+} INA226_Bus;
+
+/* 硬件限值保护：ALERT 中断中直接执行断开动作，不经过任务调度 */
+typedef struct {
+    void (*trip)(void *arg);        // 断开负载（如直接写 GPIO BSRR），必须极短且可在中断中调用
+    void  *trip_arg;
+    volatile uint8_t  armed;
+    uint8_t           cnvr_saved;   // 布防前是否开着转换完成告警，撤防时恢复
+    volatile uint8_t  tripped;      // 已动作，INA226_AlertAck 后清零
+    volatile uint32_t trips;
+    /* ALERT 边沿到 trip() 返回的延时（INA226_CYCLES 计数） */
+    volatile uint32_t lat_last;
+    volatile uint32_t lat_min;
+    volatile uint32_t lat_max;
+    volatile uint32_t lat_sum;
+} INA226_Protect;
+
+/* 设备上下文：地址与预先计算好的换算系数 */
+typedef struct {
+    const INA226_Bus *bus;  // 所在 I2C 总线
+    uint8_t  addr;          // 7-bit 地址
+    uint8_t  derive;        // 1: 只读分流/母线，电流与功率按芯片算法本地推导（2 次传输代替 4 次）
+    uint16_t cal;           // 校准寄存器值
+    uint16_t config;        // 最近写入的配置寄存器
+    float    shunt_ohm;     // 分流电阻（Ω）
+    float    max_current;   // 当前量程（A），由 INA226_Calibrate 设置
+    float    current_lsb;   // A/LSB
+    float    power_lsb;     // W/LSB = 25 × current_lsb
+    uint32_t current_lsb_pa; // 整数换算系数：pA/LSB（功率 LSB = 25 × 该值 pW）
+
+    /* ALERT 转换完成中断 */
+    volatile uint8_t  ready;        // ISR 置位，读取后清零
+    volatile uint32_t irq_count;    // ALERT 边沿总数
+    volatile uint32_t overrun;      // 上一次转换尚未读取又来新转换
+    uint32_t          spurious;     // 中断到来但 CVRF 未置位
+    void (*on_ready)(void *arg);    // ISR 中回调，用于唤醒采样任务（可为 NULL）
+    void  *on_ready_arg;
+
+    uint16_t        mask;           // Mask/Enable 可写位影子
+    INA226_Protect *protect;        // 限值保护（可为 NULL）
+} INA226_Dev;
+
+/* 一次完整读数 */
+typedef struct {
+    uint64_t t_us;          // 采样时间戳
+    int16_t  shunt_raw;     // 2.5 μV/LSB
+    uint16_t bus_raw;       // 1.25 mV/LSB
+    int16_t  current_raw;   // current_lsb
+    uint16_t power_raw;     // power_lsb
+    float    shunt_v;
+    float    bus_v;
+    float    current_a;
+    float    power_w;
+    int32_t  shunt_uv;      // 整数结果（μV / μA / μW），无 FPU 时使用；shunt_uv 为四舍五入值
+    int32_t  bus_uv;
+    int32_t  current_ua;
+    int64_t  power_uw;
+} INA226_Snapshot;
+
+void INA226_SetDefaultBus(const INA226_Bus *bus);
 void INA226_Reset(uint8_t dev_addr);
 void INA226_Configuration(uint8_t dev_addr, uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode);
 void INA226_Init(uint8_t dev_addr, uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode);
 void INA226_SetConfig(uint8_t dev_addr, uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode);
 
+/* 整数接口：μV / μA / μW，不经过浮点
+   分流 LSB 为 2.5 μV，μV 结果四舍五入（远离零，误差 ≤ 0.5 μV）；需要无损值时用 nV */
+#define INA226_SHUNT_NV(raw)      ((int32_t)(raw) * 2500)           // nV，精确
+#define INA226_BUS_UV(raw)        ((int32_t)(raw) * 1250)           // 1.25 mV/LSB
+#define INA226_CURRENT_UA(raw, lsb_pa)  ((int32_t)(((int64_t)(raw) * (lsb_pa)) / 1000000))
+#define INA226_POWER_UW(raw, lsb_pa)    (((int64_t)(raw) * (lsb_pa) * 25) / 1000000)
+
+/* μV，四舍五入；函数而非宏，参数只求值一次 */
+static inline int32_t INA226_SHUNT_UV(int16_t raw)
+{
+    return ((int32_t)raw * 5 + (raw < 0 ? -1 : 1)) / 2;
+}
+
+int32_t INA226_GetBusVoltage_uV(uint8_t dev_addr);
+int32_t INA226_GetShuntVoltage_uV(uint8_t dev_addr);
+int32_t INA226_GetCurrent_uA(uint8_t dev_addr);
+int64_t INA226_GetPower_uW(uint8_t dev_addr);
+
 float INA226_GetBusVoltage(uint8_t dev_addr);
 float INA226_GetShuntVoltage(uint8_t dev_addr);
 float INA226_GetCurrent(uint8_t dev_addr);
 float INA226_GetPower(uint8_t dev_addr);
 
+void INA226_DevInit(INA226_Dev *dev, const INA226_Bus *bus, uint8_t dev_addr, uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode);
+int  INA226_DevWrite(INA226_Dev *dev, uint8_t reg, uint16_t value);
+int  INA226_DevRead(INA226_Dev *dev, uint8_t reg, uint16_t *value);
+int  INA226_ReadSnapshot(INA226_Dev *dev, INA226_Snapshot *snap);
+int  INA226_ReadSnapshotInt(INA226_Dev *dev, INA226_Snapshot *snap);
+void INA226_SnapshotToInt(const INA226_Dev *dev, INA226_Snapshot *snap);
+void INA226_SnapshotToFloat(const INA226_Dev *dev, INA226_Snapshot *snap);
+
+/* 运行时校准：按分流电阻与最大电流计算最优 Current_LSB 与 CAL */
+#define INA226_CAL_MAX            0x7FFF    // CAL 寄存器 D15 保留
+#define INA226_SHUNT_FULL_SCALE   0.08192f  // 分流 ADC 满量程（V）
+int  INA226_Calibrate(INA226_Dev *dev, float shunt_ohm, float max_current_a);
+int  INA226_SetRange(INA226_Dev *dev, float max_current_a);
+
+/* 中断驱动采样：ALERT 引脚输出转换完成信号 */
+void INA226_EnableConvReady(INA226_Dev *dev, void (*on_ready)(void *arg), void *arg);
+void INA226_DisableConvReady(INA226_Dev *dev);
+void INA226_AlertISR(INA226_Dev *dev);
+void INA226_AlertISRAt(INA226_Dev *dev, uint32_t edge_cycles);
+int  INA226_ReadReady(INA226_Dev *dev, INA226_Snapshot *snap);
+
+/* 限值告警与保护
+   limit 单位：SOL/SUL 为电流（A，按分流电阻换算），BOL/BUL 为电压（V），POL 为功率（W） */
+#define INA226_ALERT_LATCH        INA226_ME_LEN     // 告警锁存，读 Mask/Enable 才释放
+#define INA226_ALERT_ACTIVE_HIGH  INA226_ME_APOL
+
+int      INA226_SetAlertLimit(INA226_Dev *dev, uint16_t func, float limit, uint16_t flags);
+int      INA226_ClearAlertLimit(INA226_Dev *dev);
+void     INA226_ArmProtection(INA226_Dev *dev, INA226_Protect *prot, void (*trip)(void *arg), void *arg);
+void     INA226_DisarmProtection(INA226_Dev *dev);
+void     INA226_ProtectISR(INA226_Dev *dev, uint32_t edge_cycles);
+int      INA226_AlertAck(INA226_Dev *dev, uint16_t *flags);
+void     INA226_ProtectLatencyUs(const INA226_Protect *prot, float *last, float *min, float *avg, float *max);
+
+/* ------------------------------------------------------------------
+   多设备管理：扫描 + 调度
+   所有设备在连续模式下并行转换，管理器只读取已到期（转换完成）的设备，
+   一个设备等待转换的时间被用来读取其它设备。
+   芯片时基误差约 ±10%，名义周期只用于排期：读取前先查 CVRF，未完成则稍后再查，
+   完成则以此刻为基准重新排期，因此不会重复读取同一次转换。
+   每个读数可同时发布给 sink（如 INA226_RingSink 写入采样环），界面等消费者从环中批量读取。
+   ------------------------------------------------------------------ */
+#define INA226_MGR_MAX_DEV        8
+#define INA226_ADDR_FIRST         0x40      // A1/A0 共 16 种组合：0x40..0x4F
+#define INA226_ADDR_LAST          0x4F
+
+typedef enum {
+    INA226_SCHED_ROUND_ROBIN = 0,           // 到期设备轮流读取
+    INA226_SCHED_PRIORITY                   // 到期设备中优先级高者先读
+} INA226_Sched;
+
+typedef struct {
+    INA226_Dev dev;
+    uint8_t    priority;                    // 数值越大越优先
+    uint32_t   period_us;                   // 完整转换周期（由配置推算）
+    uint64_t   next_due_us;                 // 下一次结果就绪时间
+    uint32_t   reads;
+    uint32_t   errors;
+    uint32_t   skipped;                     // 调度落后而跳过的转换数
+    uint32_t   period_est;                  // 按 CVRF 实测的周期（μs），排期用
+    uint64_t   ready_us;                    // 上一次发现 CVRF 的时刻
+    uint8_t    rechecked;                   // 本次转换经过复查才发现（完成时刻误差 ≤ 复查间隔）
+    uint8_t    ready_precise;               // ready_us 是否为复查发现
+    uint32_t   early;                       // 到期时 CVRF 尚未置位的复查次数
+    uint16_t   me_last;                     // 最近一次读到的 Mask/Enable（含 AFF 等标志）
+} INA226_MgrSlot;
+
+/* 读数发布：MgrPoll 每读到一次数据调用一次，在采样任务上下文中执行，不应阻塞 */
+typedef void (*INA226_SampleSink)(void *arg, const INA226_Snapshot *snap, uint8_t idx);
+
+typedef struct {
+    INA226_MgrSlot slot[INA226_MGR_MAX_DEV];
+    const INA226_Bus *bus;                  // 所有设备共用的总线
+    uint8_t        count;
+    uint8_t        policy;                  // INA226_Sched
+    uint8_t        rr_next;                 // 轮询起点
+    INA226_SampleSink sink;                 // 可为 NULL
+    void          *sink_arg;
+} INA226_Manager;
+
+uint32_t INA226_ConvPeriodUs(uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode);
+
+void INA226_MgrInit(INA226_Manager *m, const INA226_Bus *bus, INA226_Sched policy);
+void INA226_MgrSetSink(INA226_Manager *m, INA226_SampleSink sink, void *arg);
+int  INA226_MgrScan(INA226_Manager *m);
+int  INA226_MgrAdd(INA226_Manager *m, uint8_t dev_addr, uint8_t priority);
+int  INA226_MgrConfigure(INA226_Manager *m, uint8_t idx,
+                         uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode,
+                         float shunt_ohm, float max_current_a);
+int  INA226_MgrPoll(INA226_Manager *m, INA226_Snapshot *out, uint8_t *idx);
+uint64_t INA226_MgrNextDue(const INA226_Manager *m);
+int  INA226_MgrRetime(INA226_Manager *m, uint8_t idx);
+
+/* ------------------------------------------------------------------
+   自适应平均 / 转换时间
+   负载变化时切到快速配置（低平均，低延迟），稳定后切回慢速配置（高平均，高分辨率）。
+   判据使用电流均值的斜率与偏离噪底的倍数，进出快速状态的门限不同（迟滞）。
+   均值与斜率按固定时间常数平滑，判据与当前输出速率无关；每次切换后前 INA226_ADAPT_LEARN_N
+   个样本用相邻差分重新学习该状态的噪底。
+   ------------------------------------------------------------------ */
+typedef struct {
+    uint8_t avg;                            // 平均次数编码
+    uint8_t vbusCT;                         // 母线转换时间编码
+    uint8_t vshCT;                          // 分流转换时间编码
+} INA226_Timing;
+
+#ifndef INA226_ADAPT_LEARN_N
+#define INA226_ADAPT_LEARN_N  8             // 切换后学习噪底的样本数
+#endif
+
+typedef enum {
+    INA226_ADAPT_FAST = 0,
+    INA226_ADAPT_SLOW
+} INA226_AdaptState;
+
+typedef struct {
+    INA226_Dev   *dev;
+    INA226_Timing timing[2];                // [INA226_ADAPT_FAST] / [INA226_ADAPT_SLOW]
+    uint8_t       mode;
+    uint8_t       state;                    // INA226_AdaptState
+    uint8_t       settle;                   // 切换后已处理的样本数（0 = 下一个样本重新起算）
+    uint8_t       learned;                  // bit[state]：该状态噪底已学习
+
+    /* 判据 */
+    float    tau;                           // 均值 / 斜率平滑时间常数（s）
+    float    alpha;                         // 稳定期噪声方差 EMA 系数
+    float    slew_up;                       // 均值斜率超过此值（A/s）进入快速
+    float    slew_down;                     // 低于此值才算稳定（< slew_up，形成迟滞）
+    float    jump_k;                        // 单点偏离均值超过 jump_k × 噪底 视为阶跃
+    uint16_t hold;                          // 快速状态下连续稳定样本数达到后切回慢速
+
+    /* 统计 */
+    float    mean;
+    float    trend;                         // 均值斜率（A/s）
+    float    last_x;
+    float    learn_acc;                     // 学习期相邻差分平方和的一半
+    uint64_t last_t;
+    uint16_t calm;
+    float    noise_var[2];                  // 各状态下稳定时测得的残差方差（A^2）
+    uint32_t period_us;                     // 当前配置一次结果的周期
+    uint32_t switches;
+} INA226_Adapt;
+
+int   INA226_SetTiming(INA226_Dev *dev, uint8_t avgSamples, uint8_t vbusCT, uint8_t vshCT, uint8_t mode);
+void  INA226_AdaptInit(INA226_Adapt *ad, INA226_Dev *dev, INA226_Timing fast, INA226_Timing slow,
+                       uint8_t mode, float slew_up_aps);
+int   INA226_AdaptFeed(INA226_Adapt *ad, const INA226_Snapshot *snap);
+float INA226_AdaptRateHz(const INA226_Adapt *ad);
+float INA226_AdaptNoiseFloor(const INA226_Adapt *ad);
+
 
 #endif // __INA226_H
@@ -0,0 +1,240 @@
+#include "INA226_esp.h"
+
+#include "esp_attr.h"
+#include <string.h>
+
+/* ms → tick，tick 频率低时（如 100Hz 下 5ms）不为 0，否则等待退化为不阻塞 */
+#define ESP_TICKS(ms)   (pdMS_TO_TICKS(ms) ? pdMS_TO_TICKS(ms) : 1)
+
+
+/* ------------------------------------------------------------------
+  ESP-IDF i2c_master 异步后端
+
+  所有传输先放入 ring，再交给驱动排队；驱动按提交顺序完成，
+  on_trans_done 回调总是对应 ring 的队尾。
+  - 同步读写：提交后在信号量上等待，等待上限 = 超时 ×（排在前面的传输数 + 1），
+    超时则复位总线并丢弃未完成传输，保证调用方不会无限阻塞
+  - 每次复位总线代号加 1 并清空 ring，回调不会再到来的旧传输不会永久占着槽位；
+    ring 为空时到来的迟到回调直接丢弃
+  - 异步读：INA226_EspBus_ReadAsync 立即返回，结果由回调投递到 done 队列，
+    采样任务用 INA226_EspBus_Collect 取回
+	 ------------------------------------------------------------------ */
+static bool IRAM_ATTR esp_on_trans_done(i2c_master_dev_handle_t dev,
+                                        const i2c_master_event_data_t *evt, void *arg)
+{
+    INA226_EspCtx *c = (INA226_EspCtx *)arg;
+    BaseType_t woken = pdFALSE;
+    (void)dev;
+
+    if (c->tail == c->head) return false;       // 复位时已清空 ring，迟到的回调
+
+    INA226_EspXfer *x = &c->ring[c->tail % INA226_ESP_QUEUE_DEPTH];
+    if (x->gen != c->gen) {                     // 复位前提交的传输
+        c->stale++;
+        c->tail++;
+        return false;
+    }
+    int8_t st = (evt->event == I2C_EVENT_DONE) ? 0 : -1;
+    if (st) c->errors++;
+
+    if (x->async) {
+        INA226_EspDone d;
+        d.tag    = x->tag;
+        d.addr   = x->addr;
+        d.reg    = x->reg;
+        d.status = st;
+        d.value  = ((uint16_t)x->rx[0] << 8) | x->rx[1];
+        if (xQueueSendFromISR(c->done_q, &d, &woken) != pdTRUE) c->dropped++;
+        c->tail++;
+    } else {
+        x->status = st;
+        c->tail++;
+        xSemaphoreGiveFromISR(c->sync_done, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+/* 按地址取设备句柄，首次使用时挂到总线并注册完成回调 */
+static i2c_master_dev_handle_t esp_dev(INA226_EspCtx *c, uint8_t addr)
+{
+    for (uint8_t i = 0; i < c->dev_count; i++) {
+        if (c->dev[i].addr == addr) return c->dev[i].handle;
+    }
+    if (c->dev_count >= INA226_ESP_MAX_DEV) return NULL;
+
+    i2c_device_config_t cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address  = addr,
+        .scl_speed_hz    = c->scl_hz,
+    };
+    i2c_master_dev_handle_t h;
+    if (i2c_master_bus_add_device(c->bus, &cfg, &h) != ESP_OK) return NULL;
+
+    i2c_master_event_callbacks_t cbs = { .on_trans_done = esp_on_trans_done };
+    if (i2c_master_register_event_callbacks(h, &cbs, c) != ESP_OK) {
+        i2c_master_bus_rm_device(h);
+        return NULL;
+    }
+    c->dev[c->dev_count].addr   = addr;
+    c->dev[c->dev_count].handle = h;
+    c->dev_count++;
+    return h;
+}
+
+/* 占用一个 ring 槽位，队列满返回 NULL（调用方持有 lock） */
+static INA226_EspXfer *esp_reserve(INA226_EspCtx *c)
+{
+    if (c->head - c->tail >= INA226_ESP_QUEUE_DEPTH) return NULL;
+    return &c->ring[c->head % INA226_ESP_QUEUE_DEPTH];
+}
+
+static esp_err_t esp_submit(INA226_EspCtx *c, i2c_master_dev_handle_t h, INA226_EspXfer *x)
+{
+    esp_err_t err;
+    x->gen = c->gen;
+    c->head++;
+    if (x->write) err = i2c_master_transmit(h, x->tx, 3, c->timeout_ms);
+    else          err = i2c_master_transmit_receive(h, &x->reg, 1, x->rx, 2, c->timeout_ms);
+    if (err != ESP_OK) c->head--;               // 驱动未接收，回收槽位
+    return err;
+}
+
+/* 超时：复位总线，丢弃所有未完成传输（调用方持有 lock）
+   代号先加 1，此后到来的旧传输回调都会被丢弃，ring 一律清空。
+   驱动未能在超时内排空时，旧传输的回调可能永远不会到来，不能指望它们释放槽位：
+   此时再清空 done 队列，复位前的异步结果一并作废 */
+static void esp_recover(INA226_EspCtx *c)
+{
+    c->timeouts++;
+    c->gen++;
+    i2c_master_bus_reset(c->bus);
+    if (i2c_master_bus_wait_all_done(c->bus, c->timeout_ms) != ESP_OK) {
+        xQueueReset(c->done_q);
+    }
+    c->tail = c->head;
+    xSemaphoreTake(c->sync_done, 0);
+}
+
+static int esp_sync(INA226_EspCtx *c, uint8_t addr, INA226_EspXfer *tmpl, uint16_t *value)
+{
+    int ret = -1;
+    if (xSemaphoreTake(c->lock, ESP_TICKS(c->timeout_ms)) != pdTRUE) return -1;
+
+    i2c_master_dev_handle_t h = esp_dev(c, addr);
+    INA226_EspXfer *x = esp_reserve(c);
+    if (h != NULL && x != NULL) {
+        uint32_t ahead = c->head - c->tail;
+        *x = *tmpl;
+        x->status = -1;
+        if (esp_submit(c, h, x) == ESP_OK) {
+            TickType_t wait = pdMS_TO_TICKS(c->timeout_ms * (ahead + 1)) + 1;
+            if (xSemaphoreTake(c->sync_done, wait) == pdTRUE) {
+                ret = x->status;
+                if (ret == 0 && value) *value = ((uint16_t)x->rx[0] << 8) | x->rx[1];
+            } else {
+                esp_recover(c);
+            }
+        }
+    }
+    xSemaphoreGive(c->lock);
+    return ret;
+}
+
+static int esp_write_reg(void *ctx, uint8_t addr, uint8_t reg, uint16_t value)
+{
+    INA226_EspXfer t = {0};
+    t.addr  = addr;
+    t.reg   = reg;
+    t.write = 1;
+    t.tx[0] = reg;
+    t.tx[1] = (uint8_t)(value >> 8);
+    t.tx[2] = (uint8_t)(value & 0xFF);
+    return esp_sync((INA226_EspCtx *)ctx, addr, &t, NULL);
+}
+
+static int esp_read_reg(void *ctx, uint8_t addr, uint8_t reg, uint16_t *value)
+{
+    INA226_EspXfer t = {0};
+    t.addr = addr;
+    t.reg  = reg;
+    return esp_sync((INA226_EspCtx *)ctx, addr, &t, value);
+}
+
+static int esp_probe(void *ctx, uint8_t addr)
+{
+    INA226_EspCtx *c = (INA226_EspCtx *)ctx;
+    int ret = -1;
+    if (xSemaphoreTake(c->lock, ESP_TICKS(c->timeout_ms)) != pdTRUE) return -1;
+    /* probe 为阻塞操作，先等排队传输结束 */
+    if (i2c_master_bus_wait_all_done(c->bus, c->timeout_ms * INA226_ESP_QUEUE_DEPTH) == ESP_OK) {
+        ret = (i2c_master_probe(c->bus, addr, c->timeout_ms) == ESP_OK) ? 0 : -1;
+    } else {
+        esp_recover(c);
+    }
+    xSemaphoreGive(c->lock);
+    return ret;
+}
+
+
+/* ------------------------------------------------------------------
+  对外API
+	 ------------------------------------------------------------------ */
+/**
+ * @brief 初始化 ESP-IDF 传输层
+ * @param handle 已创建的 i2c_master 总线（trans_queue_depth = INA226_ESP_QUEUE_DEPTH）
+ * @param scl_hz 设备时钟，INA226 最高 400k（高速模式 2.94M）
+ * @param timeout_ms 单次传输超时，0 使用 INA226_I2C_TIMEOUT_MS
+ * @return 0 成功，-1 资源创建失败
+ */
+int INA226_BusESP_Init(INA226_Bus *bus, INA226_EspCtx *ctx, i2c_master_bus_handle_t handle,
+                       uint32_t scl_hz, uint32_t timeout_ms)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->bus        = handle;
+    ctx->scl_hz     = scl_hz;
+    ctx->timeout_ms = timeout_ms ? timeout_ms : INA226_I2C_TIMEOUT_MS;
+    ctx->lock       = xSemaphoreCreateMutex();
+    ctx->sync_done  = xSemaphoreCreateBinary();
+    ctx->done_q     = xQueueCreate(INA226_ESP_DONE_DEPTH, sizeof(INA226_EspDone));
+    if (!ctx->lock || !ctx->sync_done || !ctx->done_q) return -1;
+
+    bus->write_reg = esp_write_reg;
+    bus->read_reg  = esp_read_reg;
+    bus->probe     = esp_probe;
+    bus->ctx       = ctx;
+    return 0;
+}
+
+/**
+ * @brief 提交一次异步寄存器读，立即返回
+ * @param tag 用户标签，原样出现在完成结果中（如设备序号 << 8 | 寄存器）
+ * @return 0 已提交，-1 队列满或驱动拒绝
+ */
+int INA226_EspBus_ReadAsync(INA226_EspCtx *ctx, uint8_t addr, uint8_t reg, uint32_t tag)
+{
+    int ret = -1;
+    if (xSemaphoreTake(ctx->lock, 0) != pdTRUE) return -1;
+
+    i2c_master_dev_handle_t h = esp_dev(ctx, addr);
+    INA226_EspXfer *x = esp_reserve(ctx);
+    if (h != NULL && x != NULL) {
+        memset(x, 0, sizeof(*x));
+        x->addr  = addr;
+        x->reg   = reg;
+        x->async = 1;
+        x->tag   = tag;
+        ret = (esp_submit(ctx, h, x) == ESP_OK) ? 0 : -1;
+    }
+    xSemaphoreGive(ctx->lock);
+    return ret;
+}
+
+/**
+ * @brief 取回一个异步读结果
+ * @param wait_ms 最长等待时间，0 不等待
+ * @return 1 取到结果，0 无结果
+ */
+int INA226_EspBus_Collect(INA226_EspCtx *ctx, INA226_EspDone *out, uint32_t wait_ms)
+{
+    return xQueueReceive(ctx->done_q, out, wait_ms ? ESP_TICKS(wait_ms) : 0) == pdTRUE;
+}
@@ -0,0 +1,76 @@
+#ifndef __INA226_ESP_H
+#define __INA226_ESP_H
+
+#include "INA226.h"
+#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+
+/* ESP-IDF i2c_master 异步后端
+   创建总线时需设置 i2c_master_bus_config_t.trans_queue_depth = INA226_ESP_QUEUE_DEPTH，
+   驱动进入异步模式：传输入队后立即返回，完成时在中断中回调 */
+#ifndef INA226_ESP_QUEUE_DEPTH
+#define INA226_ESP_QUEUE_DEPTH    8
+#endif
+#ifndef INA226_ESP_MAX_DEV
+#define INA226_ESP_MAX_DEV        8
+#endif
+#ifndef INA226_ESP_DONE_DEPTH
+#define INA226_ESP_DONE_DEPTH     16
+#endif
+
+/* 一次排队中的传输 */
+typedef struct {
+    uint8_t  addr;
+    uint8_t  reg;
+    uint8_t  async;             // 1: 完成后投递到 done 队列；0: 同步等待者
+    uint8_t  write;
+    uint8_t  gen;               // 提交时的总线代号，与 ctx->gen 不符的完成回调被丢弃
+    uint8_t  tx[3];
+    uint8_t  rx[2];
+    int8_t   status;            // 0 成功，-1 失败（同步传输由回调写入）
+    uint32_t tag;               // 异步读用户标签
+} INA226_EspXfer;
+
+/* 异步读完成结果 */
+typedef struct {
+    uint32_t tag;
+    uint8_t  addr;
+    uint8_t  reg;
+    int8_t   status;            // 0 成功，-1 NACK/失败
+    uint16_t value;
+} INA226_EspDone;
+
+typedef struct {
+    i2c_master_bus_handle_t bus;
+    uint32_t scl_hz;
+    uint32_t timeout_ms;        // 单次传输超时
+    struct {
+        uint8_t                 addr;
+        i2c_master_dev_handle_t handle;
+    } dev[INA226_ESP_MAX_DEV];
+    uint8_t dev_count;
+
+    /* 排队传输 FIFO：任务写 head，完成回调写 tail（驱动按提交顺序完成） */
+    INA226_EspXfer    ring[INA226_ESP_QUEUE_DEPTH];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint8_t  gen;      // 总线代号，每次超时复位加 1
+
+    SemaphoreHandle_t lock;     // 串行化提交
+    SemaphoreHandle_t sync_done;
+    QueueHandle_t     done_q;   // INA226_EspDone
+
+    uint32_t errors;            // NACK / 失败
+    uint32_t timeouts;          // 等待超时（会触发总线复位）
+    uint32_t dropped;           // done 队列满而丢弃的异步结果
+    uint32_t stale;             // 复位前提交、复位后才完成而丢弃的传输
+} INA226_EspCtx;
+
+int  INA226_BusESP_Init(INA226_Bus *bus, INA226_EspCtx *ctx, i2c_master_bus_handle_t handle,
+                        uint32_t scl_hz, uint32_t timeout_ms);
+int  INA226_EspBus_ReadAsync(INA226_EspCtx *ctx, uint8_t addr, uint8_t reg, uint32_t tag);
+int  INA226_EspBus_Collect(INA226_EspCtx *ctx, INA226_EspDone *out, uint32_t wait_ms);
+
+#endif // __INA226_ESP_H
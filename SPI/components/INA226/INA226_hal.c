@@ -0,0 +1,78 @@
+#include "INA226_hal.h"
+#include "i2c.h"
+
+/* 旧接口（只传 dev_addr）在未调用 INA226_SetDefaultBus 时使用的 I2C，与原实现一致 */
+#ifndef INA226_HAL_DEFAULT_I2C
+#define INA226_HAL_DEFAULT_I2C    hi2c2
+#endif
+
+
+/* ------------------------------------------------------------------
+  STM32 HAL 后端
+  HAL 使用 8-bit 地址；每次传输都带超时，总线异常时最多阻塞 timeout_ms
+	 ------------------------------------------------------------------ */
+static int hal_write_reg(void *ctx, uint8_t addr, uint8_t reg, uint16_t value)
+{
+    INA226_HalCtx *c = (INA226_HalCtx *)ctx;
+    uint8_t tx[3];
+    tx[0] = reg;
+    tx[1] = (uint8_t)(value >> 8);
+    tx[2] = (uint8_t)(value & 0xFF);
+
+    if (HAL_I2C_Master_Transmit(c->hi2c, (uint16_t)(addr << 1), tx, sizeof(tx), c->timeout_ms) != HAL_OK) {
+        c->errors++;
+        return -1;
+    }
+    return 0;
+}
+
+static int hal_read_reg(void *ctx, uint8_t addr, uint8_t reg, uint16_t *value)
+{
+    INA226_HalCtx *c = (INA226_HalCtx *)ctx;
+    uint8_t buf[2];
+
+    if (HAL_I2C_Mem_Read(c->hi2c, (uint16_t)(addr << 1), reg, I2C_MEMADD_SIZE_8BIT,
+                         buf, 2, c->timeout_ms) != HAL_OK) {
+        c->errors++;
+        return -1;
+    }
+    *value = ((uint16_t)buf[0] << 8) | buf[1];
+    return 0;
+}
+
+static int hal_probe(void *ctx, uint8_t addr)
+{
+    INA226_HalCtx *c = (INA226_HalCtx *)ctx;
+    return HAL_I2C_IsDeviceReady(c->hi2c, (uint16_t)(addr << 1), 1, c->timeout_ms) == HAL_OK ? 0 : -1;
+}
+
+/**
+ * @brief 初始化 HAL 传输层
+ * @param bus 待填充的总线描述
+ * @param ctx 后端私有数据（需长期有效）
+ * @param hi2c HAL I2C 句柄，如 &hi2c2
+ * @param timeout_ms 单次传输超时，0 使用 INA226_I2C_TIMEOUT_MS
+ */
+void INA226_BusHAL_Init(INA226_Bus *bus, INA226_HalCtx *ctx, I2C_HandleTypeDef *hi2c, uint32_t timeout_ms)
+{
+    ctx->hi2c       = hi2c;
+    ctx->timeout_ms = timeout_ms ? timeout_ms : INA226_I2C_TIMEOUT_MS;
+    ctx->errors     = 0;
+
+    bus->write_reg = hal_write_reg;
+    bus->read_reg  = hal_read_reg;
+    bus->probe     = hal_probe;
+    bus->ctx       = ctx;
+}
+
+/* 旧接口的默认总线：首次使用时在 INA226_HAL_DEFAULT_I2C 上初始化 */
+const INA226_Bus *INA226_BusHAL_Default(void)
+{
+    static INA226_Bus    bus;
+    static INA226_HalCtx ctx;
+
+    if (bus.read_reg == NULL) {
+        INA226_BusHAL_Init(&bus, &ctx, &INA226_HAL_DEFAULT_I2C, 0);
+    }
+    return &bus;
+}
@@ -0,0 +1,17 @@
+#ifndef __INA226_HAL_H
+#define __INA226_HAL_H
+
+#include "INA226.h"
+#include "main.h"
+
+/* STM32 HAL 阻塞式 I2C 后端 */
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    uint32_t           timeout_ms;      // 单次传输超时
+    uint32_t           errors;          // 失败/超时次数
+} INA226_HalCtx;
+
+void INA226_BusHAL_Init(INA226_Bus *bus, INA226_HalCtx *ctx, I2C_HandleTypeDef *hi2c, uint32_t timeout_ms);
+const INA226_Bus *INA226_BusHAL_Default(void);
+
+#endif // __INA226_HAL_H
@@ -0,0 +1,124 @@
+#include "INA226_ring.h"
+
+#include <string.h>
+
+
+#define RING_MASK   (INA226_RING_LEN - 1U)
+
+/* 编号越界或未注册（如 AddConsumer 返回的 -1）的消费者一律视为空 */
+#define RING_VALID(r, id)   ((id) >= 0 && (id) < INA226_RING_MAX_CONSUMERS && (r)->cursor[(id)].active)
+
+/* head 的发布/读取顺序：生产者先写样本再 release 发布，消费者 acquire 读取 head 后再读样本 */
+#define RING_LOAD_ACQ(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RING_STORE_REL(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+
+/* ------------------------------------------------------------------
+  对外API
+	 ------------------------------------------------------------------ */
+void INA226_RingInit(INA226_Ring *r)
+{
+    memset(r, 0, sizeof(*r));
+}
+
+/**
+ * @brief 注册一个消费者，从当前最新位置开始读取
+ * @return 消费者编号；-1 已满
+ */
+int INA226_RingAddConsumer(INA226_Ring *r)
+{
+    for (int i = 0; i < INA226_RING_MAX_CONSUMERS; i++) {
+        INA226_RingCursor *c = &r->cursor[i];
+        if (c->active) continue;
+        c->tail    = RING_LOAD_ACQ(&r->head);
+        c->overrun = 0;
+        c->read    = 0;
+        c->active  = 1;
+        return i;
+    }
+    return -1;
+}
+
+void INA226_RingRemoveConsumer(INA226_Ring *r, int id)
+{
+    if (RING_VALID(r, id)) r->cursor[id].active = 0;
+}
+
+/* 生产者：写入一个样本，永不阻塞（只能由一个任务或中断调用） */
+void INA226_RingPush(INA226_Ring *r, const INA226_Snapshot *snap, uint8_t dev)
+{
+    uint32_t h = r->head;
+    INA226_RingItem *it = &r->item[h & RING_MASK];
+
+    it->snap = *snap;
+    it->dev  = dev;
+    RING_STORE_REL(&r->head, h + 1U);
+}
+
+/* INA226_SampleSink 形式的生产者入口，设备号为管理器槽位号 */
+void INA226_RingSink(void *ring, const INA226_Snapshot *snap, uint8_t idx)
+{
+    INA226_RingPush((INA226_Ring *)ring, snap, idx);
+}
+
+/**
+ * @brief 消费者批量读取
+ *
+ * 先按读取前的 head 复制，复制完再检查一次 head：
+ * 生产者在复制期间可能已覆盖最旧的几个槽位（含正在写入、尚未发布的那一个），
+ * 这些样本丢弃并计入 overrun，返回的样本保证完整。
+ *
+ * @param max 最多读取数量
+ * @return 实际读到的样本数；id 无效时为 0
+ */
+uint32_t INA226_RingRead(INA226_Ring *r, int id, INA226_RingItem *out, uint32_t max)
+{
+    if (!RING_VALID(r, id)) return 0;
+
+    INA226_RingCursor *c = &r->cursor[id];
+    uint32_t h = RING_LOAD_ACQ(&r->head);
+    uint32_t t = c->tail;
+
+    if (h - t > INA226_RING_LEN) {                  // 已被整圈覆盖
+        c->overrun += h - t - INA226_RING_LEN;
+        t = h - INA226_RING_LEN;
+    }
+
+    uint32_t n = h - t;
+    if (n > max) n = max;
+
+    for (uint32_t k = 0; k < n; k++) {
+        out[k] = r->item[(t + k) & RING_MASK];
+    }
+
+    /* 复制后再确认：序号 <= h2 - LEN 的槽位可能已被改写（fence 保证复制先于再次读取 head） */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint32_t h2 = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    uint32_t first_ok = h2 + 1U - INA226_RING_LEN;
+    if ((int32_t)(first_ok - t) > 0) {
+        uint32_t bad = first_ok - t;
+        if (bad > n) bad = n;
+        memmove(out, out + bad, (n - bad) * sizeof(*out));
+        c->overrun += bad;
+        t += bad;
+        n -= bad;
+    }
+
+    c->tail  = t + n;
+    c->read += n;
+    return n;
+}
+
+/* 该消费者待读样本数（不超过缓冲长度）；id 无效时为 0 */
+uint32_t INA226_RingAvailable(const INA226_Ring *r, int id)
+{
+    if (!RING_VALID(r, id)) return 0;
+    uint32_t n = RING_LOAD_ACQ(&r->head) - r->cursor[id].tail;
+    return n > INA226_RING_LEN ? INA226_RING_LEN : n;
+}
+
+uint32_t INA226_RingOverrun(const INA226_Ring *r, int id)
+{
+    if (!RING_VALID(r, id)) return 0;
+    return r->cursor[id].overrun;
+}
@@ -0,0 +1,57 @@
+#ifndef __INA226_RING_H
+#define __INA226_RING_H
+
+#include "INA226.h"
+
+/* ------------------------------------------------------------------
+  采样环形缓冲：单生产者（采样任务/中断）+ 多消费者（界面、记录、统计）
+  生产者从不等待：缓冲满时直接覆盖最旧样本，落后的消费者各自统计丢失数量。
+  最旧的槽位随时可能正被生产者改写，消费者最多落后 INA226_RING_LEN - 1 个样本而不丢失。
+  无锁：生产者只写 head，每个消费者只写自己的游标。
+  接法：INA226_MgrSetSink(&mgr, INA226_RingSink, &ring)，MgrPoll 的每个读数即写入环中
+	 ------------------------------------------------------------------ */
+#ifndef INA226_RING_LEN
+#define INA226_RING_LEN           64        // 必须为 2 的幂
+#endif
+#ifndef INA226_RING_MAX_CONSUMERS
+#define INA226_RING_MAX_CONSUMERS 4
+#endif
+#ifndef INA226_RING_CACHELINE
+#define INA226_RING_CACHELINE     32
+#endif
+
+#if (INA226_RING_LEN & (INA226_RING_LEN - 1)) != 0
+#error "INA226_RING_LEN must be a power of two"
+#endif
+
+#define INA226_RING_ALIGNED       __attribute__((aligned(INA226_RING_CACHELINE)))
+
+typedef struct {
+    INA226_Snapshot snap;
+    uint8_t         dev;            // 来源设备（如管理器槽位号）
+} INA226_RingItem;
+
+/* 每个消费者独占一个缓存行，避免与生产者/其他消费者伪共享 */
+typedef struct {
+    uint32_t tail;                  // 下一个要读的样本序号（单调递增）
+    uint32_t overrun;               // 因读取过慢被覆盖而丢失的样本数
+    uint32_t read;                  // 已读样本数
+    uint8_t  active;
+} INA226_RING_ALIGNED INA226_RingCursor;
+
+typedef struct {
+    INA226_RingItem   item[INA226_RING_LEN];
+    INA226_RING_ALIGNED volatile uint32_t head;     // 已发布的样本总数
+    INA226_RingCursor cursor[INA226_RING_MAX_CONSUMERS];
+} INA226_Ring;
+
+void     INA226_RingInit(INA226_Ring *r);
+int      INA226_RingAddConsumer(INA226_Ring *r);
+void     INA226_RingRemoveConsumer(INA226_Ring *r, int id);
+void     INA226_RingPush(INA226_Ring *r, const INA226_Snapshot *snap, uint8_t dev);
+void     INA226_RingSink(void *ring, const INA226_Snapshot *snap, uint8_t idx);
+uint32_t INA226_RingRead(INA226_Ring *r, int id, INA226_RingItem *out, uint32_t max);
+uint32_t INA226_RingAvailable(const INA226_Ring *r, int id);
+uint32_t INA226_RingOverrun(const INA226_Ring *r, int id);
+
+#endif // __INA226_RING_H
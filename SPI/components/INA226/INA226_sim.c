@@ -0,0 +1,458 @@
+#include "INA226_sim.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* ------------------------------------------------------------------
+  芯片时序与换算常数（datasheet SBOS547）
+	 ------------------------------------------------------------------ */
+#define SIM_CONFIG_RESET    0x4127          // AVG=1, VBUSCT=VSHCT=1.1ms, 连续 Shunt+Bus
+#define SIM_MASK_WRITABLE   0xFC03          // SOL..CNVR, APOL, LEN
+#define SIM_SHUNT_LSB_V     2.5e-6
+#define SIM_BUS_LSB_V       1.25e-3
+
+static const uint16_t SIM_CT_US[8]  = { 140, 204, 332, 588, 1100, 2116, 4156, 8244 };
+static const uint16_t SIM_AVG_N[8]  = { 1, 4, 16, 64, 128, 256, 512, 1024 };
+
+/* 读数间隔过长时只完整计算最后几次转换，其余只计数 */
+#define SIM_MAX_CATCHUP     4
+
+
+/* ------------------------------------------------------------------
+  仿真时钟
+	 ------------------------------------------------------------------ */
+static uint64_t sim_now_us = 0;
+
+uint64_t INA226_SimClock_Now(void)            { return sim_now_us; }
+void     INA226_SimClock_Set(uint64_t t_us)   { sim_now_us = t_us; }
+void     INA226_SimClock_Advance(uint64_t us) { sim_now_us += us; }
+void     INA226_SimClock_Delay(uint32_t ms)   { sim_now_us += (uint64_t)ms * 1000U; }
+
+
+/* ------------------------------------------------------------------
+  内部：噪声、转换
+	 ------------------------------------------------------------------ */
+/* xorshift32，返回 [-1, 1) 均匀分布 */
+static float sim_rand(INA226_Sim *s)
+{
+    uint32_t x = s->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s->rng = x;
+    return (float)((int32_t)x) * (1.0f / 2147483648.0f);
+}
+
+static uint8_t sim_mode(const INA226_Sim *s)   { return (uint8_t)(s->reg_config & 0x7); }
+
+/* 一次完整转换（含平均）所需时间（μs） */
+static uint32_t sim_period_us(const INA226_Sim *s)
+{
+    uint8_t  mode = sim_mode(s) & 0x3;
+    uint32_t ct   = 0;
+    if (mode & 0x1) ct += SIM_CT_US[(s->reg_config >> 3) & 0x7];
+    if (mode & 0x2) ct += SIM_CT_US[(s->reg_config >> 6) & 0x7];
+    ct *= SIM_AVG_N[(s->reg_config >> 9) & 0x7];
+    return (uint32_t)(((int64_t)ct * (1000 + s->clock_permille)) / 1000);
+}
+
+static void sim_input(INA226_Sim *s, uint64_t t, float *i_a, float *v_bus)
+{
+    *i_a = 0.0f;
+    *v_bus = 0.0f;
+    if (s->source) s->source(s->source_arg, t, i_a, v_bus);
+}
+
+/* 按芯片算法更新 CURRENT / POWER：
+   CURRENT = SHUNT × CAL / 2048，POWER = |CURRENT| × BUS / 20000，超出寄存器范围置 OVF */
+static void sim_compute(INA226_Sim *s)
+{
+    int32_t  cur = ((int32_t)s->reg_shunt * (int32_t)s->reg_cal) / 2048;
+    uint32_t pwr;
+
+    s->ovf = 0;
+    if (cur > 32767)  { cur = 32767;  s->ovf = 1; }
+    if (cur < -32768) { cur = -32768; s->ovf = 1; }
+    s->reg_current = (int16_t)cur;
+
+    pwr = ((uint32_t)(cur < 0 ? -cur : cur) * s->reg_bus) / 20000U;
+    if (pwr > 0xFFFF) { pwr = 0xFFFF; s->ovf = 1; }
+    s->reg_power = (uint16_t)pwr;
+}
+
+/* 完成起点为 t0 的一次转换：分流与母线交替采样 AVG 次后取平均、量化 */
+static void sim_convert(INA226_Sim *s, uint64_t t0)
+{
+    uint8_t  mode = sim_mode(s) & 0x3;
+    uint32_t n    = SIM_AVG_N[(s->reg_config >> 9) & 0x7];
+    uint32_t ctsh = SIM_CT_US[(s->reg_config >> 3) & 0x7];
+    uint32_t ctbu = SIM_CT_US[(s->reg_config >> 6) & 0x7];
+    double   sh = 0.0, bu = 0.0;
+    uint64_t t = t0;
+    float    i_a, v;
+
+    for (uint32_t k = 0; k < n; k++) {
+        if (mode & 0x1) {
+            sim_input(s, t + ctsh / 2, &i_a, &v);
+            sh += (double)i_a * s->shunt_ohm + s->noise_v * sim_rand(s);
+            t  += ctsh;
+        }
+        if (mode & 0x2) {
+            sim_input(s, t + ctbu / 2, &i_a, &v);
+            bu += (double)v + s->bus_noise_v * sim_rand(s);
+            t  += ctbu;
+        }
+    }
+
+    if (mode & 0x1) {
+        long raw = lround(sh / n / SIM_SHUNT_LSB_V);
+        if (raw > 32767)  raw = 32767;
+        if (raw < -32768) raw = -32768;
+        s->reg_shunt = (int16_t)raw;
+    }
+    if (mode & 0x2) {
+        long raw = lround(bu / n / SIM_BUS_LSB_V);
+        if (raw > 0x7FFF) raw = 0x7FFF;
+        if (raw < 0)      raw = 0;
+        s->reg_bus = (uint16_t)raw;
+    }
+    sim_compute(s);
+}
+
+/* 限值比较：只有最高位的告警功能生效 */
+static uint8_t sim_limit_hit(const INA226_Sim *s)
+{
+    uint16_t f = s->reg_mask & INA226_ME_LIMIT_MASK;
+
+    if (f & INA226_ME_SOL) return s->reg_shunt > (int16_t)s->reg_limit;
+    if (f & INA226_ME_SUL) return s->reg_shunt < (int16_t)s->reg_limit;
+    if (f & INA226_ME_BOL) return s->reg_bus   > s->reg_limit;
+    if (f & INA226_ME_BUL) return s->reg_bus   < s->reg_limit;
+    if (f & INA226_ME_POL) return s->reg_power > s->reg_limit;
+    return 0;
+}
+
+static void sim_set_alert(INA226_Sim *s, uint8_t on)
+{
+    if (on && !s->alert) {
+        s->alert = 1;
+        if (s->on_alert) s->on_alert(s->on_alert_arg);
+    } else if (!on) {
+        s->alert = 0;
+    }
+}
+
+/* 一次转换完成：置 CVRF，按限值更新 AFF；CNVR 或告警功能触发时拉起 ALERT
+   锁存模式下 AFF/ALERT 保持到读 Mask/Enable，透明模式下随比较结果变化 */
+static void sim_complete(INA226_Sim *s)
+{
+    uint8_t hit = sim_limit_hit(s);
+
+    s->conversions++;
+    s->cvrf = 1;
+    if (s->reg_mask & INA226_ME_LEN) s->aff |= hit;
+    else                             s->aff  = hit;
+
+    if ((s->reg_mask & INA226_ME_CNVR) || s->aff) sim_set_alert(s, 1);
+    else if (!(s->reg_mask & INA226_ME_LEN))      sim_set_alert(s, 0);
+}
+
+static void sim_reset(INA226_Sim *s)
+{
+    s->reg_config  = SIM_CONFIG_RESET;
+    s->reg_shunt   = 0;
+    s->reg_bus     = 0;
+    s->reg_power   = 0;
+    s->reg_current = 0;
+    s->reg_cal     = 0;
+    s->reg_mask    = 0;
+    s->reg_limit   = 0;
+    s->cvrf        = 0;
+    s->ovf         = 0;
+    s->aff         = 0;
+    s->alert       = 0;
+    s->busy        = 0;
+    s->conv_start_us = sim_now_us;
+}
+
+
+/* ------------------------------------------------------------------
+  对外API
+	 ------------------------------------------------------------------ */
+void INA226_Sim_Init(INA226_Sim *sim, uint8_t addr, float shunt_ohm)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->addr      = addr;
+    sim->shunt_ohm = shunt_ohm;
+    sim->rng       = 0x12345678U;
+    sim_reset(sim);
+}
+
+void INA226_Sim_SetSource(INA226_Sim *sim, INA226_SimSource src, void *arg)
+{
+    sim->source     = src;
+    sim->source_arg = arg;
+}
+
+void INA226_Sim_SetProfile(INA226_Sim *sim, INA226_SimProfile *profile)
+{
+    INA226_Sim_SetSource(sim, INA226_SimProfile_Sample, profile);
+}
+
+void INA226_Sim_SetNoise(INA226_Sim *sim, float shunt_noise_v, float bus_noise_v, uint32_t seed)
+{
+    sim->noise_v     = shunt_noise_v;
+    sim->bus_noise_v = bus_noise_v;
+    sim->rng         = seed ? seed : 0x12345678U;
+}
+
+/**
+ * @brief 把仿真器推进到当前仿真时钟：完成所有已到期的转换
+ * @note 寄存器访问前会自动调用；需要 ALERT 回调按时触发时，在推进时钟后手动调用
+ */
+void INA226_Sim_Update(INA226_Sim *sim)
+{
+    uint8_t  mode   = sim_mode(sim);
+    uint32_t period = sim_period_us(sim);
+    uint64_t now    = sim_now_us;
+
+    if (period == 0 || (mode & 0x3) == 0) return;       // Power-down / ADC-OFF
+
+    if (mode < 4) {                                     // 触发模式：单次
+        if (sim->busy && sim->conv_start_us + period <= now) {
+            sim_convert(sim, sim->conv_start_us);
+            sim->busy = 0;
+            sim_complete(sim);
+        }
+        return;
+    }
+
+    if (sim->conv_start_us + period > now) return;
+    uint64_t n = (now - sim->conv_start_us) / period;
+    if (n > SIM_MAX_CATCHUP) {                          // 中间结果会被覆盖，只计数
+        uint64_t skip = n - SIM_MAX_CATCHUP;
+        sim->conv_start_us += skip * period;
+        sim->conversions   += (uint32_t)skip;
+        n = SIM_MAX_CATCHUP;
+    }
+    while (n--) {
+        sim_convert(sim, sim->conv_start_us);
+        sim->conv_start_us += period;
+        sim_complete(sim);
+    }
+}
+
+static int sim_write(INA226_Sim *s, uint8_t reg, uint16_t value)
+{
+    INA226_Sim_Update(s);
+    s->writes++;
+
+    switch (reg) {
+    case INA226_REG_CONFIG:
+        if (value & 0x8000) {
+            sim_reset(s);
+            break;
+        }
+        s->reg_config    = (uint16_t)((value & 0x0FFF) | 0x4000);   // 14..12 保留位固定读出 100
+        s->conv_start_us = sim_now_us;                  // 写配置重新开始转换
+        s->busy          = (sim_mode(s) & 0x3) && sim_mode(s) < 4;
+        break;
+    case INA226_REG_CALIBRATION:
+        s->reg_cal = value & 0x7FFF;
+        sim_compute(s);                                 // 校准改变后立即按新值重算
+        break;
+    case INA226_REG_MASK_ENABLE:
+        s->reg_mask = value & SIM_MASK_WRITABLE;
+        break;
+    case INA226_REG_ALERT_LIMIT:
+        s->reg_limit = value;
+        break;
+    default:                                            // 只读寄存器：应答但忽略
+        break;
+    }
+    return 0;
+}
+
+static int sim_read(INA226_Sim *s, uint8_t reg, uint16_t *value)
+{
+    INA226_Sim_Update(s);
+    s->reads++;
+
+    switch (reg) {
+    case INA226_REG_CONFIG:       *value = s->reg_config;             break;
+    case INA226_REG_SHUNTVOLTAGE: *value = (uint16_t)s->reg_shunt;    break;
+    case INA226_REG_BUSVOLTAGE:   *value = s->reg_bus;                break;
+    case INA226_REG_POWER:        *value = s->reg_power;              break;
+    case INA226_REG_CURRENT:      *value = (uint16_t)s->reg_current;  break;
+    case INA226_REG_CALIBRATION:  *value = s->reg_cal;                break;
+    case INA226_REG_MASK_ENABLE:
+        *value = (uint16_t)(s->reg_mask | (s->aff ? INA226_ME_AFF : 0)
+                          | (s->cvrf ? INA226_ME_CVRF : 0) | (s->ovf ? INA226_ME_OVF : 0));
+        s->cvrf = 0;                                    // 读 Mask/Enable 清除 CVRF，释放锁存的 AFF/ALERT
+        if (s->reg_mask & INA226_ME_LEN) s->aff = 0;
+        if (!s->aff) s->alert = 0;
+        break;
+    case INA226_REG_ALERT_LIMIT:  *value = s->reg_limit;              break;
+    case INA226_REG_MANUFACTURER: *value = INA226_MANUFACTURER_ID;    break;
+    case INA226_REG_DIE_ID:       *value = INA226_DIE_ID;             break;
+    default:
+        return -1;
+    }
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  负载曲线
+	 ------------------------------------------------------------------ */
+void INA226_SimProfile_Init(INA226_SimProfile *p, INA226_SimPoint *pts, uint32_t count, uint8_t loop)
+{
+    p->pts   = pts;
+    p->count = count;
+    p->loop  = loop;
+    p->owned = 0;
+}
+
+/**
+ * @brief 从 CSV 文件载入负载曲线
+ * @note 每行 "t_us,current_a,bus_v"，'#' 开头为注释；时间需递增
+ * @return 载入的点数，失败返回 -1
+ */
+int INA226_SimProfile_Load(INA226_SimProfile *p, const char *path, uint8_t loop)
+{
+    FILE *fp = fopen(path, "r");
+    char line[128];
+    uint32_t cap = 0;
+
+    if (fp == NULL) return -1;
+    INA226_SimProfile_Init(p, NULL, 0, loop);
+    p->owned = 1;
+
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long long t;
+        float i_a, v;
+        if (line[0] == '#' || sscanf(line, "%llu,%f,%f", &t, &i_a, &v) != 3) continue;
+        if (p->count == cap) {
+            uint32_t ncap = cap ? cap * 2 : 64;
+            INA226_SimPoint *np = realloc(p->pts, ncap * sizeof(*np));
+            if (np == NULL) {
+                fclose(fp);
+                INA226_SimProfile_Free(p);
+                return -1;
+            }
+            p->pts = np;
+            cap = ncap;
+        }
+        p->pts[p->count].t_us      = t;
+        p->pts[p->count].current_a = i_a;
+        p->pts[p->count].bus_v     = v;
+        p->count++;
+    }
+    fclose(fp);
+    return (int)p->count;
+}
+
+void INA226_SimProfile_Free(INA226_SimProfile *p)
+{
+    if (p->owned) free(p->pts);
+    p->pts   = NULL;
+    p->count = 0;
+    p->owned = 0;
+}
+
+/* INA226_SimSource：二分查找所在区间后线性插值 */
+void INA226_SimProfile_Sample(void *arg, uint64_t t_us, float *current_a, float *bus_v)
+{
+    const INA226_SimProfile *p = (const INA226_SimProfile *)arg;
+    const INA226_SimPoint *a, *b;
+    uint32_t lo = 0, hi;
+
+    if (p->count == 0) return;
+    if (p->loop && p->pts[p->count - 1].t_us > 0) t_us %= p->pts[p->count - 1].t_us;
+
+    if (t_us <= p->pts[0].t_us) {
+        *current_a = p->pts[0].current_a;
+        *bus_v     = p->pts[0].bus_v;
+        return;
+    }
+    if (t_us >= p->pts[p->count - 1].t_us) {
+        *current_a = p->pts[p->count - 1].current_a;
+        *bus_v     = p->pts[p->count - 1].bus_v;
+        return;
+    }
+
+    hi = p->count - 1;                                  // pts[lo].t <= t < pts[hi].t
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (p->pts[mid].t_us <= t_us) lo = mid;
+        else                          hi = mid;
+    }
+    a = &p->pts[lo];
+    b = &p->pts[hi];
+    float f = (float)(t_us - a->t_us) / (float)(b->t_us - a->t_us);
+    *current_a = a->current_a + (b->current_a - a->current_a) * f;
+    *bus_v     = a->bus_v     + (b->bus_v     - a->bus_v)     * f;
+}
+
+
+/* ------------------------------------------------------------------
+  仿真总线（INA226_Bus 后端）
+  按 SCL 频率推进仿真时钟：写 4 字节、读 5 字节（含重复起始），每字节 9 位
+	 ------------------------------------------------------------------ */
+static INA226_Sim *simbus_find(INA226_SimBus *sb, uint8_t addr)
+{
+    for (uint8_t i = 0; i < sb->count; i++) {
+        if (sb->dev[i]->addr == addr) return sb->dev[i];
+    }
+    sb->nack++;
+    return NULL;
+}
+
+static void simbus_xfer(INA226_SimBus *sb, uint32_t bytes)
+{
+    if (sb->scl_hz) sim_now_us += ((uint64_t)bytes * 9U + 2U) * 1000000U / sb->scl_hz;
+}
+
+static int simbus_write_reg(void *ctx, uint8_t addr, uint8_t reg, uint16_t value)
+{
+    INA226_SimBus *sb = (INA226_SimBus *)ctx;
+    INA226_Sim *s = simbus_find(sb, addr);
+    simbus_xfer(sb, 4);
+    return s ? sim_write(s, reg, value) : -1;
+}
+
+static int simbus_read_reg(void *ctx, uint8_t addr, uint8_t reg, uint16_t *value)
+{
+    INA226_SimBus *sb = (INA226_SimBus *)ctx;
+    INA226_Sim *s = simbus_find(sb, addr);
+    simbus_xfer(sb, 5);
+    return s ? sim_read(s, reg, value) : -1;
+}
+
+static int simbus_probe(void *ctx, uint8_t addr)
+{
+    INA226_SimBus *sb = (INA226_SimBus *)ctx;
+    simbus_xfer(sb, 1);
+    return simbus_find(sb, addr) ? 0 : -1;
+}
+
+void INA226_SimBus_Init(INA226_Bus *bus, INA226_SimBus *sb, uint32_t scl_hz)
+{
+    memset(sb, 0, sizeof(*sb));
+    sb->scl_hz = scl_hz;
+
+    bus->write_reg = simbus_write_reg;
+    bus->read_reg  = simbus_read_reg;
+    bus->probe     = simbus_probe;
+    bus->ctx       = sb;
+}
+
+int INA226_SimBus_Attach(INA226_SimBus *sb, INA226_Sim *sim)
+{
+    if (sb->count >= INA226_SIM_MAX_DEV) return -1;
+    sb->dev[sb->count++] = sim;
+    return 0;
+}
@@ -0,0 +1,92 @@
+#ifndef __INA226_SIM_H
+#define __INA226_SIM_H
+
+#include "INA226.h"
+
+/* ------------------------------------------------------------------
+  INA226 主机端仿真器（寄存器级）
+  挂在 INA226_Bus 传输层下，驱动/调度/滤波/能量统计代码无需改动即可在 Linux 上运行。
+  编译时定义 INA226_SIM_HOST，INA226_TIMESTAMP_US / INA226_DELAY_MS 改用仿真时钟。
+	 ------------------------------------------------------------------ */
+#ifndef INA226_SIM_MAX_DEV
+#define INA226_SIM_MAX_DEV        8
+#endif
+
+/* 负载曲线点：相邻两点之间线性插值 */
+typedef struct {
+    uint64_t t_us;
+    float    current_a;
+    float    bus_v;
+} INA226_SimPoint;
+
+typedef struct {
+    INA226_SimPoint *pts;
+    uint32_t         count;
+    uint8_t          loop;          // 1: 到末尾后从头循环
+    uint8_t          owned;         // 1: pts 由 INA226_SimProfile_Load 分配
+} INA226_SimProfile;
+
+/* 模拟量输入源：给出 t_us 时刻的分流电流与母线电压，默认为负载曲线插值 */
+typedef void (*INA226_SimSource)(void *arg, uint64_t t_us, float *current_a, float *bus_v);
+
+typedef struct {
+    uint8_t  addr;
+    uint16_t reg_config;
+    int16_t  reg_shunt;
+    uint16_t reg_bus;
+    uint16_t reg_power;
+    int16_t  reg_current;
+    uint16_t reg_cal;
+    uint16_t reg_mask;              // 只保存可写位（15..10, 1, 0）
+    uint16_t reg_limit;
+    uint8_t  cvrf;                  // 转换完成标志，读 Mask/Enable 清除
+    uint8_t  ovf;                   // 功率/电流运算溢出
+    uint8_t  aff;                   // 限值告警标志
+    uint8_t  alert;                 // ALERT 引脚是否有效（逻辑电平，不含极性）
+
+    float    shunt_ohm;             // 物理分流电阻
+    float    noise_v;               // 分流电压噪声幅度（V，均匀分布 ±）
+    float    bus_noise_v;           // 母线电压噪声幅度
+    uint32_t rng;
+
+    INA226_SimSource source;
+    void            *source_arg;
+    void (*on_alert)(void *arg);    // ALERT 有效沿回调，可直接接 INA226_AlertISR
+    void  *on_alert_arg;
+
+    int16_t  clock_permille;        // 芯片时基误差（‰，正值偏慢），手册约 ±100
+    uint64_t conv_start_us;         // 当前转换周期起点
+    uint8_t  busy;                  // 触发模式下转换进行中
+    uint32_t conversions;           // 已完成的转换周期数
+    uint32_t reads;
+    uint32_t writes;
+} INA226_Sim;
+
+typedef struct {
+    INA226_Sim *dev[INA226_SIM_MAX_DEV];
+    uint8_t     count;
+    uint32_t    scl_hz;             // 用于推算传输耗时，0 表示传输不耗时
+    uint32_t    nack;
+} INA226_SimBus;
+
+/* 仿真时钟 */
+uint64_t INA226_SimClock_Now(void);
+void     INA226_SimClock_Set(uint64_t t_us);
+void     INA226_SimClock_Advance(uint64_t us);
+void     INA226_SimClock_Delay(uint32_t ms);
+
+void INA226_Sim_Init(INA226_Sim *sim, uint8_t addr, float shunt_ohm);
+void INA226_Sim_SetSource(INA226_Sim *sim, INA226_SimSource src, void *arg);
+void INA226_Sim_SetProfile(INA226_Sim *sim, INA226_SimProfile *profile);
+void INA226_Sim_SetNoise(INA226_Sim *sim, float shunt_noise_v, float bus_noise_v, uint32_t seed);
+void INA226_Sim_Update(INA226_Sim *sim);
+
+void INA226_SimProfile_Init(INA226_SimProfile *p, INA226_SimPoint *pts, uint32_t count, uint8_t loop);
+int  INA226_SimProfile_Load(INA226_SimProfile *p, const char *path, uint8_t loop);
+void INA226_SimProfile_Free(INA226_SimProfile *p);
+void INA226_SimProfile_Sample(void *arg, uint64_t t_us, float *current_a, float *bus_v);
+
+void INA226_SimBus_Init(INA226_Bus *bus, INA226_SimBus *sb, uint32_t scl_hz);
+int  INA226_SimBus_Attach(INA226_SimBus *sb, INA226_Sim *sim);
+
+#endif // __INA226_SIM_H
@@ -0,0 +1,54 @@
+#ifndef __INA226_HOST_H
+#define __INA226_HOST_H
+
+#include "INA226_sim.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+/* ------------------------------------------------------------------
+  主机端场景的公共部分：断言宏、单设备环境、各文件导出的场景
+	 ------------------------------------------------------------------ */
+#define CHECK(cond, ...)  do { if (!(cond)) { printf("    FAIL: " __VA_ARGS__); printf("\n"); return 1; } } while (0)
+
+/* 单设备 + 管理器的公共环境 */
+typedef struct {
+    INA226_Bus        bus;
+    INA226_SimBus     sb;
+    INA226_Sim        sim;
+    INA226_SimProfile prof;
+    INA226_Manager    m;
+} HostRig;
+
+void RigInit(HostRig *r, INA226_SimPoint *pts, uint32_t n);
+
+typedef struct {
+    const char *name;
+    int (*run)(void);
+} HostScenario;
+
+/* host_function.c：仿真读数经 function.c 的滤波 / 统计 / 能量累计 */
+int Scenario_SimFilter(void);
+int Scenario_SimStats(void);
+int Scenario_SimEnergy(void);
+
+/* host_bench.c：function.c 中 FUNCTION_BENCH 的基准与自检 */
+int Scenario_BenchFilterBlock(void);
+int Scenario_BenchPipeline(void);
+int Scenario_BenchNtc(void);
+int Scenario_BenchFormat(void);
+int Scenario_StatsLongRun(void);
+
+/* host_ring.c：采样环并发压力与 管理器 → 环 → 消费者 链路 */
+int Scenario_RingStress(void);
+int Scenario_RingPipeline(void);
+
+/* host_algo.c：function.c 算法对照参考实现或解析值 */
+int Scenario_MedianVsSort(void);
+int Scenario_WhLongRun(void);
+int Scenario_FanStall(void);
+int Scenario_ClockLongRun(void);
+int Scenario_CalVsScan(void);
+int Scenario_CalFitPersist(void);
+
+#endif // __INA226_HOST_H
@@ -0,0 +1,363 @@
+/* ------------------------------------------------------------------
+  function.c 算法核对（不经仿真器）
+  对照一个直接、显然正确的参考实现逐样本比较，或对照解析值长时间运行
+   ------------------------------------------------------------------ */
+#include "host.h"
+#include "function.h"
+#include <stdlib.h>
+
+/* xorshift32：各场景可复现的伪随机序列 */
+static uint32_t HostRand(uint32_t *s)
+{
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+static int HostCmpFloat(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+
+/* ------------------------------------------------------------------
+  滑动中值：窗口 1~63，每个窗口 20000 个样本，逐个与「复制窗口 + 排序」的参考中值比较。
+  样本取 0.0~99.9 的 0.1 步进，重复值很多，覆盖相等元素在两堆之间的交换
+   ------------------------------------------------------------------ */
+#define MEDIAN_CHECK_N  20000u
+
+int Scenario_MedianVsSort(void)
+{
+    static float hist[MEDIAN_CHECK_N];
+    float ref[SMEDIAN_MAX_WINDOW];
+    SlidingMedian m;
+    uint32_t seed = 0x1234567u, checked = 0;
+
+    for (uint8_t w = 1; w <= SMEDIAN_MAX_WINDOW; w++) {
+        CHECK(SlidingMedianInit(&m, w) == 0, "init window %u", w);
+        for (uint32_t i = 0; i < MEDIAN_CHECK_N; i++) {
+            hist[i] = (float)(HostRand(&seed) % 1000u) * 0.1f;
+            float got = SlidingMedianUpdate(&m, hist[i]);
+
+            uint32_t n = (i + 1 < w) ? i + 1 : w;
+            memcpy(ref, &hist[i + 1 - n], n * sizeof(float));
+            qsort(ref, n, sizeof(float), HostCmpFloat);
+            float want = (n & 1) ? ref[n / 2] : 0.5f * (ref[n / 2 - 1] + ref[n / 2]);
+            CHECK(got == want, "window %u sample %u: %.2f, sorted %.2f", w, i, got, want);
+            checked++;
+        }
+    }
+    printf("    windows 1..%u, %u medians identical to the sorted reference\n", SMEDIAN_MAX_WINDOW, checked);
+    CHECK(SlidingMedianInit(&m, 0) != 0 && SlidingMedianInit(&m, SMEDIAN_MAX_WINDOW + 1) != 0, "window range not checked");
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  长时间能量累计：100 h，10 Hz。
+  - calc_wh 恒定 0.4321 W，理论 43.21 Wh；同时按旧实现（float 总量 += P·Δh）累计作对比
+  - EnergyAcc 电流 0 → 1.8 A → 0 三角波（周期 120 s，样本落在折线上，梯形积分无截断误差），
+    12 V，理论 0.9 A × 360000 s，电荷与能量都应与解析值逐 μA·s 相等
+   ------------------------------------------------------------------ */
+#define WH_RUN_MS       (100ULL * 3600 * 1000)
+#define WH_STEP_MS      100u
+#define WH_TRI_STEP_UA  3000                    // 每 100 ms 变化量
+#define WH_TRI_HALF     600                     // 半周期样本数：600 × 3000 μA = 1.8 A
+
+int Scenario_WhLongRun(void)
+{
+    EnergyAcc acc;
+    EnergySnapshot es;
+    float wh = 0.0f, old_wh = 0.0f;
+    uint32_t k = 0;
+
+    EnergyAccInit(&acc);
+    for (uint64_t t = WH_STEP_MS; t <= WH_RUN_MS + WH_STEP_MS; t += WH_STEP_MS, k++) {
+        wh = calc_wh(t, 0.4321f);
+        if (t > WH_STEP_MS) old_wh += 0.4321f * ((float)WH_STEP_MS / 3600000.0f);
+
+        uint32_t ph = k % (2 * WH_TRI_HALF);
+        int32_t ua = WH_TRI_STEP_UA * (int32_t)(ph <= WH_TRI_HALF ? ph : 2 * WH_TRI_HALF - ph);
+        EnergyAccFeed(&acc, (t - WH_STEP_MS) * 1000ULL, ua, (int64_t)ua * 12);
+    }
+    EnergyAccSnapshot(&acc, &es);
+
+    const int64_t uas_ref = 900000LL * 360000;
+    printf("    calc_wh %.5f Wh (old float sum %.5f, ref 43.21000); triangle %lld uA*s (ref %lld), %.4f Wh\n",
+           wh, old_wh, (long long)es.uas, (long long)uas_ref, EnergyAccWattHours(&es));
+    CHECK(fabsf(wh - 43.21f) < 1e-5f, "calc_wh %.6f Wh", wh);
+    CHECK(es.elapsed_us == WH_RUN_MS * 1000ULL, "elapsed");
+    CHECK(es.uas == uas_ref, "charge drifted by %lld uA*s", (long long)(es.uas - uas_ref));
+    CHECK(es.uws == uas_ref * 12, "energy drifted by %lld uW*s", (long long)(es.uws - uas_ref * 12));
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  风扇堵转判定：默认曲线，80 °C（满占空比），每 20 ms 调用一次，2 脉冲/转，
+  stall_rpm 300、stall_ms 200（短于 500 ms 测速周期）、stall_min_pwm 20。
+  - 2000 rpm 正常风扇：第一个测速周期之前 rpm 为 0，不应误判
+  - 无脉冲风扇：500 ms 得到第一个转速，再经 200 ms 判为堵转，即 680 ms 那一步
+  - 脉冲恢复后下一个测速周期解除堵转
+   ------------------------------------------------------------------ */
+#define FAN_STEP_MS  20u
+
+/* 按转速注入 dt 内的脉冲，小数部分留到下次 */
+static void FanSpin(FanCtrl *f, float rpm, uint32_t dt_ms, float *frac)
+{
+    *frac += rpm * (float)f->pulses_per_rev * (float)dt_ms / 60000.0f;
+    while (*frac >= 1.0f) { FanCtrlTachISR(f); *frac -= 1.0f; }
+}
+
+int Scenario_FanStall(void)
+{
+    FanCtrl ok, dead;
+    float frac_ok = 0.0f, frac_dead = 0.0f;
+    uint32_t flagged_ms = 0, cleared_ms = 0;
+
+    FanCtrlInitCurve(&ok, NULL, 0);
+    FanCtrlInitCurve(&dead, NULL, 0);
+    FanCtrlSetTach(&ok, 2, 300, 200, 20);
+    FanCtrlSetTach(&dead, 2, 300, 200, 20);
+
+    for (uint32_t t = FAN_STEP_MS; t <= 5000; t += FAN_STEP_MS) {
+        FanSpin(&ok, 2000.0f, FAN_STEP_MS, &frac_ok);
+        if (t > 3000) FanSpin(&dead, 2000.0f, FAN_STEP_MS, &frac_dead);   // 3 s 后重新转起来
+        FanCtrlUpdate(&ok, 80.0f, FAN_STEP_MS);
+        uint8_t duty = FanCtrlUpdate(&dead, 80.0f, FAN_STEP_MS);
+
+        if (dead.stalled && !flagged_ms) {
+            flagged_ms = t;
+            CHECK(duty == dead.curve.pwm_max, "stalled fan not driven at full duty");
+        }
+        if (flagged_ms && !cleared_ms && !dead.stalled) cleared_ms = t;
+    }
+    printf("    healthy fan: %.0f rpm, %u stall events; dead fan flagged at %u ms, cleared at %u ms (pulses resume at 3000 ms)\n",
+           ok.rpm, ok.stall_events, flagged_ms, cleared_ms);
+    CHECK(ok.stall_events == 0 && !ok.stalled, "healthy fan flagged as stalled");
+    CHECK(fabsf(ok.rpm - 2000.0f) < 60.0f, "rpm %.0f", ok.rpm);
+    CHECK(flagged_ms == 680, "dead fan flagged at %u ms", flagged_ms);
+    CHECK(dead.stall_events == 1, "stall events %u", dead.stall_events);
+    CHECK(cleared_ms > 3000 && cleared_ms <= 3500, "stall cleared at %u ms", cleared_ms);
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  增量运行时钟：0 → 400 h，每步前进 1~700 ms（随机），另在 50 h 与 200 h 各阻塞 95 s，
+  覆盖 "HH:MM:SS" 逐字符进位、99:59:59 → "4d04h00m" 切换、天格式按分钟刷新与落后整串重建。
+  每一步 UptimeClock 的文本都应与 FormatTimeString_r 相同，返回值为正当且仅当文本变化
+   ------------------------------------------------------------------ */
+#define CLOCK_RUN_MS  (400ULL * 3600 * 1000)
+
+int Scenario_ClockLongRun(void)
+{
+    UptimeClock c;
+    char ref[FORMAT_TIME_LEN], prev[FORMAT_TIME_LEN];
+    uint32_t seed = 0xC10C4u, steps = 0, stalls = 0;
+    uint64_t now = 0;
+
+    UptimeClockInit(&c, now);
+    while (now < CLOCK_RUN_MS) {
+        uint64_t stall_at[2] = { 50ULL * 3600 * 1000, 200ULL * 3600 * 1000 };
+        uint32_t dt = 1 + HostRand(&seed) % 700u;
+        for (int i = 0; i < 2; i++) {
+            if (now < stall_at[i] && now + dt >= stall_at[i]) { dt += 95000; stalls++; }
+        }
+        now += dt;
+
+        memcpy(prev, c.text, sizeof(prev));
+        int n = UptimeClockUpdate(&c, now);
+        FormatTimeString_r(now, ref, sizeof(ref));
+        CHECK(strcmp(c.text, ref) == 0, "at %llu ms: \"%s\", expected \"%s\"", (unsigned long long)now, c.text, ref);
+        CHECK((n > 0) == (strcmp(prev, c.text) != 0), "at %llu ms: returned %d for \"%s\" -> \"%s\"",
+              (unsigned long long)now, n, prev, c.text);
+        steps++;
+    }
+    printf("    %u updates over 400 h with %u stalls of 95 s, final \"%s\", all identical to FormatTimeString_r\n",
+           steps, stalls, c.text);
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  校准查表：1~32 点的随机表，二分 + 预算斜率的结果与旧的线性扫描（原样保留于此）比较。
+  输入覆盖表外、节点本身、节点两侧相邻的浮点数与随机值；偏移量相邻点差别很大，
+  选错段会产生明显误差，只允许运算次序不同带来的舍入差。
+  未编译的表与 CalibrateBlock（块内连续与乱序两种输入）也应与 CalibrateCurrent 一致
+   ------------------------------------------------------------------ */
+static float CalLinearScan(const CalTable *ct, float raw)
+{
+    const float *points = ct->points;
+    const float *offs   = ct->offsets;
+    int n = ct->num_points;
+
+    if (raw <= points[0])     return raw + offs[0];
+    if (raw >= points[n - 1]) return raw + offs[n - 1];
+    for (int i = 0; i < n - 1; i++) {
+        float x0 = points[i], x1 = points[i + 1];
+        if (raw > x0 && raw <= x1) {
+            float slope = (offs[i + 1] - offs[i]) / (x1 - x0);
+            return raw + (offs[i] + slope * (raw - x0));
+        }
+    }
+    return raw;
+}
+
+#define CAL_CHECK_IN  512
+
+int Scenario_CalVsScan(void)
+{
+    static float in[CAL_CHECK_IN], blk[CAL_CHECK_IN];
+    CalTable ct, raw_ct;
+    uint32_t seed = 0xCA1u, checked = 0;
+    float worst = 0.0f;
+
+    for (int np = 1; np <= MAX_CAL_POINTS; np++) {
+        memset(&ct, 0, sizeof(ct));
+        ct.num_points = np;
+        float x = -2.0f;
+        for (int i = 0; i < np; i++) {
+            x += 0.01f + (float)(HostRand(&seed) % 1000u) * 1e-3f;
+            ct.points[i]  = x;
+            ct.offsets[i] = (float)((int)(HostRand(&seed) % 2001u) - 1000) * 1e-3f;
+        }
+        raw_ct = ct;
+        CHECK(CalTableCompile(&ct) == 0, "compile %d points", np);
+
+        uint32_t k = 0;
+        for (int i = 0; i < np && k + 3 <= CAL_CHECK_IN; i++) {
+            in[k++] = ct.points[i];
+            in[k++] = nextafterf(ct.points[i], -INFINITY);
+            in[k++] = nextafterf(ct.points[i], INFINITY);
+        }
+        float span = ct.points[np - 1] - ct.points[0] + 1.0f;
+        while (k < CAL_CHECK_IN) {
+            in[k++] = ct.points[0] - 0.5f + span * (float)(HostRand(&seed) % 100000u) * 1e-5f;
+        }
+
+        CalibrateBlock(&ct, in, blk, CAL_CHECK_IN);
+        for (uint32_t j = 0; j < CAL_CHECK_IN; j++) {
+            float got  = CalibrateCurrent(&ct, in[j]);
+            float want = CalLinearScan(&ct, in[j]);
+            float err  = fabsf(got - want);
+            if (err > worst) worst = err;
+            CHECK(err <= 4e-6f, "%d points, raw %.7f: %.7f, linear scan %.7f", np, in[j], got, want);
+            CHECK(blk[j] == got, "%d points, raw %.7f: block %.7f vs single %.7f", np, in[j], blk[j], got);
+            CHECK(fabsf(CalibrateCurrent(&raw_ct, in[j]) - got) <= 4e-6f, "uncompiled table differs");
+            checked++;
+        }
+    }
+    printf("    %u lookups over 1..%d point tables, worst difference from the linear scan %.2g\n",
+           checked, MAX_CAL_POINTS, worst);
+
+    memset(&ct, 0, sizeof(ct));
+    ct.num_points = 3;
+    ct.points[0] = 0.0f; ct.points[1] = 1.0f; ct.points[2] = 1.0f;
+    CHECK(CalTableCompile(&ct) != 0, "non-increasing points accepted");
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  校准拟合与持久化：
+  - 已知 5 节点偏移量曲线，120 个 (原始值, 参考值) 对，叠加 ±1 mA 噪声，其中 6 个混入 0.2 A 离群值；
+    拟合出的节点偏移量应接近真值，离群点全部剔除
+  - 序列化 → 反序列化还原同一张表；改动任一字节（CRC 失配）、截短都应拒绝
+  - 经内存 CalStore 保存再加载并登记；键下存的是别的 id 时加载失败且不改动调用者的表
+   ------------------------------------------------------------------ */
+typedef struct {
+    char     key[16];
+    uint8_t  data[CAL_BLOB_MAX];
+    uint32_t len;
+} HostCalSlot;
+
+static int HostCalWrite(void *ctx, const char *key, const void *data, uint32_t len)
+{
+    HostCalSlot *s = (HostCalSlot *)ctx;
+    if (len > sizeof(s->data)) return -1;
+    snprintf(s->key, sizeof(s->key), "%s", key);
+    memcpy(s->data, data, len);
+    s->len = len;
+    return 0;
+}
+
+static int HostCalRead(void *ctx, const char *key, void *data, uint32_t max)
+{
+    HostCalSlot *s = (HostCalSlot *)ctx;
+    if (s->len == 0 || strcmp(s->key, key) != 0 || s->len > max) return -1;
+    memcpy(data, s->data, s->len);
+    return (int)s->len;
+}
+
+int Scenario_CalFitPersist(void)
+{
+    static const float knots[5]    = { 0.0f, 0.5f, 1.0f, 2.0f, 4.0f };
+    static const float true_off[5] = { 0.010f, -0.004f, 0.002f, 0.025f, -0.030f };
+    static CalFitSession fs;
+    static HostCalSlot slot;
+    CalTable truth = { 0 }, fit = { 0 }, back, loaded, keep;
+    CalStore st = { HostCalWrite, HostCalRead, &slot };
+    uint8_t blob[CAL_BLOB_MAX], bad[CAL_BLOB_MAX];
+    uint32_t seed = 0xF17u;
+
+    truth.num_points = 5;
+    memcpy(truth.points, knots, sizeof(knots));
+    memcpy(truth.offsets, true_off, sizeof(true_off));
+    CHECK(CalTableCompile(&truth) == 0, "truth table");
+
+    CalFitBegin(&fs);
+    for (int i = 0; i < 120; i++) {
+        float raw = (float)i * (4.2f / 119.0f);
+        float noise = (float)((int)(HostRand(&seed) % 2001u) - 1000) * 1e-6f;
+        float ref = CalibrateCurrent(&truth, raw) + noise + ((i % 20 == 7) ? 0.2f : 0.0f);
+        CHECK(CalFitAdd(&fs, raw, ref) == 0, "add %d", i);
+    }
+    fit.id = 3;
+    CHECK(CalFitSolve(&fs, knots, 5, 3.0f, &fit) == 0, "solve");
+
+    float worst = 0.0f;
+    for (int i = 0; i < 5; i++) {
+        float e = fabsf(fit.offsets[i] - true_off[i]);
+        if (e > worst) worst = e;
+    }
+    printf("    fit: %u rejected, rms %.3f mA, worst knot error %.3f mA\n", fs.rejected, fs.rms * 1e3f, worst * 1e3f);
+    CHECK(fs.rejected >= 6 && fs.rejected <= 8, "rejected %u", fs.rejected);
+    CHECK(worst < 1e-3f, "knot offsets off by %.4f", worst);
+    CHECK(fit.compiled && fit.id == 3, "fit output not compiled or id changed");
+
+    /* 序列化往返 */
+    int len = CalTableSerialize(&fit, blob, sizeof(blob));
+    CHECK(len == 16 + 8 * 5, "blob length %d", len);
+    CHECK(CalTableDeserialize(blob, (uint32_t)len, &back) == 0, "deserialize");
+    CHECK(back.id == fit.id && back.num_points == fit.num_points && back.compiled, "header");
+    CHECK(memcmp(back.points, fit.points, 5 * sizeof(float)) == 0
+       && memcmp(back.offsets, fit.offsets, 5 * sizeof(float)) == 0
+       && memcmp(back.slopes, fit.slopes, 5 * sizeof(float)) == 0, "table changed by the round trip");
+    for (int i = 0; i < len; i++) {
+        memcpy(bad, blob, (size_t)len);
+        bad[i] ^= 0x01;
+        CHECK(CalTableDeserialize(bad, (uint32_t)len, &back) != 0, "corrupted byte %d accepted", i);
+    }
+    CHECK(CalTableDeserialize(blob, (uint32_t)len - 1, &back) != 0, "truncated blob accepted");
+
+    /* 保存 → 加载 → 登记 */
+    CHECK(CalTableSave(&st, &fit) == 0, "save");
+    CHECK(strcmp(slot.key, "cal3") == 0, "key \"%s\"", slot.key);
+    CHECK(CalTableLoad(&st, 3, &loaded) == 0, "load");
+    CHECK(CalSelect(3) == &loaded, "loaded table not registered");
+    CHECK(CalibrateById(3, 1.5f) == CalibrateCurrent(&fit, 1.5f), "registered table differs");
+
+    /* 键 cal3 下存的是 id 5 的表：加载失败，调用者的表原样保留 */
+    memcpy(&keep, &loaded, sizeof(keep));
+    fit.id = 5;
+    len = CalTableSerialize(&fit, slot.data, sizeof(slot.data));
+    CHECK(len > 0, "serialize id 5");
+    slot.len = (uint32_t)len;
+    CHECK(CalTableLoad(&st, 3, &loaded) != 0, "blob with the wrong id accepted");
+    CHECK(memcmp(&keep, &loaded, sizeof(keep)) == 0, "failed load modified the caller's table");
+    return 0;
+}
@@ -0,0 +1,147 @@
+/* ------------------------------------------------------------------
+  function.c 基准与自检（FUNCTION_BENCH）
+  耗时只打印不判定（主机负载不同结果不同）；判定的是各基准附带的正确性结论。
+   ------------------------------------------------------------------ */
+#include "host.h"
+#include "function.h"
+
+static float HostRatio(uint32_t slow_us, uint32_t fast_us)
+{
+    return fast_us ? (float)slow_us / (float)fast_us : 0.0f;
+}
+
+
+/* ------------------------------------------------------------------
+  块处理：滑动均值满窗后以倒数乘法代替除法，与逐样本输出最多差 1 ulp（2 附近约 2.4e-7）；
+  卡尔曼块处理与逐样本完全一致
+   ------------------------------------------------------------------ */
+int Scenario_BenchFilterBlock(void)
+{
+    FilterBlockBenchResult res;
+
+    FilterBlockBench(100000, 64, &res);
+    printf("    %u x %u samples: scalar %.1f ms, block %.1f ms (%.2fx), max diff %.2e\n",
+           res.blocks, res.block_len, res.scalar_us * 1e-3f, res.block_us * 1e-3f,
+           HostRatio(res.scalar_us, res.block_us), res.max_diff);
+    CHECK(res.block_len == 64 && res.blocks == 100000, "parameters");
+    CHECK(res.max_diff <= 2.4e-7f, "block output differs by more than 1 ulp");
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  测量链路：同一组原始寄存器值走浮点 / 整数两条链路（换算 → 滑动均值 → 卡尔曼 → 能量），
+  主机有 FPU，耗时差距远小于无 FPU 的目标板，只打印。
+  另遍历全部 16 位原始值核对整数换算：μV 四舍五入（远离 0）、μA 误差不超过 1 μA
+   ------------------------------------------------------------------ */
+int Scenario_BenchPipeline(void)
+{
+    PipelineBenchResult res;
+    INA226_Dev dev;
+    INA226_Snapshot s;
+    uint32_t bad_uv = 0, bad_ua = 0;
+
+    memset(&dev, 0, sizeof(dev));
+    dev.current_lsb_pa = 152592;                           // 5 A / 32767
+    for (int32_t raw = -32768; raw <= 32767; raw++) {
+        memset(&s, 0, sizeof(s));
+        s.shunt_raw   = (int16_t)raw;
+        s.current_raw = (int16_t)raw;
+        INA226_SnapshotToInt(&dev, &s);
+        if (s.shunt_uv != (int32_t)lround(raw * 2.5)) bad_uv++;
+        if (fabs(s.current_ua - raw * (dev.current_lsb_pa * 1e-6)) >= 1.0) bad_ua++;
+    }
+
+    PipelineBench(1000000, &res);
+    printf("    %u samples: float %.1f ms, int %.1f ms (%.2fx)\n",
+           res.samples, res.float_us * 1e-3f, res.int_us * 1e-3f, HostRatio(res.float_us, res.int_us));
+    printf("    integer conversion over 65536 raw values: %u uV and %u uA mismatches\n", bad_uv, bad_ua);
+    CHECK(bad_uv == 0 && bad_ua == 0, "integer conversion");
+    CHECK(res.samples == 1000000, "samples");
+    CHECK(res.float_us > 0 && res.int_us > 0, "bench clock did not advance");
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  NTC：logf 模型与查表的耗时，以及 12 位 ADC、128 段时码值 200..3900 内查表的最大误差（应约 0.13 °C）
+   ------------------------------------------------------------------ */
+int Scenario_BenchNtc(void)
+{
+    NtcBenchResult res;
+
+    NtcBench(1000000, &res);
+    printf("    %u samples: logf %.1f ms, lut %.1f ms (%.2fx), max error %.3f C\n",
+           res.samples, res.logf_us * 1e-3f, res.lut_us * 1e-3f, HostRatio(res.logf_us, res.lut_us), res.max_err_c);
+    CHECK(res.max_err_c < 0.15f, "table error %.3f C", res.max_err_c);
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  数字格式化：旧实现 / snprintf / formatFloatToStr / FormatFixed 的耗时；
+  formatFloatToStr 与 snprintf("%07.2f") 只允许在恰为 .5 的值上不同（远离 0 舍入 vs 偶数舍入），
+  FormatFixed 与整数运算得到的参考串完全一致（负值舍入为 0 时与 printf 相同，保留 '-'）
+   ------------------------------------------------------------------ */
+static void HostFixedRef(char *out, int64_t v, int width)
+{
+    /* 6 位小数 → 2 位，四舍五入远离 0 */
+    int64_t a = v < 0 ? -v : v;
+    int64_t c = (a + 5000) / 10000;
+    snprintf(out, 16, "%s%0*lld.%02lld", v < 0 ? "-" : "",
+             width - 3 - (v < 0 ? 1 : 0), (long long)(c / 100), (long long)(c % 100));
+}
+
+int Scenario_BenchFormat(void)
+{
+    FormatBenchResult res;
+    char buf[16], ref[16];
+    uint32_t lfsr = 0xACE1u;
+    uint32_t ties = 0, other = 0, fixed_bad = 0;
+
+    FormatBench(1000000, &res);
+    printf("    %u samples: legacy %.1f ms, snprintf %.1f ms, float %.1f ms, fixed %.1f ms\n",
+           res.samples, res.legacy_us * 1e-3f, res.snprintf_us * 1e-3f, res.float_us * 1e-3f, res.fixed_us * 1e-3f);
+
+    /* 与 FormatBench 相同的输入序列，区分 .5 与其它差异 */
+    for (uint32_t i = 0; i < res.samples; i++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        float v = (float)(int32_t)(lfsr - 0x8000u) * 0.00137f;
+        formatFloatToStr(v, buf, 7, 2);
+        snprintf(ref, sizeof(ref), "%07.2f", v);
+        if (strcmp(buf, ref) == 0) continue;
+        double h = (double)v * 100.0;
+        if (h - floor(h) == 0.5) ties++;
+        else other++;
+    }
+
+    for (int64_t v = -9999994; v <= 9999994; v += 997) {
+        FormatFixed(buf, v, 6, 7, 2);
+        HostFixedRef(ref, v, 7);
+        if (strcmp(buf, ref) != 0) fixed_bad++;
+    }
+    FormatFixed(buf, 9995000, 6, 7, 2);                     // 9.995 → 0010.00
+    printf("    vs snprintf: %u mismatches (%u on .5 ties); FormatFixed vs reference: %u; 9.995 -> \"%s\"\n",
+           res.mismatches, ties, fixed_bad, buf);
+    CHECK(res.mismatches == ties + other, "mismatch count");
+    CHECK(other == 0, "formatFloatToStr differs from snprintf away from .5 ties");
+    CHECK(fixed_bad == 0, "FormatFixed");
+    CHECK(strcmp(buf, "0010.00") == 0, "carry into the integer part");
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  自复位起统计的长时间回归：两段各 2000 万个样本（超过 2^24），
+  均值应为 1.5、标准差约 0.5；float Welford 会停在均值 1.0
+   ------------------------------------------------------------------ */
+int Scenario_StatsLongRun(void)
+{
+    StatsLongRunResult res;
+
+    StatsLongRunCheck(20000000, &res);
+    printf("    %u + %u samples: mean %.6f, stddev %.6f\n", res.per_phase, res.per_phase, res.mean, res.stddev);
+    CHECK(fabsf(res.mean - 1.5f) < 1e-4f, "mean %.6f", res.mean);
+    CHECK(fabsf(res.stddev - 0.5f) < 1e-3f, "stddev %.6f", res.stddev);
+    return 0;
+}
@@ -0,0 +1,11 @@
+#ifndef __INA226_HOST_CLOCK_H
+#define __INA226_HOST_CLOCK_H
+
+#include <stdint.h>
+
+/* 基准测试计时：INA226_TIMESTAMP_US 在主机上是仿真时钟，不随实际耗时前进，
+   function.c 的 FUNCTION_BENCH 部分改用单调时钟（Makefile 中以 -include 注入） */
+uint64_t HostMonoUs(void);
+#define BENCH_TIME_US()   HostMonoUs()
+
+#endif // __INA226_HOST_CLOCK_H
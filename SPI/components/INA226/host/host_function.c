@@ -0,0 +1,179 @@
+/* ------------------------------------------------------------------
+  function.c 主机端场景
+  仿真器产生的读数原样送入 function.c 的滤波流水线、统计引擎与能量累计器，
+  与固件中的调用顺序相同（MgrPoll → 换算 → 滤波 / 统计 / 积分）。
+   ------------------------------------------------------------------ */
+#include "host.h"
+#include "function.h"
+
+/* 以固定配置采集 n 个读数，返回最后一个读数的时刻 */
+static uint64_t HostCollect(HostRig *r, INA226_Snapshot *out, uint32_t n)
+{
+    uint8_t idx;
+    uint32_t got = 0;
+
+    while (got < n) {
+        if (INA226_MgrPoll(&r->m, &out[got], &idx) == 1) got++;
+        else INA226_SimClock_Advance(20);
+    }
+    return out[n - 1].t_us;
+}
+
+static float HostStddev(const float *x, uint32_t n, float *mean_out)
+{
+    double sum = 0.0, sq = 0.0;
+    for (uint32_t i = 0; i < n; i++) sum += x[i];
+    double mean = sum / n;
+    for (uint32_t i = 0; i < n; i++) sq += (x[i] - mean) * (x[i] - mean);
+    if (mean_out) *mean_out = (float)mean;
+    return (float)sqrt(sq / n);
+}
+
+
+/* ------------------------------------------------------------------
+  滤波流水线：1 A / 12 V，分流电压噪声 ±100 μV（电流 ±10 mA）。
+  电流通道（中值5 → 卡尔曼 → 抽取4）输出个数为输入的 1/4，噪声明显下降、均值不偏；
+  母线通道（中值3 → EMA）中插入一个跌到 0 V 的单点毛刺，输出不应跟随
+   ------------------------------------------------------------------ */
+#define SIM_FILTER_N     512
+#define SIM_FILTER_BLOCK 64
+
+int Scenario_SimFilter(void)
+{
+    static INA226_SimPoint pts[] = { { 0, 1.0f, 12.0f }, { 10000000, 1.0f, 12.0f } };
+    static INA226_Snapshot snap[SIM_FILTER_N];
+    static float cur[SIM_FILTER_N], bus[SIM_FILTER_N];
+    static float cur_f[SIM_FILTER_N], bus_f[SIM_FILTER_N];
+    HostRig r;
+
+    RigInit(&r, pts, 2);
+    INA226_Sim_SetNoise(&r.sim, 100e-6f, 2e-3f, 7);
+    INA226_MgrScan(&r.m);
+    INA226_MgrConfigure(&r.m, 0, 0, 0, 0, 7, 0.01f, 5.0f);   // 280 μs 一次结果
+    HostCollect(&r, snap, SIM_FILTER_N);
+
+    for (uint32_t i = 0; i < SIM_FILTER_N; i++) {
+        cur[i] = snap[i].current_a;
+        bus[i] = snap[i].bus_v;
+    }
+    bus[300] = 0.0f;                                          // 单点毛刺
+
+    uint32_t nc = 0, nb = 0;
+    for (uint32_t i = 0; i < SIM_FILTER_N; i += SIM_FILTER_BLOCK) {
+        nc += FilterChannelProcess(1, &cur[i], &cur_f[nc], SIM_FILTER_BLOCK);
+        nb += FilterChannelProcess(0, &bus[i], &bus_f[nb], SIM_FILTER_BLOCK);
+    }
+
+    float raw_mean, out_mean;
+    float raw_sd = HostStddev(cur + 16, SIM_FILTER_N - 16, &raw_mean);
+    float out_sd = HostStddev(cur_f + 4, nc - 4, &out_mean);
+    float bus_worst = 0.0f;
+    for (uint32_t i = 8; i < nb; i++) {
+        float e = fabsf(bus_f[i] - 12.0f);
+        if (e > bus_worst) bus_worst = e;
+    }
+    printf("    current: %u -> %u samples, sd %.2f -> %.2f mA, mean %.4f A; bus worst %.1f mV with a 0 V glitch\n",
+           SIM_FILTER_N, nc, raw_sd * 1e3f, out_sd * 1e3f, out_mean, bus_worst * 1e3f);
+    CHECK(nc == SIM_FILTER_N / 4, "decimated count %u", nc);
+    CHECK(nb == SIM_FILTER_N, "bus count %u", nb);
+    CHECK(out_sd < raw_sd / 3.0f, "noise not reduced");
+    CHECK(fabsf(out_mean - raw_mean) < 1e-3f && fabsf(out_mean - 1.0f) < 2e-3f, "mean %.4f", out_mean);
+    CHECK(bus_worst < 0.02f, "glitch passed through the bus channel");
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  统计引擎：0.5 s 1 A 后阶跃到 2 A，噪声 ±100 μV（均匀分布，σ = 10 mA / √3 ≈ 5.8 mA）。
+  自复位起均值约 1.5 A；100 ms 窗口（10 桶）含最近 90~100 ms 的样本，均为阶跃之后，
+  均值 2 A、σ 接近理论值
+   ------------------------------------------------------------------ */
+int Scenario_SimStats(void)
+{
+    static INA226_SimPoint pts[] = {
+        { 0, 1.0f, 12.0f }, { 500000, 1.0f, 12.0f }, { 500001, 2.0f, 12.0f }, { 2000000, 2.0f, 12.0f },
+    };
+    HostRig r;
+    StatsChannel st;
+    StatsResult tot, win;
+    INA226_Snapshot s;
+    uint8_t idx;
+
+    RigInit(&r, pts, 4);
+    INA226_Sim_SetNoise(&r.sim, 100e-6f, 0.0f, 11);
+    INA226_MgrScan(&r.m);
+    INA226_MgrConfigure(&r.m, 0, 0, 0, 0, 7, 0.01f, 5.0f);
+    StatsInit(&st);
+    CHECK(StatsAddWindow(&st, 100000, 10) == 0, "window");
+
+    uint64_t t_end = 0;
+    while (INA226_SimClock_Now() < 1000000) {
+        if (INA226_MgrPoll(&r.m, &s, &idx) == 1) {
+            StatsUpdate(&st, s.t_us, s.current_a);
+            t_end = s.t_us;
+        } else {
+            INA226_SimClock_Advance(20);
+        }
+    }
+    StatsTotal(&st, &tot);
+    StatsWindowResult(&st, 0, t_end, &win);
+
+    float sd_expect = 0.010f / sqrtf(3.0f);
+    printf("    total n %u mean %.4f A; 100 ms window n %u mean %.4f A sd %.2f mA (expect %.2f), min %.4f max %.4f\n",
+           tot.n, tot.mean, win.n, win.mean, win.stddev * 1e3f, sd_expect * 1e3f, win.min, win.max);
+    CHECK(fabsf(tot.mean - 1.5f) < 0.01f, "total mean %.4f", tot.mean);
+    CHECK(win.n * 100 >= tot.n * 9 - 200 && win.n * 10 <= tot.n + 20, "window count %u", win.n);   // 9~10 个桶
+    CHECK(fabsf(win.mean - 2.0f) < 2e-3f, "window mean %.4f", win.mean);
+    CHECK(fabsf(win.stddev - sd_expect) < 0.15f * sd_expect, "window sd %.2f mA", win.stddev * 1e3f);
+    CHECK(win.min > 1.98f && win.max < 2.02f, "window min/max contain pre-step samples");
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  能量累计：12 V 下 10 s 内 0 → 2 A 线性爬升，再保持 2 A 5 s。
+  理论电荷 20 A·s = 5.5556 mAh，能量 240 J = 66.667 mWh；
+  按读数时间戳梯形积分，误差来自首个读数之前未积分的区间与量化
+   ------------------------------------------------------------------ */
+int Scenario_SimEnergy(void)
+{
+    static INA226_SimPoint pts[] = {
+        { 0, 0.0f, 12.0f }, { 10000000, 2.0f, 12.0f }, { 15000000, 2.0f, 12.0f },
+    };
+    HostRig r;
+    EnergyAcc acc;
+    EnergySnapshot es;
+    INA226_Snapshot s;
+    uint8_t idx;
+
+    RigInit(&r, pts, 3);
+    INA226_MgrScan(&r.m);
+    INA226_MgrConfigure(&r.m, 0, 1, 4, 4, 7, 0.01f, 5.0f);   // 8.8 ms 一次结果
+    EnergyAccInit(&acc);
+
+    uint64_t t_first = 0, t_last = 0;
+    while (INA226_SimClock_Now() < 15000000) {
+        if (INA226_MgrPoll(&r.m, &s, &idx) == 1) {
+            if (!t_first) t_first = s.t_us;
+            t_last = s.t_us;
+            EnergyAccFeed(&acc, s.t_us, s.current_ua, s.power_uw);
+        } else {
+            INA226_SimClock_Advance(50);
+        }
+    }
+    EnergyAccSnapshot(&acc, &es);
+
+    /* 理论值只取积分覆盖的 [t_first, t_last]：爬升段 ∫ 0.2·t dt，保持段 2 A */
+    double a = t_first * 1e-6, b = t_last * 1e-6;
+    double q_as = 0.1 * (10.0 * 10.0 - a * a) + 2.0 * (b - 10.0);
+    float mah = EnergyAccMilliAmpHours(&es);
+    float mwh = EnergyAccWattHours(&es) * 1e3f;
+    float mah_ref = (float)(q_as / 3.6);
+    float mwh_ref = (float)(q_as * 12.0 / 3.6);
+    printf("    %u samples over %.3f s: %.4f mAh (ref %.4f), %.3f mWh (ref %.3f)\n",
+           es.samples, es.elapsed_us * 1e-6, mah, mah_ref, mwh, mwh_ref);
+    CHECK(es.elapsed_us == t_last - t_first, "elapsed");
+    CHECK(fabsf(mah - mah_ref) < 0.003f * mah_ref, "charge");
+    CHECK(fabsf(mwh - mwh_ref) < 0.003f * mwh_ref, "energy");
+    return 0;
+}
@@ -0,0 +1,362 @@
+/* ------------------------------------------------------------------
+  INA226 主机端仿真场景
+  驱动、调度与自适应代码原样运行在寄存器级仿真器上，用于 Linux 下的回归与基准。
+  每个场景返回 0 表示通过；参数为场景名时只运行该场景。
+   ------------------------------------------------------------------ */
+#include "host.h"
+#include <time.h>
+
+float RESISTOR = 0.01f;             // 旧接口使用的全局分流电阻
+
+uint64_t HostMonoUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+void RigInit(HostRig *r, INA226_SimPoint *pts, uint32_t n)
+{
+    memset(r, 0, sizeof(*r));
+    INA226_SimClock_Set(0);
+    INA226_SimBus_Init(&r->bus, &r->sb, 400000);
+    INA226_Sim_Init(&r->sim, 0x40, 0.01f);
+    INA226_SimProfile_Init(&r->prof, pts, n, 0);
+    INA226_Sim_SetProfile(&r->sim, &r->prof);
+    INA226_SimBus_Attach(&r->sb, &r->sim);
+    INA226_MgrInit(&r->m, &r->bus, INA226_SCHED_ROUND_ROBIN);
+}
+
+
+/* ------------------------------------------------------------------
+  CONFIG 字段：AVG=4、CT=1.1ms、连续模式，周期应为 (1100 + 1100) × 4 μs，
+  读数跟随负载曲线
+   ------------------------------------------------------------------ */
+static int Scenario_Config(void)
+{
+    static INA226_SimPoint pts[] = { { 0, 2.0f, 12.0f }, { 2000000, 2.0f, 12.0f } };
+    HostRig r;
+    INA226_Snapshot s;
+    uint8_t idx;
+
+    RigInit(&r, pts, 2);
+    CHECK(INA226_MgrScan(&r.m) == 1, "scan");
+    INA226_MgrConfigure(&r.m, 0, 1, 4, 4, 7, 0.01f, 5.0f);
+    CHECK(r.m.slot[0].period_us == 8800, "period %u", r.m.slot[0].period_us);
+
+    uint32_t reads = 0;
+    float worst = 0.0f;
+    while (INA226_SimClock_Now() < 1000000) {
+        if (INA226_MgrPoll(&r.m, &s, &idx) == 1) {
+            reads++;
+            float e = fabsf(s.current_a - 2.0f);
+            if (e > worst) worst = e;
+        } else {
+            INA226_SimClock_Advance(50);
+        }
+    }
+    printf("    conversions %u reads %u worst error %.4f A\n", r.sim.conversions, reads, worst);
+    CHECK(r.sim.conversions >= 112 && r.sim.conversions <= 114, "sim period does not follow CONFIG");
+    CHECK(reads <= r.sim.conversions && reads + 3 >= r.sim.conversions, "reads %u", reads);
+    CHECK(worst < 0.002f, "reading error");
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  校准满量程：R = 5 mΩ、Imax = 1.025 A 时按 Imax / 2^15 算出 CAL = 32736，
+  Imax 处 SHUNT × CAL / 2048 = 32767.97，电流寄存器顶在 32767（再大一点即饱和）；
+  按 Imax / 32767 计算时 Imax 应落在寄存器上限以内
+   ------------------------------------------------------------------ */
+static int Scenario_CalFullScale(void)
+{
+    static INA226_SimPoint pts[] = { { 0, 1.025f, 12.0f }, { 1000000, 1.025f, 12.0f } };
+    HostRig r;
+    INA226_Snapshot s;
+    uint8_t idx;
+
+    RigInit(&r, pts, 2);
+    r.sim.shunt_ohm = 0.005f;
+    INA226_MgrScan(&r.m);
+    CHECK(INA226_MgrConfigure(&r.m, 0, 1, 4, 4, 7, 0.005f, 1.025f) == 0, "configure");
+    INA226_Dev *dev = &r.m.slot[0].dev;
+
+    uint32_t reads = 0;
+    uint32_t ovf = 0;
+    int16_t  raw = 0;
+    float    a = 0.0f;
+    while (INA226_SimClock_Now() < 100000) {
+        if (INA226_MgrPoll(&r.m, &s, &idx) == 1) {
+            reads++;
+            ovf += r.sim.ovf;
+            raw = s.current_raw;
+            a   = s.current_a;
+        } else {
+            INA226_SimClock_Advance(50);
+        }
+    }
+    printf("    CAL %u, current_raw %d, %.5f A, overflow %u/%u\n", dev->cal, raw, a, ovf, reads);
+    CHECK(reads > 0, "no reads");
+    CHECK(ovf == 0 && raw < 32767, "current register at its ceiling at full scale");
+    CHECK(fabsf(a - 1.025f) <= 2.0f * dev->current_lsb, "full-scale reading %.5f A", a);
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  时基误差：芯片比名义周期慢/快 10% 时，管理器不得重复读取同一次转换，
+  快时基下也不应漏掉过多转换
+   ------------------------------------------------------------------ */
+static int TimebaseRun(int16_t permille)
+{
+    static INA226_SimPoint pts[] = { { 0, 1.0f, 12.0f }, { 2000000, 1.0f, 12.0f } };
+    HostRig r;
+    INA226_Snapshot s;
+    uint8_t idx;
+
+    RigInit(&r, pts, 2);
+    r.sim.clock_permille = permille;
+    INA226_MgrScan(&r.m);
+    INA226_MgrConfigure(&r.m, 0, 0, 4, 4, 7, 0.01f, 5.0f);       // 名义 2.2 ms
+
+    uint32_t reads = 0, dup = 0, last_conv = 0;
+    while (INA226_SimClock_Now() < 1000000) {
+        if (INA226_MgrPoll(&r.m, &s, &idx) == 1) {
+            reads++;
+            if (r.sim.conversions == last_conv) dup++;
+            last_conv = r.sim.conversions;
+        } else {
+            INA226_SimClock_Advance(20);
+        }
+    }
+    printf("    time base %+d%%: conversions %u reads %u duplicates %u early %u skipped %u\n",
+           permille / 10, r.sim.conversions, reads, dup, r.m.slot[0].early, r.m.slot[0].skipped);
+    CHECK(dup == 0, "same conversion read twice");
+    CHECK(reads * 100 >= r.sim.conversions * 95, "too many conversions missed");
+    return 0;
+}
+
+static int Scenario_MgrTimebase(void)
+{
+    return TimebaseRun(100) || TimebaseRun(-100) || TimebaseRun(0);
+}
+
+
+/* ------------------------------------------------------------------
+  自适应：1 A → 2 A 阶跃，慢速 AVG=128/CT=1.1ms（281.6 ms），快速 AVG=1/CT=140μs（280 μs）。
+  阶跃应在一个慢速周期内切到快速，负载稳定后应及时切回慢速，不得卡在快速状态
+   ------------------------------------------------------------------ */
+static int AdaptStepRun(float shunt_noise_v)
+{
+    static INA226_SimPoint pts[] = {
+        { 0, 1.0f, 12.0f }, { 3000000, 1.0f, 12.0f }, { 3000100, 2.0f, 12.0f }, { 8000000, 2.0f, 12.0f },
+    };
+    HostRig r;
+    INA226_Adapt ad;
+    INA226_Snapshot s;
+    uint8_t idx;
+
+    RigInit(&r, pts, 4);
+    INA226_Sim_SetNoise(&r.sim, shunt_noise_v, 5e-3f, 1);
+    INA226_MgrScan(&r.m);
+    INA226_MgrConfigure(&r.m, 0, 0, 0, 0, 7, 0.01f, 5.0f);
+    INA226_AdaptInit(&ad, &r.m.slot[0].dev, (INA226_Timing){ 0, 0, 0 }, (INA226_Timing){ 4, 4, 4 }, 7, 1.0f);
+    INA226_MgrRetime(&r.m, 0);
+
+    uint64_t t_fast = 0, t_slow = 0;
+    uint32_t pre_switches = 0;
+    while (INA226_SimClock_Now() < 8000000) {
+        if (INA226_MgrPoll(&r.m, &s, &idx) != 1) {
+            INA226_SimClock_Advance(50);
+            continue;
+        }
+        if (s.t_us < 3000000) pre_switches = ad.switches;
+        int rc = INA226_AdaptFeed(&ad, &s);
+        CHECK(rc >= 0, "config write");
+        if (rc == 1) {
+            INA226_MgrRetime(&r.m, 0);
+            if (ad.state == INA226_ADAPT_FAST && !t_fast) t_fast = s.t_us;
+            if (ad.state == INA226_ADAPT_SLOW && t_fast && !t_slow) t_slow = s.t_us;
+        }
+    }
+    printf("    noise %2.0f uV: fast at %.3f s, slow at %.3f s, switches %u (before step %u), noise floor %.2f mA\n",
+           shunt_noise_v * 1e6f, t_fast * 1e-6, t_slow * 1e-6, ad.switches, pre_switches,
+           INA226_AdaptNoiseFloor(&ad) * 1e3f);
+    CHECK(pre_switches == 0, "switched on a flat load");
+    CHECK(t_fast >= 3000000 && t_fast < 3000000 + 2 * 281600, "step not detected");
+    CHECK(t_slow && t_slow - t_fast < 1000000, "stuck in fast state");
+    CHECK(ad.switches == 2 && ad.state == INA226_ADAPT_SLOW, "switches %u state %u", ad.switches, ad.state);
+    return 0;
+}
+
+static int Scenario_AdaptStep(void)
+{
+    return AdaptStepRun(10e-6f) || AdaptStepRun(20e-6f);
+}
+
+
+/* ------------------------------------------------------------------
+  保护延时：SOL 锁存告警，EXTI 入口取边沿时刻，HAL 分发 2 μs、trip() 3 μs，
+  统计的延时应为边沿到 trip() 返回的 5 μs，而不只是 trip() 本身
+   ------------------------------------------------------------------ */
+static INA226_Dev *protect_dev;
+static uint64_t    protect_trip_us;
+
+static void HostAlertIRQ(void *arg)
+{
+    (void)arg;
+    uint32_t edge = INA226_CYCLES();        // 中断入口第一条语句
+    INA226_SimClock_Advance(2);             // HAL_GPIO_EXTI_IRQHandler 分发
+    INA226_AlertISRAt(protect_dev, edge);
+}
+
+static void HostTrip(void *arg)
+{
+    (void)arg;
+    INA226_SimClock_Advance(3);
+    protect_trip_us = INA226_SimClock_Now();
+}
+
+static int Scenario_ProtectLatency(void)
+{
+    static INA226_SimPoint pts[] = {
+        { 0, 1.0f, 12.0f }, { 10000, 1.0f, 12.0f }, { 10001, 3.0f, 12.0f }, { 20000, 3.0f, 12.0f },
+    };
+    HostRig r;
+    INA226_Protect prot;
+
+    RigInit(&r, pts, 4);
+    INA226_MgrScan(&r.m);
+    INA226_MgrConfigure(&r.m, 0, 0, 0, 0, 7, 0.01f, 5.0f);   // 280 μs 一次结果
+    protect_dev = &r.m.slot[0].dev;
+    protect_trip_us = 0;
+    r.sim.on_alert = HostAlertIRQ;
+    CHECK(INA226_SetAlertLimit(protect_dev, INA226_ME_SOL, 2.0f, INA226_ALERT_LATCH) == 0, "limit");
+    INA226_ArmProtection(protect_dev, &prot, HostTrip, NULL);
+
+    while (INA226_SimClock_Now() < 20000 && !prot.trips) {
+        INA226_SimClock_Advance(1);
+        INA226_Sim_Update(&r.sim);
+    }
+
+    float last, max;
+    INA226_ProtectLatencyUs(&prot, &last, NULL, NULL, &max);
+    printf("    tripped at %.3f ms, latency %.1f us (max %.1f)\n", protect_trip_us * 1e-3, last, max);
+    CHECK(prot.trips == 1, "trips %u", prot.trips);
+    CHECK(protect_trip_us > 10000 && protect_trip_us < 10000 + 2 * 280 + 10, "trip too late");
+    CHECK(prot.lat_last == 5, "latency %u, expected edge to end of trip()", prot.lat_last);
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  撤防恢复：使用转换完成中断的设备布防期间关闭 CNVR，撤防后应重新收到转换完成中断
+   ------------------------------------------------------------------ */
+static uint32_t disarm_ready;
+
+static void HostReady(void *arg)
+{
+    (void)arg;
+    disarm_ready++;
+}
+
+static void HostAlertReady(void *arg)
+{
+    INA226_AlertISR((INA226_Dev *)arg);
+}
+
+static uint32_t DisarmRun(HostRig *r, INA226_Dev *dev, uint32_t span_us)
+{
+    INA226_Snapshot s;
+    uint32_t start = disarm_ready;
+    uint64_t until_us = INA226_SimClock_Now() + span_us;
+
+    while (INA226_SimClock_Now() < until_us) {
+        INA226_SimClock_Advance(5);
+        INA226_Sim_Update(&r->sim);
+        if (dev->ready) INA226_ReadReady(dev, &s);
+    }
+    return disarm_ready - start;
+}
+
+static int Scenario_ProtectDisarm(void)
+{
+    static INA226_SimPoint pts[] = { { 0, 1.0f, 12.0f }, { 100000, 1.0f, 12.0f } };
+    HostRig r;
+    INA226_Protect prot;
+
+    RigInit(&r, pts, 2);
+    INA226_MgrScan(&r.m);
+    INA226_MgrConfigure(&r.m, 0, 0, 0, 0, 7, 0.01f, 5.0f);   // 280 μs 一次结果
+    INA226_Dev *dev = &r.m.slot[0].dev;
+    r.sim.on_alert     = HostAlertReady;
+    r.sim.on_alert_arg = dev;
+    disarm_ready = 0;
+
+    INA226_EnableConvReady(dev, HostReady, NULL);
+    uint32_t before = DisarmRun(&r, dev, 10000);
+    CHECK(INA226_SetAlertLimit(dev, INA226_ME_SOL, 4.0f, INA226_ALERT_LATCH) == 0, "limit");
+    INA226_ArmProtection(dev, &prot, HostTrip, NULL);
+    uint32_t armed = DisarmRun(&r, dev, 10000);
+    INA226_DisarmProtection(dev);
+    uint32_t after = DisarmRun(&r, dev, 10000);
+
+    printf("    conversion-ready interrupts per 10 ms: before %u, armed %u, after disarm %u\n",
+           before, armed, after);
+    CHECK(prot.trips == 0, "tripped below the limit");
+    CHECK(armed == 0, "conversion ready still enabled while armed");
+    CHECK(before > 5 && after + 1 >= before, "conversion ready not restored after disarm");
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  场景表
+   ------------------------------------------------------------------ */
+static const HostScenario scenarios[] = {
+    { "config", Scenario_Config },
+    { "cal_fullscale", Scenario_CalFullScale },
+    { "mgr_timebase", Scenario_MgrTimebase },
+    { "adapt_step", Scenario_AdaptStep },
+    { "protect_latency", Scenario_ProtectLatency },
+    { "protect_disarm", Scenario_ProtectDisarm },
+    { "sim_filter", Scenario_SimFilter },
+    { "sim_stats", Scenario_SimStats },
+    { "sim_energy", Scenario_SimEnergy },
+    { "bench_filter_block", Scenario_BenchFilterBlock },
+    { "bench_pipeline", Scenario_BenchPipeline },
+    { "bench_ntc", Scenario_BenchNtc },
+    { "bench_format", Scenario_BenchFormat },
+    { "stats_longrun", Scenario_StatsLongRun },
+    { "ring_stress", Scenario_RingStress },
+    { "ring_pipeline", Scenario_RingPipeline },
+    { "median_vs_sort", Scenario_MedianVsSort },
+    { "wh_longrun", Scenario_WhLongRun },
+    { "fan_stall", Scenario_FanStall },
+    { "clock_longrun", Scenario_ClockLongRun },
+    { "cal_vs_scan", Scenario_CalVsScan },
+    { "cal_fit_persist", Scenario_CalFitPersist },
+};
+
+int main(int argc, char **argv)
+{
+    int failed = 0, ran = 0;
+
+    for (unsigned i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        if (argc > 1 && strcmp(argv[1], scenarios[i].name) != 0) continue;
+
+        clock_t c0 = clock();
+        printf("[%s]\n", scenarios[i].name);
+        int rc = scenarios[i].run();
+        printf("    %s (%.1f ms host time)\n", rc ? "FAIL" : "PASS",
+               (double)(clock() - c0) * 1000.0 / CLOCKS_PER_SEC);
+        failed += rc ? 1 : 0;
+        ran++;
+    }
+    if (ran == 0) {
+        printf("unknown scenario\n");
+        return 2;
+    }
+    printf("%d/%d passed\n", ran - failed, ran);
+    return failed ? 1 : 0;
+}
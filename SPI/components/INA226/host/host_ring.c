@@ -0,0 +1,179 @@
+/* ------------------------------------------------------------------
+  采样环主机端场景
+  - ring_stress：一个生产者线程 + 两个消费者线程（一快一慢）真实并发运行，
+    每个样本的各字段由序号推出，消费者逐个核对完整性与顺序
+  - ring_pipeline：管理器 → INA226_RingSink → 采样环 → MeasureConsumer，
+    与直接在采样循环里累计的结果对比
+   ------------------------------------------------------------------ */
+#include "host.h"
+#include "INA226_ring.h"
+#include "function.h"
+#include <pthread.h>
+#include <sched.h>
+
+#define RING_STRESS_N    1000000u
+
+typedef struct {
+    INA226_Ring *ring;
+    int          id;
+    uint32_t     batch;         // 每次最多读取数
+    uint32_t     pause;         // 每批之后空转的次数（慢消费者）
+    uint32_t     got;
+    uint32_t     torn;          // 字段与序号不符（读到写了一半的样本）
+    uint32_t     order;         // 序号与 游标 + 丢失数 不符
+} RingReader;
+
+static volatile uint32_t ring_done;
+
+/* 样本内容全部由序号决定，任一字段被并发改写都能发现 */
+static void RingFill(INA226_Snapshot *s, uint32_t seq)
+{
+    memset(s, 0, sizeof(*s));
+    s->t_us        = seq;
+    s->shunt_raw   = (int16_t)(seq * 7u);
+    s->bus_raw     = (uint16_t)(seq ^ 0x5A5Au);
+    s->current_raw = (int16_t)~seq;
+    s->current_ua  = (int32_t)(seq * 2654435761u);
+    s->power_uw    = ((int64_t)seq << 20) | (seq & 0xFFFFF);
+}
+
+static int RingIntact(const INA226_RingItem *it)
+{
+    INA226_Snapshot ref;
+    RingFill(&ref, (uint32_t)it->snap.t_us);
+    return it->dev == (uint8_t)it->snap.t_us && memcmp(&ref, &it->snap, sizeof(ref)) == 0;
+}
+
+static void *RingProducer(void *arg)
+{
+    INA226_Ring *r = (INA226_Ring *)arg;
+    INA226_Snapshot s;
+
+    for (uint32_t seq = 0; seq < RING_STRESS_N; seq++) {
+        RingFill(&s, seq);
+        INA226_RingPush(r, &s, (uint8_t)seq);
+        if ((seq & 0x3F) == 0) sched_yield();          // 单核主机上也让消费者穿插运行
+    }
+    __atomic_store_n(&ring_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* 游标从 0 开始：读完后 游标 = 已收 + 已丢，本批第一个样本的序号即 已收（本批之前）+ 已丢 */
+static uint32_t RingConsumeOnce(RingReader *c, INA226_RingItem *buf)
+{
+    uint32_t n = INA226_RingRead(c->ring, c->id, buf, c->batch);
+    uint32_t first = c->got + INA226_RingOverrun(c->ring, c->id);
+
+    for (uint32_t k = 0; k < n; k++) {
+        if (!RingIntact(&buf[k])) c->torn++;
+        if ((uint32_t)buf[k].snap.t_us != first + k) c->order++;
+    }
+    c->got += n;
+    return n;
+}
+
+static void *RingConsumer(void *arg)
+{
+    RingReader *c = (RingReader *)arg;
+    INA226_RingItem buf[INA226_RING_LEN];
+
+    while (!__atomic_load_n(&ring_done, __ATOMIC_ACQUIRE)) {
+        if (RingConsumeOnce(c, buf) == 0) sched_yield();
+        for (volatile uint32_t i = 0; i < c->pause; i++) { }
+    }
+    while (RingConsumeOnce(c, buf) > 0) { }    // 生产者结束后取完剩余样本
+    return NULL;
+}
+
+int Scenario_RingStress(void)
+{
+    static INA226_Ring ring;
+    RingReader rd[2] = {
+        { &ring, 0, 16, 0, 0, 0, 0 },                       // 小批量、不停读
+        { &ring, 0, INA226_RING_LEN, 20000, 0, 0, 0 },      // 整圈读、每批后空转（多核下必然被覆盖）
+    };
+    pthread_t tp, tc[2];
+
+    INA226_RingInit(&ring);
+    ring_done = 0;
+    for (int i = 0; i < 2; i++) {
+        rd[i].id = INA226_RingAddConsumer(&ring);
+        CHECK(rd[i].id >= 0, "add consumer");
+    }
+    for (int i = 0; i < 2; i++) pthread_create(&tc[i], NULL, RingConsumer, &rd[i]);
+    pthread_create(&tp, NULL, RingProducer, &ring);
+    pthread_join(tp, NULL);
+    for (int i = 0; i < 2; i++) pthread_join(tc[i], NULL);
+
+    for (int i = 0; i < 2; i++) {
+        uint32_t ovr = INA226_RingOverrun(&ring, rd[i].id);
+        printf("    consumer %d (batch %u): received %u, overrun %u, torn %u, out of order %u\n",
+               i, rd[i].batch, rd[i].got, ovr, rd[i].torn, rd[i].order);
+        CHECK(rd[i].torn == 0, "consumer %d returned a torn sample", i);
+        CHECK(rd[i].order == 0, "consumer %d sequence does not match its overrun count", i);
+        CHECK(rd[i].got + ovr == RING_STRESS_N, "consumer %d lost samples without counting them", i);
+    }
+    CHECK(INA226_RingOverrun(&ring, rd[1].id) > 0, "slow consumer never overran; stress too weak");
+    return 0;
+}
+
+
+/* ------------------------------------------------------------------
+  管理器 → 采样环 → MeasureConsumer：1 → 2 A 阶跃，8.8 ms 一次结果。
+  每 drain_every 个读数取一次环：落后不超过 INA226_RING_LEN - 1 时与采样循环内直接累计的
+  结果完全相同；超过时丢失的样本全部计入 overrun
+   ------------------------------------------------------------------ */
+static int RingPipelineRun(uint32_t drain_every)
+{
+    static INA226_SimPoint pts[] = {
+        { 0, 1.0f, 12.0f }, { 2000000, 1.0f, 12.0f }, { 2000100, 2.0f, 12.0f }, { 4000000, 2.0f, 12.0f },
+    };
+    static INA226_Ring ring;
+    static MeasureConsumer mc;
+    HostRig r;
+    EnergyAcc direct;
+    EnergySnapshot a, b;
+    INA226_Snapshot s;
+    uint8_t idx;
+    uint32_t reads = 0, drained = 0;
+
+    RigInit(&r, pts, 4);
+    INA226_Sim_SetNoise(&r.sim, 50e-6f, 0.0f, 3);
+    INA226_MgrScan(&r.m);
+    INA226_MgrConfigure(&r.m, 0, 1, 4, 4, 7, 0.01f, 5.0f);
+    INA226_RingInit(&ring);
+    INA226_MgrSetSink(&r.m, INA226_RingSink, &ring);
+    CHECK(MeasureConsumerInit(&mc, &ring, 0) == 0, "consumer");
+    EnergyAccInit(&direct);
+
+    while (INA226_SimClock_Now() < 4000000) {
+        if (INA226_MgrPoll(&r.m, &s, &idx) == 1) {
+            EnergyAccFeed(&direct, s.t_us, s.current_ua, s.power_uw);
+            if (++reads % drain_every == 0) drained += MeasureConsumerDrain(&mc);
+        } else {
+            INA226_SimClock_Advance(50);
+        }
+    }
+    drained += MeasureConsumerDrain(&mc);
+
+    EnergyAccSnapshot(&direct, &a);
+    EnergyAccSnapshot(&mc.energy, &b);
+    StatsResult st;
+    StatsTotal(&mc.current, &st);
+    printf("    drain every %3u: reads %u, consumed %u, overrun %u; %.4f vs %.4f mAh, mean %.4f A\n",
+           drain_every, reads, drained, mc.overrun, EnergyAccMilliAmpHours(&b), EnergyAccMilliAmpHours(&a), st.mean);
+    CHECK(drained + mc.overrun == reads, "samples lost without being counted");
+    CHECK(st.n == drained, "stats count");
+    if (drain_every < INA226_RING_LEN) {
+        CHECK(mc.overrun == 0, "overrun with a ring-sized drain interval");
+        CHECK(b.uas == a.uas && b.uws == a.uws && b.samples == a.samples, "consumer differs from direct accumulation");
+    } else {
+        CHECK(mc.overrun > 0, "no overrun with drain interval %u", drain_every);
+    }
+    return 0;
+}
+
+int Scenario_RingPipeline(void)
+{
+    return RingPipelineRun(16) || RingPipelineRun(INA226_RING_LEN - 1) || RingPipelineRun(200);
+}
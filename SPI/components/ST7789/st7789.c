@@ -63,7 +63,6 @@
 
 #include "st7789.h"
 #include "Font_asc.h"
-#include "tim.h"
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -73,113 +72,309 @@
 
 
 
+/* ------------------------------------------------------------------
+   总线与面板
+   ------------------------------------------------------------------ */
+
+/* ST7789 MADCTL：按方向编号 0..3 */
+static const uint8_t lcd_madctl[4] = { 0x00, 0xC0, 0x70, 0xA0 };
+
+/* DMA 标志位移：每个通道占 4 位（GIF/TCIF/HTIF/TEIF） */
+#define BUS_FLAG_SHIFT(bus)  (((uint32_t)(bus)->dma_index - 1U) * 4U)
+
+static void bus_start_job(st7789_bus_t *bus);
+static void lcd_apply_rotation(st7789_t *lcd);
+static void lcd_set_window(st7789_t *lcd, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye);
+
+/* 初始化共享总线：SPI 与 DMA 通道须已由 CubeMX 配置好 */
+void ST7789_BusInit(st7789_bus_t *bus, SPI_TypeDef *spi, DMA_TypeDef *dma, uint32_t dma_ch, uint8_t dma_index)
+{
+    memset(bus, 0, sizeof(*bus));
+    bus->spi       = spi;
+    bus->dma       = dma;
+    bus->dma_ch    = dma_ch;
+    bus->dma_index = dma_index;
+
+    LL_DMA_DisableChannel(dma, dma_ch);
+    LL_DMA_SetPeriphAddress(dma, dma_ch, (uint32_t)&spi->DR);
+    WRITE_REG(dma->IFCR, DMA_IFCR_CGIF1 << BUS_FLAG_SHIFT(bus));
+    LL_DMA_EnableIT_TC(dma, dma_ch);   // 未接中断时由 ST7789_BusPoll 轮询推进
+}
+
+/* 把一块屏挂到总线上，按方向计算尺寸与显存偏移 */
+void ST7789_Attach(st7789_t *lcd, st7789_bus_t *bus, const st7789_cfg_t *cfg)
+{
+    memset(lcd, 0, sizeof(*lcd));
+    lcd->bus = bus;
+    lcd->cfg = *cfg;
+    lcd->cfg.rotation &= 0x03;
+
+    if (lcd->cfg.native_w == 0 || lcd->cfg.native_h == 0) {
+        lcd->cfg.native_w = ST7789_NATIVE_W;
+        lcd->cfg.native_h = ST7789_NATIVE_H;
+        lcd->cfg.offset   = ST7789_NATIVE_OFFSET;
+    }
+
+    lcd_apply_rotation(lcd);
+}
+
+/* 按 cfg.rotation 计算逻辑尺寸与显存偏移 */
+static void lcd_apply_rotation(st7789_t *lcd)
+{
+    if (lcd->cfg.rotation < 2) {            // 竖屏：短边在 X
+        lcd->width  = lcd->cfg.native_w;
+        lcd->height = lcd->cfg.native_h;
+        lcd->x_off  = lcd->cfg.offset;
+        lcd->y_off  = 0;
+    } else {                                // 横屏：短边在 Y
+        lcd->width  = lcd->cfg.native_h;
+        lcd->height = lcd->cfg.native_w;
+        lcd->x_off  = 0;
+        lcd->y_off  = lcd->cfg.offset;
+    }
+}
+
+/**
+ * 提交一次像素传输作业
+ * - 总线空闲时立即开始，否则排队；队列满则等待
+ * - 作业数据（非 FILL）在传输完成前须保持有效，可用 ST7789_Sync 等待
+ * 返回：0 成功，-1 参数错误
+ */
+int ST7789_Submit(const st7789_job_t *job)
+{
+    if (job == NULL || job->lcd == NULL || job->len == 0) return -1;
+
+    st7789_bus_t *bus = job->lcd->bus;
+    uint8_t next = (uint8_t)((bus->head + 1) % ST7789_QUEUE_LEN);
+
+    /* 队列满：推进已完成的作业直到腾出位置 */
+    while (next == bus->tail) {
+        ST7789_BusPoll(bus);
+    }
+
+    __disable_irq();
+    bus->queue[bus->head] = *job;
+    bus->head = next;
+    uint8_t start = !bus->busy;
+    if (start) bus->busy = 1;               // 占住总线，防止中断里重复启动
+    __enable_irq();
+
+    if (start) bus_start_job(bus);
+    return 0;
+}
+
+/* 为当前作业装载下一块 DMA（每块最多 0xFFFF 个单元） */
+static void bus_kick(st7789_bus_t *bus)
+{
+    const st7789_job_t *job = &bus->queue[bus->tail];
+    uint32_t chunk = (bus->remain > 0xFFFF) ? 0xFFFF : bus->remain;
+    uint32_t src = (job->flags & ST7789_JOB_FILL) ? (uint32_t)&job->color
+                                                  : (uint32_t)bus->cursor;
+
+    LL_DMA_DisableChannel(bus->dma, bus->dma_ch);
+    LL_DMA_SetMemoryAddress(bus->dma, bus->dma_ch, src);
+    LL_DMA_SetDataLength(bus->dma, bus->dma_ch, chunk);
+    LL_DMA_EnableChannel(bus->dma, bus->dma_ch);
+}
+
+/* 开始执行 queue[tail]：选中对应屏、设置窗口、切换位宽后启动 DMA */
+static void bus_start_job(st7789_bus_t *bus)
+{
+    const st7789_job_t *job = &bus->queue[bus->tail];
+    st7789_t *lcd = job->lcd;
+    uint8_t bytes = (job->flags & ST7789_JOB_BYTES) != 0;
+
+    lcd_set_window(lcd, job->xs, job->ys, job->xe, job->ye);
+
+    LL_DMA_DisableChannel(bus->dma, bus->dma_ch);
+    LL_DMA_SetMemoryIncMode(bus->dma, bus->dma_ch,
+        (job->flags & ST7789_JOB_FILL) ? LL_DMA_MEMORY_NOINCREMENT : LL_DMA_MEMORY_INCREMENT);
+    LL_DMA_SetMemorySize(bus->dma, bus->dma_ch, bytes ? LL_DMA_MDATAALIGN_BYTE : LL_DMA_MDATAALIGN_HALFWORD);
+    LL_DMA_SetPeriphSize(bus->dma, bus->dma_ch, bytes ? LL_DMA_PDATAALIGN_BYTE : LL_DMA_PDATAALIGN_HALFWORD);
+
+    if (!bytes) {
+        // 切入 16 位 SPI 模式
+        LL_SPI_Disable(bus->spi);
+        LL_SPI_SetDataWidth(bus->spi, LL_SPI_DATAWIDTH_16BIT);
+        LL_SPI_Enable(bus->spi);
+    }
+
+    bus->remain = job->len;
+    bus->cursor = (const uint8_t *)job->data;
+
+    DC_H(lcd);
+    CS_L(lcd);
+    LL_SPI_EnableDMAReq_TX(bus->spi);
+    bus_kick(bus);
+}
+
+/* 本块 DMA 完成：继续下一块，或结束作业并启动队列中的下一个 */
+static void bus_on_tc(st7789_bus_t *bus)
+{
+    const st7789_job_t *job = &bus->queue[bus->tail];
+    uint32_t chunk = (bus->remain > 0xFFFF) ? 0xFFFF : bus->remain;
+
+    WRITE_REG(bus->dma->IFCR, DMA_IFCR_CGIF1 << BUS_FLAG_SHIFT(bus));
+
+    bus->remain -= chunk;
+    if (!(job->flags & ST7789_JOB_FILL)) {
+        bus->cursor += chunk * ((job->flags & ST7789_JOB_BYTES) ? 1U : 2U);
+    }
+    if (bus->remain) {
+        bus_kick(bus);
+        return;
+    }
+
+    /* 作业结束：等 SPI 移位完成再释放 CS */
+    LCD_WaitTx(bus->spi);
+    LL_DMA_DisableChannel(bus->dma, bus->dma_ch);
+    LL_SPI_DisableDMAReq_TX(bus->spi);
+    CS_H(job->lcd);
+
+    if (!(job->flags & ST7789_JOB_BYTES)) {
+        // 恢复 8 位 SPI 模式
+        LL_SPI_Disable(bus->spi);
+        LL_SPI_SetDataWidth(bus->spi, LL_SPI_DATAWIDTH_8BIT);
+        LL_SPI_Enable(bus->spi);
+    }
+
+    bus->tail = (uint8_t)((bus->tail + 1) % ST7789_QUEUE_LEN);
+    if (bus->tail != bus->head) {
+        bus_start_job(bus);                 // busy 保持为 1
+    } else {
+        bus->busy = 0;
+    }
+}
+
+/* 轮询推进：未使用 DMA 中断时在等待处调用 */
+void ST7789_BusPoll(st7789_bus_t *bus)
+{
+    __disable_irq();
+    if (bus->busy && (READ_REG(bus->dma->ISR) & (DMA_ISR_TCIF1 << BUS_FLAG_SHIFT(bus)))) {
+        bus_on_tc(bus);
+    }
+    __enable_irq();
+}
+
+/* 放入对应 DMA 通道的中断服务函数中 */
+void ST7789_DMA_IRQHandler(st7789_bus_t *bus)
+{
+    if (READ_REG(bus->dma->ISR) & (DMA_ISR_TCIF1 << BUS_FLAG_SHIFT(bus))) {
+        bus_on_tc(bus);
+    }
+}
+
+/* 等待总线上全部作业完成 */
+void ST7789_Sync(st7789_bus_t *bus)
+{
+    while (bus->busy) {
+        ST7789_BusPoll(bus);
+    }
+}
+
+
+
 /* ------------------------------------------------------------------
    初始化硬件函数
    ------------------------------------------------------------------ */
 
 /* 硬件复位 */
-void LCD_Reset(void)
+void LCD_Reset(st7789_t *lcd)
 {
-		RST_H();
+		RST_H(lcd);
 		HAL_Delay(50);
-		RST_L();    //芯片复位
+		RST_L(lcd);    //芯片复位
 		HAL_Delay(50);
-		RST_H();   //启动
+		RST_H(lcd);   //启动
 		HAL_Delay(50);
 }
 /* 初始化 */
-void LCD_Init(uint16_t color)
+void LCD_Init(st7789_t *lcd, uint16_t color)
 {
-		LCD_Reset();
+		LCD_Reset(lcd);
     HAL_Delay(120);
-    LCD_BLK(100);
-    LCD_SendIndex(0x11);
+    LCD_BLK(lcd, 100);
+    LCD_SendIndex(lcd, 0x11);
     HAL_Delay(120);
-    LCD_SendIndex(0x36);
-    if (USE_HORIZONTAL == 0)
-        LCD_SendData(0x00);
-    else if (USE_HORIZONTAL == 1)
-        LCD_SendData(0xC0);
-    else if (USE_HORIZONTAL == 2)
-        LCD_SendData(0x70);
-    else
-        LCD_SendData(0xA0);
-
-    LCD_SendIndex(0x3A);
-    LCD_SendData(0x05);
-
-    LCD_SendIndex(0xB2);
-    LCD_SendData(0x0C);
-    LCD_SendData(0x0C);
-    LCD_SendData(0x00);
-    LCD_SendData(0x33);
-    LCD_SendData(0x33);
-
-    LCD_SendIndex(0xB7);
-    LCD_SendData(0x00);
-
-    LCD_SendIndex(0xBB);
-    LCD_SendData(0x34);
-
-    LCD_SendIndex(0xC0);
-    LCD_SendData(0x2C);
-
-    LCD_SendIndex(0xC2);
-    LCD_SendData(0x01);
-
-    LCD_SendIndex(0xC3);
-    LCD_SendData(0x09);
-
-    LCD_SendIndex(0xC6);
-    LCD_SendData(0x19); // 0F
-
-    LCD_SendIndex(0xD0);
-    LCD_SendData(0xA7);
-
-    LCD_SendIndex(0xD0);
-    LCD_SendData(0xA4);
-    LCD_SendData(0xA1);
-
-    LCD_SendIndex(0xD6);
-    LCD_SendData(0xA1); // sleep in后，gate输出为GND
-
-    LCD_SendIndex(0xE0);
-    LCD_SendData(0xF0);
-    LCD_SendData(0x04);
-    LCD_SendData(0x08);
-    LCD_SendData(0x0A);
-    LCD_SendData(0x0A);
-    LCD_SendData(0x05);
-    LCD_SendData(0x25);
-    LCD_SendData(0x33);
-    LCD_SendData(0x3C);
-    LCD_SendData(0x24);
-    LCD_SendData(0x0E);
-    LCD_SendData(0x0F);
-    LCD_SendData(0x27);
-    LCD_SendData(0x2F);
-
-    LCD_SendIndex(0xE1);
-    LCD_SendData(0xF0);
-    LCD_SendData(0x02);
-    LCD_SendData(0x06);
-    LCD_SendData(0x06);
-    LCD_SendData(0x04);
-    LCD_SendData(0x22);
-    LCD_SendData(0x25);
-    LCD_SendData(0x32);
-    LCD_SendData(0x3B);
-    LCD_SendData(0x3A);
-    LCD_SendData(0x15);
-    LCD_SendData(0x17);
-    LCD_SendData(0x2D);
-    LCD_SendData(0x37);
-
-    LCD_SendIndex(0x21);
-    LCD_SendIndex(0x11);
+    LCD_SendIndex(lcd, 0x36);
+    LCD_SendData(lcd, lcd_madctl[lcd->cfg.rotation]);
+    lcd->win_valid = 0;
+
+    LCD_SendIndex(lcd, 0x3A);
+    LCD_SendData(lcd, 0x05);
+
+    LCD_SendIndex(lcd, 0xB2);
+    LCD_SendData(lcd, 0x0C);
+    LCD_SendData(lcd, 0x0C);
+    LCD_SendData(lcd, 0x00);
+    LCD_SendData(lcd, 0x33);
+    LCD_SendData(lcd, 0x33);
+
+    LCD_SendIndex(lcd, 0xB7);
+    LCD_SendData(lcd, 0x00);
+
+    LCD_SendIndex(lcd, 0xBB);
+    LCD_SendData(lcd, 0x34);
+
+    LCD_SendIndex(lcd, 0xC0);
+    LCD_SendData(lcd, 0x2C);
+
+    LCD_SendIndex(lcd, 0xC2);
+    LCD_SendData(lcd, 0x01);
+
+    LCD_SendIndex(lcd, 0xC3);
+    LCD_SendData(lcd, 0x09);
+
+    LCD_SendIndex(lcd, 0xC6);
+    LCD_SendData(lcd, 0x19); // 0F
+
+    LCD_SendIndex(lcd, 0xD0);
+    LCD_SendData(lcd, 0xA7);
+
+    LCD_SendIndex(lcd, 0xD0);
+    LCD_SendData(lcd, 0xA4);
+    LCD_SendData(lcd, 0xA1);
+
+    LCD_SendIndex(lcd, 0xD6);
+    LCD_SendData(lcd, 0xA1); // sleep in后，gate输出为GND
+
+    LCD_SendIndex(lcd, 0xE0);
+    LCD_SendData(lcd, 0xF0);
+    LCD_SendData(lcd, 0x04);
+    LCD_SendData(lcd, 0x08);
+    LCD_SendData(lcd, 0x0A);
+    LCD_SendData(lcd, 0x0A);
+    LCD_SendData(lcd, 0x05);
+    LCD_SendData(lcd, 0x25);
+    LCD_SendData(lcd, 0x33);
+    LCD_SendData(lcd, 0x3C);
+    LCD_SendData(lcd, 0x24);
+    LCD_SendData(lcd, 0x0E);
+    LCD_SendData(lcd, 0x0F);
+    LCD_SendData(lcd, 0x27);
+    LCD_SendData(lcd, 0x2F);
+
+    LCD_SendIndex(lcd, 0xE1);
+    LCD_SendData(lcd, 0xF0);
+    LCD_SendData(lcd, 0x02);
+    LCD_SendData(lcd, 0x06);
+    LCD_SendData(lcd, 0x06);
+    LCD_SendData(lcd, 0x04);
+    LCD_SendData(lcd, 0x22);
+    LCD_SendData(lcd, 0x25);
+    LCD_SendData(lcd, 0x32);
+    LCD_SendData(lcd, 0x3B);
+    LCD_SendData(lcd, 0x3A);
+    LCD_SendData(lcd, 0x15);
+    LCD_SendData(lcd, 0x17);
+    LCD_SendData(lcd, 0x2D);
+    LCD_SendData(lcd, 0x37);
+
+    LCD_SendIndex(lcd, 0x21);
+    LCD_SendIndex(lcd, 0x11);
     HAL_Delay(120);
-    LCD_Fill(0, 0, LCD_W, LCD_H, color);
-    LCD_SendIndex(0x29); // SET Panel
+    LCD_Fill(lcd, 0, 0, lcd->width, lcd->height, color);
+    LCD_SendIndex(lcd, 0x29); // SET Panel
 }
 
 
@@ -187,66 +382,73 @@ void LCD_Init(uint16_t color)
    控制函数
    ------------------------------------------------------------------ */
 
-/*设置显示区域*/
-void LCD_SetRegion(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye)
+/*
+ * 设置显示窗口（不检查总线，仅供已占用总线的路径调用）
+ * 与上次列/行范围相同时跳过 CASET/RASET，只发 RAMWR
+ */
+static void lcd_set_window(st7789_t *lcd, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye)
 {
-    if (USE_HORIZONTAL == 0)
-    {
-        LCD_SendIndex(0x2a); // 列地址设置
-        LCD_Send16Bit(xs + 34);
-        LCD_Send16Bit(xe + 34);
-        LCD_SendIndex(0x2b); // 行地址设置
-        LCD_Send16Bit(ys);
-        LCD_Send16Bit(ye);
-        LCD_SendIndex(0x2c); // 储存器写
-    }
-    else if (USE_HORIZONTAL == 1)
-    {
-        LCD_SendIndex(0x2a); // 列地址设置
-        LCD_Send16Bit(xs + 34);
-        LCD_Send16Bit(xe + 34);
-        LCD_SendIndex(0x2b); // 行地址设置
-        LCD_Send16Bit(ys);
-        LCD_Send16Bit(ye);
-        LCD_SendIndex(0x2c); // 储存器写
+    SPI_TypeDef *spi = lcd->bus->spi;
+    uint8_t buf[4];
+
+    CS_L(lcd);
+
+    if (!(lcd->win_valid & 0x01) || lcd->win_xs != xs || lcd->win_xe != xe) {
+        uint16_t a = xs + lcd->x_off, b = xe + lcd->x_off;
+        buf[0] = a >> 8; buf[1] = a & 0xFF; buf[2] = b >> 8; buf[3] = b & 0xFF;
+        DC_L(lcd);
+        LL_SPI_TransmitData8(spi, 0x2a); // 列地址设置
+        LCD_WaitTx(spi);
+        DC_H(lcd);
+        for (int i = 0; i < 4; i++) { LL_SPI_TransmitData8(spi, buf[i]); while (!LL_SPI_IsActiveFlag_TXE(spi)) { } }
+        LCD_WaitTx(spi);
+        lcd->win_xs = xs; lcd->win_xe = xe;
+        lcd->win_valid |= 0x01;
     }
-    else if (USE_HORIZONTAL == 2)
-    {
-        LCD_SendIndex(0x2a); // 列地址设置
-        LCD_Send16Bit(xs);
-        LCD_Send16Bit(xe);
-        LCD_SendIndex(0x2b); // 行地址设置
-        LCD_Send16Bit(ys + 34);
-        LCD_Send16Bit(ye + 34);
-        LCD_SendIndex(0x2c); // 储存器写
-    }
-    else
-    {
-        LCD_SendIndex(0x2a); // 列地址设置
-        LCD_Send16Bit(xs);
-        LCD_Send16Bit(xe);
-        LCD_SendIndex(0x2b); // 行地址设置
-        LCD_Send16Bit(ys + 34);
-        LCD_Send16Bit(ye + 34);
-        LCD_SendIndex(0x2c); // 储存器写
+
+    if (!(lcd->win_valid & 0x02) || lcd->win_ys != ys || lcd->win_ye != ye) {
+        uint16_t a = ys + lcd->y_off, b = ye + lcd->y_off;
+        buf[0] = a >> 8; buf[1] = a & 0xFF; buf[2] = b >> 8; buf[3] = b & 0xFF;
+        DC_L(lcd);
+        LL_SPI_TransmitData8(spi, 0x2b); // 行地址设置
+        LCD_WaitTx(spi);
+        DC_H(lcd);
+        for (int i = 0; i < 4; i++) { LL_SPI_TransmitData8(spi, buf[i]); while (!LL_SPI_IsActiveFlag_TXE(spi)) { } }
+        LCD_WaitTx(spi);
+        lcd->win_ys = ys; lcd->win_ye = ye;
+        lcd->win_valid |= 0x02;
     }
+
+    DC_L(lcd);
+    LL_SPI_TransmitData8(spi, 0x2c);     // 储存器写
+    LCD_WaitTx(spi);
+    DC_H(lcd);
+    CS_H(lcd);
+}
+
+/*设置显示区域*/
+void LCD_SetRegion(st7789_t *lcd, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye)
+{
+    if (lcd->bus->busy) ST7789_Sync(lcd->bus);
+    lcd_set_window(lcd, xs, ys, xe, ye);
 }
 
 
 /* 设置光标位置 */
-void LCD_SetCursor(uint16_t x, uint16_t y)
+void LCD_SetCursor(st7789_t *lcd, uint16_t x, uint16_t y)
 {
-    LCD_SetRegion(x, y, x, y);
+    LCD_SetRegion(lcd, x, y, x, y);
 }
 
 
-/*旋转屏幕*/
-void LCD_SpinScreen(uint8_t locate){
-	LCD_SendIndex(0x36);      //屏幕的显示方向、像素读写顺序
-	if(locate==0) LCD_SendData(0xC0); 	  //纵向，左上角（0，0） 
-	if(locate==1) LCD_SendData(0xA0);     //右旋，横向
-	if(locate==2) LCD_SendData(0x00);     //右旋，纵向
-	if(locate==3) LCD_SendData(0x60);     //右旋，横向
+/*旋转屏幕：locate 与 cfg.rotation 同编号（0/1 竖屏，2/3 横屏），同步更新尺寸与显存偏移*/
+void LCD_SpinScreen(st7789_t *lcd, uint8_t locate){
+	if (lcd->bus->busy) ST7789_Sync(lcd->bus);   // 排队中的作业按旧方向的窗口发送
+	lcd->cfg.rotation = locate & 0x03;
+	lcd_apply_rotation(lcd);
+	LCD_SendIndex(lcd, 0x36);      //屏幕的显示方向、像素读写顺序
+	LCD_SendData(lcd, lcd_madctl[lcd->cfg.rotation]);
+	lcd->win_valid = 0;
 }
 /* 设置背光 */
 
@@ -257,8 +459,9 @@ void LCD_SpinScreen(uint8_t locate){
 //}
 
 //有PWM
-void LCD_BLK(uint8_t duty){
-__HAL_TIM_SET_COMPARE(&htim17, TIM_CHANNEL_1, duty);
+void LCD_BLK(st7789_t *lcd, uint8_t duty){
+	if (lcd->cfg.blk_tim == NULL) return;
+	__HAL_TIM_SET_COMPARE(lcd->cfg.blk_tim, lcd->cfg.blk_ch, duty);
 }
 
 
@@ -284,79 +487,44 @@ __HAL_TIM_SET_COMPARE(&htim17, TIM_CHANNEL_1, duty);
 //    }
 //}
 
-void LCD_Fill(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color)
+/*
+ * 填充 [xs, xe) x [ys, ye) 区域
+ * 以 FILL 作业提交后立即返回，颜色由作业保存；多屏共享总线时按提交顺序交替传输
+ */
+void LCD_Fill(st7789_t *lcd, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color)
 {
-    uint32_t total   = (xe - xs) * (ye - ys) + 1;
-    uint32_t remain = total;
-    uint16_t chunk;
-
-    // 设置显示区域
-    LCD_SetRegion(xs, ys, xe - 1, ye - 1);
-    CS_L();
-
-    // 切入 16 位 SPI 模式
-    LL_SPI_Disable(SPI1);
-    LL_SPI_SetDataWidth(SPI1, LL_SPI_DATAWIDTH_16BIT);
-    LL_SPI_Enable(SPI1);
-
-	
-    LL_DMA_SetMemoryAddress(DMA1, LL_DMA_CHANNEL_2, (uint32_t)&color);	//仅设置一次颜色
-    while (remain)
-    {
-        // 每次最多传输 0xFFFF 个 halfword
-        chunk = (remain > 0xFFFF) ? 0xFFFF : remain;
-
-        // 配置 DMA 参数（只需更新长度和内存地址）
-//      LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_2);//确保在关闭时更改参数
-        LL_DMA_SetPeriphAddress(DMA1, LL_DMA_CHANNEL_2, (uint32_t)&SPI1->DR);
-        LL_DMA_SetDataLength(DMA1, LL_DMA_CHANNEL_2, chunk);
-
-        // 使能 SPI 的 TX DMA 请求
-        LL_SPI_EnableDMAReq_TX(SPI1);
-
-        // 使能 DMA 通道
-        LL_DMA_EnableChannel(DMA1, LL_DMA_CHANNEL_2);
-
-        // 等待本块传输完成
-        while (!LL_DMA_IsActiveFlag_TC2(DMA1)) { }
-        LL_DMA_ClearFlag_TC2(DMA1);
-				LL_DMA_ClearFlag_HT2(DMA1);
-				LL_DMA_ClearFlag_TE2(DMA1);
-
-
-        // 关闭 DMA 通道和 SPI DMA 请求
-        LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_2);
-        LL_SPI_DisableDMAReq_TX(SPI1);
-
-        remain -= chunk;
-    }
-
-    // 恢复 8 位 SPI 模式
-    LL_SPI_Disable(SPI1);
-    LL_SPI_SetDataWidth(SPI1, LL_SPI_DATAWIDTH_8BIT);
-    LL_SPI_Enable(SPI1);
-
-    CS_H();
+    if (xe <= xs || ye <= ys) return;
+
+    st7789_job_t job = {
+        .lcd   = lcd,
+        .xs    = xs,     .ys = ys,
+        .xe    = xe - 1, .ye = ye - 1,
+        .data  = NULL,
+        .len   = (uint32_t)(xe - xs) * (uint32_t)(ye - ys),
+        .color = color,
+        .flags = ST7789_JOB_FILL,
+    };
+    ST7789_Submit(&job);
 }
 
 
 /* 清屏 */
-void LCD_Clear(uint16_t color)
+void LCD_Clear(st7789_t *lcd, uint16_t color)
 {
-    LCD_Fill(0, 0, LCD_W, LCD_H, color);
+    LCD_Fill(lcd, 0, 0, lcd->width, lcd->height, color);
 }
 
 
 /* 画点 */
-void LCD_DrawPoint(uint16_t x, uint16_t y, uint16_t color)
+void LCD_DrawPoint(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t color)
 {
-    LCD_SetCursor(x, y);
-    LCD_Send16Bit(color);
+    LCD_SetCursor(lcd, x, y);
+    LCD_Send16Bit(lcd, color);
 }
 
 
 /* 空心圆，支持厚度，避免边角漏点 */
-void LCD_DrawCircle(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8_t thickness)
+void LCD_DrawCircle(st7789_t *lcd, uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8_t thickness)
 {
     if (thickness < 1) thickness = 1;
 
@@ -369,7 +537,7 @@ void LCD_DrawCircle(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8_t thi
 
             // 在外圆内 && 在内圆外 → 属于圆环区域
             if (dist2 <= r_outer2 && dist2 >= r_inner2) {
-                LCD_DrawPoint(X + dx, Y + dy, fc);
+                LCD_DrawPoint(lcd, X + dx, Y + dy, fc);
             }
         }
     }
@@ -379,7 +547,7 @@ void LCD_DrawCircle(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8_t thi
 #define M_PI 3.14159265358979323846 
 #endif
 /* 虚线圆，支持厚度和虚线段数 */
-void LCD_DrawDashedCircle(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8_t thickness, uint8_t segments)
+void LCD_DrawDashedCircle(st7789_t *lcd, uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8_t thickness, uint8_t segments)
 {
     if (thickness < 1) thickness = 1;
     if (segments < 1) segments = 1;
@@ -402,7 +570,7 @@ void LCD_DrawDashedCircle(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8
 
                 // 偶数段绘制，奇数段空白 → 形成虚线
                 if (segIndex % 2 == 0) {
-                    LCD_DrawPoint(X + dx, Y + dy, fc);
+                    LCD_DrawPoint(lcd, X + dx, Y + dy, fc);
                 }
             }
         }
@@ -410,7 +578,7 @@ void LCD_DrawDashedCircle(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8
 }
 
 /* 实心圆 */
-void LCD_DrawCircle_Fill(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc)
+void LCD_DrawCircle_Fill(st7789_t *lcd, uint16_t X, uint16_t Y, uint16_t R, uint16_t fc)
 {
     unsigned short a = 0, b = R;
     int c = 3 - 2 * R;
@@ -418,10 +586,10 @@ void LCD_DrawCircle_Fill(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc)
     while (a <= b)
     {
         // 在对称的八个方向上画水平线段，而不是单点
-        LCD_DrawLine(X - a, Y - b, X + a, Y - b, fc); // 上
-        LCD_DrawLine(X - a, Y + b, X + a, Y + b, fc); // 下
-        LCD_DrawLine(X - b, Y - a, X + b, Y - a, fc); // 左上
-        LCD_DrawLine(X - b, Y + a, X + b, Y + a, fc); // 左下
+        LCD_DrawLine(lcd, X - a, Y - b, X + a, Y - b, fc); // 上
+        LCD_DrawLine(lcd, X - a, Y + b, X + a, Y + b, fc); // 下
+        LCD_DrawLine(lcd, X - b, Y - a, X + b, Y - a, fc); // 左上
+        LCD_DrawLine(lcd, X - b, Y + a, X + b, Y + a, fc); // 左下
 
         if (c < 0)
         {
@@ -438,7 +606,7 @@ void LCD_DrawCircle_Fill(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc)
 
 
 /* 直线 */
-void LCD_DrawLine(uint16_t x0, uint16_t y0,uint16_t x1, uint16_t y1,uint16_t Color)
+void LCD_DrawLine(st7789_t *lcd, uint16_t x0, uint16_t y0,uint16_t x1, uint16_t y1,uint16_t Color)
 {
 	int dx,            // difference in x's
     dy,             // difference in y's
@@ -449,7 +617,7 @@ void LCD_DrawLine(uint16_t x0, uint16_t y0,uint16_t x1, uint16_t y1,uint16_t Col
     error,          // the discriminant i.e. error i.e. decision variable
     index;          // used for looping	
 
-	LCD_SetCursor(x0,y0);
+	LCD_SetCursor(lcd, x0,y0);
 	dx = x1-x0;//计算x距离
 	dy = y1-y0;//计算y距离
 
@@ -469,7 +637,7 @@ void LCD_DrawLine(uint16_t x0, uint16_t y0,uint16_t x1, uint16_t y1,uint16_t Col
 	{           //且线的点数等于x距离，以x轴递增画点
 		error = dy2 - dx; 
 		for (index=0; index <= dx; index++){
-			LCD_DrawPoint(x0,y0,Color);
+			LCD_DrawPoint(lcd, x0,y0,Color);
 			if (error >= 0)
 			{
 				error-=dx2;
@@ -486,7 +654,7 @@ void LCD_DrawLine(uint16_t x0, uint16_t y0,uint16_t x1, uint16_t y1,uint16_t Col
 		// draw the line
 		for (index=0; index <= dy; index++)
 		{
-			LCD_DrawPoint(x0,y0,Color);
+			LCD_DrawPoint(lcd, x0,y0,Color);
 			if (error >= 0){
 				error-=dy2;
 				x0+=x_inc;
@@ -498,7 +666,7 @@ void LCD_DrawLine(uint16_t x0, uint16_t y0,uint16_t x1, uint16_t y1,uint16_t Col
 }
 
 /* 空心矩形，支持厚度 */
-void LCD_DrawRect(uint16_t X, uint16_t Y,
+void LCD_DrawRect(st7789_t *lcd, uint16_t X, uint16_t Y,
                   uint16_t W, uint16_t H,
                   uint16_t fc, uint8_t thickness)
 {
@@ -507,54 +675,54 @@ void LCD_DrawRect(uint16_t X, uint16_t Y,
     // 上边框
     for (uint16_t dy = 0; dy < thickness; dy++) {
         for (uint16_t dx = 0; dx < W; dx++) {
-            LCD_DrawPoint(X + dx, Y + dy, fc);
+            LCD_DrawPoint(lcd, X + dx, Y + dy, fc);
         }
     }
 
     // 下边框
     for (uint16_t dy = 0; dy < thickness; dy++) {
         for (uint16_t dx = 0; dx < W; dx++) {
-            LCD_DrawPoint(X + dx, Y + H - 1 - dy, fc);
+            LCD_DrawPoint(lcd, X + dx, Y + H - 1 - dy, fc);
         }
     }
 
     // 左边框
     for (uint16_t dx = 0; dx < thickness; dx++) {
         for (uint16_t dy = 0; dy < H; dy++) {
-            LCD_DrawPoint(X + dx, Y + dy, fc);
+            LCD_DrawPoint(lcd, X + dx, Y + dy, fc);
         }
     }
 
     // 右边框
     for (uint16_t dx = 0; dx < thickness; dx++) {
         for (uint16_t dy = 0; dy < H; dy++) {
-            LCD_DrawPoint(X + W - 1 - dx, Y + dy, fc);
+            LCD_DrawPoint(lcd, X + W - 1 - dx, Y + dy, fc);
         }
     }
 }
 
 /* 顶点三角形 */
-void LCD_DrawTriangel(uint16_t x, uint16_t y, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color)
+void LCD_DrawTriangel(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color)
 {
-    LCD_DrawLine(x, y, xs, ys, color);
-    LCD_DrawLine(xs, ys, xe, ye, color);
-    LCD_DrawLine(xe, ye, x, y, color);
+    LCD_DrawLine(lcd, x, y, xs, ys, color);
+    LCD_DrawLine(lcd, xs, ys, xe, ye, color);
+    LCD_DrawLine(lcd, xe, ye, x, y, color);
 }
 
 /* 实心矩形 */
-void LCD_DrawRect_Fill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t bc) 
+void LCD_DrawRect_Fill(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t bc) 
 {
-LCD_Fill(x,y, x + w, y + h, bc);
+LCD_Fill(lcd, x,y, x + w, y + h, bc);
 }
 
 /* 圆角矩形 */
-void LCD_FillRoundRect(uint16_t x, uint16_t y,
+void LCD_FillRoundRect(st7789_t *lcd, uint16_t x, uint16_t y,
                        uint16_t w, uint16_t h,
                        uint16_t r, uint16_t color)
 {
     // 如果半径为 0，当成普通矩形处理
     if (r == 0) {
-        LCD_Fill(x, y, x + w, y + h, color);
+        LCD_Fill(lcd, x, y, x + w, y + h, color);
         return;
     }
 
@@ -563,11 +731,11 @@ void LCD_FillRoundRect(uint16_t x, uint16_t y,
     if (r > h / 2) r = h / 2;
 
     // 1. 填充中间宽条矩形
-    LCD_Fill(x + r,      y, x + w - r,   y + h,     color);
+    LCD_Fill(lcd, x + r,      y, x + w - r,   y + h,     color);
 
     // 2. 填充左右竖条矩形
-    LCD_Fill(x,          y + r, x + r,       y + h - r, color);
-    LCD_Fill(x + w - r,  y + r, x + w,       y + h - r, color);
+    LCD_Fill(lcd, x,          y + r, x + r,       y + h - r, color);
+    LCD_Fill(lcd, x + w - r,  y + r, x + w,       y + h - r, color);
 
     // 3. 填充四个圆角
     for (int16_t dy = 0; dy < r; dy++) {
@@ -575,18 +743,18 @@ void LCD_FillRoundRect(uint16_t x, uint16_t y,
                           - (r - 1 - dy) * (r - 1 - dy)) + 0.5);
 
         // 上半圆：左、右两个角
-        LCD_Fill(x + r - dx,        y + dy, x + r,        y + dy + 1, color);
-        LCD_Fill(x + w - r,         y + dy, x + w - r + dx, y + dy + 1, color);
+        LCD_Fill(lcd, x + r - dx,        y + dy, x + r,        y + dy + 1, color);
+        LCD_Fill(lcd, x + w - r,         y + dy, x + w - r + dx, y + dy + 1, color);
 
         // 下半圆：左、右两个角
-        LCD_Fill(x + r - dx,        y + h - dy - 1, x + r,        y + h - dy, color);
-        LCD_Fill(x + w - r,         y + h - dy - 1, x + w - r + dx, y + h - dy, color);
+        LCD_Fill(lcd, x + r - dx,        y + h - dy - 1, x + r,        y + h - dy, color);
+        LCD_Fill(lcd, x + w - r,         y + h - dy - 1, x + w - r + dx, y + h - dy, color);
     }
 }
 
 
 /* 空心圆角矩形 */
-void LCD_DrawRoundRectStroke(uint16_t x, uint16_t y,
+void LCD_DrawRoundRectStroke(st7789_t *lcd, uint16_t x, uint16_t y,
                              uint16_t w, uint16_t h,
                              uint16_t r, uint16_t t,
                              uint16_t color)
@@ -645,17 +813,17 @@ void LCD_DrawRoundRectStroke(uint16_t x, uint16_t y,
 
             // 左条：从外左到内左-1
             for (uint16_t xx = x0; xx < xi0; xx++) {
-                LCD_DrawPoint(xx, Y, color);
+                LCD_DrawPoint(lcd, xx, Y, color);
             }
             // 右条：从内右+1 到外右
             for (uint16_t xx = xi1 + 1; xx <= x1; xx++) {
-                LCD_DrawPoint(xx, Y, color);
+                LCD_DrawPoint(lcd, xx, Y, color);
             }
         }
         else {
             // 不在内圆角影响区，整条都画
             for (uint16_t xx = x0; xx <= x1; xx++) {
-                LCD_DrawPoint(xx, Y, color);
+                LCD_DrawPoint(lcd, xx, Y, color);
             }
         }
     }
@@ -669,65 +837,34 @@ void LCD_DrawRoundRectStroke(uint16_t x, uint16_t y,
    ------------------------------------------------------------------ */
 
 /* 显示图像 @ RGB565 */
-void LCD_ShowImage(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t *p)
+void LCD_ShowImage(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t *p)
 {
-    LCD_SetRegion(x, y, x + width - 1, y + height - 1);
+    LCD_SetRegion(lcd, x, y, x + width - 1, y + height - 1);
     for (uint32_t i = 0; i < width * height * 2; i++)
     {
-        LCD_SendData(p[i]);
+        LCD_SendData(lcd, p[i]);
     }
 }
 
 
-void LCD_ShowPicture(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t pic[])
+/*
+ * DMA 显示图片（RGB565 大端字节流）
+ * 提交后立即返回，pic 在传输完成前须保持有效（常量图片无需关心），
+ * 需要复用缓冲时先调用 ST7789_Sync
+ */
+void LCD_ShowPicture(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t pic[])
 {
-    uint32_t num  = width * height * 2;   // 总字节数（RGB565 每像素 2 字节）
-    uint32_t num1;
-
-    // 设置显示区域
-    LCD_SetRegion(x, y, x + width - 1, y + height - 1);
-    CS_L();
-
-    // 开启 SPI 的 TX DMA 请求
-    LL_SPI_EnableDMAReq_TX(SPI1);
-
-    while (num > 0)
-    {
-        // 每次最多传输 65534 字节
-        if (num > 65534)
-        {
-            num1 = 65534;
-            num -= 65534;
-        }
-        else
-        {
-            num1 = num;
-            num  = 0;
-        }
-
-        // 更新 DMA 内存地址和传输长度
-        LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_2);
-        LL_DMA_SetMemoryAddress(DMA1, LL_DMA_CHANNEL_2, (uint32_t)pic);
-        LL_DMA_SetDataLength(DMA1, LL_DMA_CHANNEL_2, num1);
-
-        // 使能 DMA 通道
-        LL_DMA_EnableChannel(DMA1, LL_DMA_CHANNEL_2);
-
-        // 等待传输完成
-        while (!LL_DMA_IsActiveFlag_TC3(DMA1)) { }
-        LL_DMA_ClearFlag_TC3(DMA1);
-
-        // 关闭 DMA 通道（准备下一批）
-        LL_DMA_DisableChannel(DMA1, LL_DMA_CHANNEL_2);
-
-        // 更新图片指针
-        pic += num1;
-    }
-
-    // 关闭 SPI 的 TX DMA 请求
-    LL_SPI_DisableDMAReq_TX(SPI1);
-
-    CS_H();
+    if (width == 0 || height == 0) return;
+
+    st7789_job_t job = {
+        .lcd   = lcd,
+        .xs    = x,             .ys = y,
+        .xe    = x + width - 1, .ye = y + height - 1,
+        .data  = pic,
+        .len   = (uint32_t)width * height * 2,   // 总字节数（RGB565 每像素 2 字节）
+        .flags = ST7789_JOB_BYTES,
+    };
+    ST7789_Submit(&job);
 }
 
 /* 进度条 */
@@ -757,7 +894,7 @@ void ProgressBar_Init(
 }
 
 /** 更新进度条（只传入当前值） */
-void ProgressBar_Update(ProgressBar *pb, float cur_val)
+void ProgressBar_Update(st7789_t *lcd, ProgressBar *pb, float cur_val)
 {
     /* 1. 计算比例 */
     float ratio = (cur_val - pb->min_val) / (pb->max_val - pb->min_val);
@@ -773,9 +910,9 @@ void ProgressBar_Update(ProgressBar *pb, float cur_val)
 
     /* 4. 绘制增量或清除多余 */
     if (delta > 0) {
-        LCD_DrawRect_Fill(pb->x + pb->prev_len, pb->y, delta, pb->height, pb->fg_color);
+        LCD_DrawRect_Fill(lcd, pb->x + pb->prev_len, pb->y, delta, pb->height, pb->fg_color);
     } else {
-        LCD_DrawRect_Fill(pb->x + new_len, pb->y, (uint16_t)(-delta), pb->height, pb->bg_color);
+        LCD_DrawRect_Fill(lcd, pb->x + new_len, pb->y, (uint16_t)(-delta), pb->height, pb->bg_color);
     }
 
     /* 5. 更新状态 */
@@ -808,7 +945,7 @@ int findCharPos(const char* sample, const char* target)
  * h: 字符高度（像素）
  * fc: 前景色，bc: 背景色）
  */
-void LCD_ShowChar(const char *sample,
+void LCD_ShowChar(st7789_t *lcd, const char *sample,
                   const unsigned char *data,
                   uint8_t h, uint8_t w,
                   uint16_t x, uint16_t y,
@@ -842,14 +979,14 @@ void LCD_ShowChar(const char *sample,
             bool pixel = (b & bit_mask) != 0;
 
             if (pixel)
-                LCD_DrawPoint((uint16_t)(x + col), (uint16_t)(y + row), fc);
+                LCD_DrawPoint(lcd, (uint16_t)(x + col), (uint16_t)(y + row), fc);
             else
-                LCD_DrawPoint((uint16_t)(x + col), (uint16_t)(y + row), bc);
+                LCD_DrawPoint(lcd, (uint16_t)(x + col), (uint16_t)(y + row), bc);
         }
     }
 }
 
-void LCD_ShowString(const char *sample,
+void LCD_ShowString(st7789_t *lcd, const char *sample,
                   const unsigned char *data,
                   uint8_t h, uint8_t w,
                   uint16_t x, uint16_t y,
@@ -857,7 +994,7 @@ void LCD_ShowString(const char *sample,
                   char* str)
 {
     while (*str) {
-        LCD_ShowChar(sample, data, h, w, x, y, fc, bc, *str++);
+        LCD_ShowChar(lcd, sample, data, h, w, x, y, fc, bc, *str++);
         x += w;
     }
 	
@@ -865,48 +1002,11 @@ void LCD_ShowString(const char *sample,
 /*-------------------
 		XL 64*48
 -------------------*/
-void LCD_ShowChar_48_64(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, char c)
-{
-    /* 如果字符是 ASCII 空格，直接跳过不绘制 */
-    if (c == ' ') return;
-
-    /* 处理不可打印字符，映射到 '?' */
-    unsigned char uc = (unsigned char)c;
-    if (uc < 32 || uc > 126) uc = '?';
-
-    /* 使用以 '\0' 结尾的临时字符串传入 findCharPos，避免传入非终止字符串 */
-    char t[2] = { (char)uc, '\0' };
-    int pos = findCharPos(h48w64_sample, t);
-    if (pos < 0) {
-        /* 找不到就尝试用 '?' 替代；若 '?' 也没定义则直接返回（不绘制） */
-        char q[2] = { '?', '\0' };
-        pos = findCharPos(h48w64_sample, q);
-        if (pos < 0) return;
-    }
-
-    /* 每字符占 384 字节 (48 行 × 8 字节) */
-    uint32_t base = (uint32_t)pos * 384U;
-
-    for (int row = 0; row < 48; row++) {               /* 48 行 */
-        uint32_t row_base = base + (uint32_t)row * 8U; /* 每行 8 字节 */
-        for (int col = 0; col < 64; col++) {           /* 64 列 */
-            uint32_t byte_idx = row_base + (uint32_t)(col >> 3);
-            uint8_t b = h48w64[byte_idx];
-            uint8_t bit_mask = (uint8_t)(0x80 >> (col & 0x07));
-            bool pixel = (b & bit_mask) != 0;
-
-            if (pixel)
-                LCD_DrawPoint((uint16_t)(x + col), (uint16_t)(y + row), fc);
-            else
-                LCD_DrawPoint((uint16_t)(x + col), (uint16_t)(y + row), bc);
-        }
-    }
-}
-
-void LCD_ShowString_48_64(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, const char *str)
+void LCD_ShowString_48_64(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, const char *str)
 {
     while (*str) {
-        LCD_ShowChar_48_64(x, y, fc, bc, *str++);
+        if (*str != ' ') LCD_DrawGlyph(lcd, &LCD_FONT_48_64, x, y, fc, bc, *str);
+        str++;
         x += 64;
     }
 }
@@ -916,35 +1016,11 @@ void LCD_ShowString_48_64(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, cons
 /*-------------------
 		L 32*16
 -------------------*/
-void LCD_ShowChar_32_16(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, char c)
-{
-    // 在 h32w16_sample[] 中查找字符位置
-    int pos = findCharPos(h32w16_sample, &c);
-    if (pos < 0) {
-        // 找不到就用 '?'
-        pos = findCharPos(h32w16_sample, "?");
-        if (pos < 0) return; // 如果 '?' 也没定义，直接返回
-    }
-
-    // 每字符占 64 字节 (32 行 × 2 字节)
-    uint32_t base = pos * 64;
-
-    for (uint8_t i = 0; i < 32; i++) {         // 32 行
-        uint16_t row_data = (h32w16[base + 2*i] << 8) | h32w16[base + 2*i + 1];
-        for (uint8_t j = 0; j < 16; j++) {     // 16 列
-            if (row_data & (0x8000 >> j))
-                LCD_DrawPoint(x + j, y + i, fc);
-            else
-                LCD_DrawPoint(x + j, y + i, bc);
-        }
-    }
-}
-
-
-void LCD_ShowString_32_16(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, const char *s)
+void LCD_ShowString_32_16(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, const char *s)
 {
     while (*s) {
-        LCD_ShowChar_32_16(x, y, fc, bc, *s++);
+        if (*s != ' ') LCD_DrawGlyph(lcd, &LCD_FONT_32_16, x, y, fc, bc, *s);
+        s++;
         x += 16;  // 字符宽度为 16
     }
 }
@@ -954,43 +1030,11 @@ void LCD_ShowString_32_16(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, cons
 /*-------------------
 		M 24*12
 -------------------*/
-void LCD_ShowChar_24_12(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, char c)
-{
-    // 在 h24w12_sample[] 中查找字符位置
-    int pos = findCharPos(h24w12_sample, &c);
-    if (pos < 0) {
-        // 找不到就用 '?'
-        pos = findCharPos(h24w12_sample, "x");
-        if (pos < 0) return; // 如果 '?' 也没定义，直接返回
-    }
-
-    // 每字符占 48 字节 (24 行 × 2 字节)
-    uint16_t base = pos * 48;
-
-    for (int i = 0; i < 24; i++) {        // 24 行
-        for (int j = 0; j < 12; j++) {    // 12 列
-            bool pixel;
-            if (j < 8) {
-                // 前 8 列取第 0 字节
-                pixel = h24w12[base + 2*i] & (0x80 >> j);
-            } else {
-                // 后 4 列取第 1 字节
-                pixel = h24w12[base + 2*i + 1] & (0x80 >> (j - 8));
-            }
-            if (pixel)
-                LCD_DrawPoint(x + j, y + i, fc);
-            else
-                LCD_DrawPoint(x + j, y + i, bc);
-        }
-    }
-}
-
-
-void LCD_ShowString_24_12(uint16_t x, uint16_t y,  uint16_t fc, uint16_t bc,  const char *c)
+void LCD_ShowString_24_12(st7789_t *lcd, uint16_t x, uint16_t y,  uint16_t fc, uint16_t bc,  const char *c)
 {
     int len = strlen(c);  // 字符串长度
     for (int i = 0; i < len; i++) {
-        LCD_ShowChar_24_12(x, y, fc, bc, c[i]);
+        if (c[i] != ' ') LCD_DrawGlyph(lcd, &LCD_FONT_24_12, x, y, fc, bc, c[i]);
         x += 12;           // 字符宽度为 12
     }
 }
@@ -1000,35 +1044,11 @@ void LCD_ShowString_24_12(uint16_t x, uint16_t y,  uint16_t fc, uint16_t bc,  co
 		S 16*8
 -------------------*/
 
-void LCD_ShowChar_16_8(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, char c)
-{
-    // 在 h16w8_sample[] 中查找字符位置
-    int pos = findCharPos(h16w8_sample, &c);
-    if (pos < 0) {
-        // 找不到就用 '?'
-        pos = findCharPos(h16w8_sample, "?");
-        if (pos < 0) return; // 如果 '?' 也没定义，直接返回
-    }
-
-    // 每字符占 16 字节
-    int k = pos * 16;
-
-    for (int i = 0; i < 16; i++) {       // 16 行
-        for (int j = 0; j < 8; j++) {    // 8 列
-            if (h16w8[k + i] & (0x80 >> j))
-                LCD_DrawPoint(x + j, y + i, fc);
-            else
-                LCD_DrawPoint(x + j, y + i, bc);
-        }
-    }
-}
-
-
-void LCD_ShowString_16_8(uint16_t x,uint16_t y,uint16_t fc,uint16_t bc,char *c)
+void LCD_ShowString_16_8(st7789_t *lcd, uint16_t x,uint16_t y,uint16_t fc,uint16_t bc,char *c)
 {
 	int t=strlen(c);
 	for(int i=0;i<t;i++){
-		LCD_ShowChar_16_8(x,y,fc,bc,c[i]);
+		if (c[i] != ' ') LCD_DrawGlyph(lcd, &LCD_FONT_16_8, x,y,fc,bc,c[i]);
 		x+=8;     //字符的宽度为8 
 	}		
 }
@@ -1036,37 +1056,215 @@ void LCD_ShowString_16_8(uint16_t x,uint16_t y,uint16_t fc,uint16_t bc,char *c)
 /*-------------------
 		XS 12*6
 -------------------*/
-void LCD_ShowChar_12_6(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, char c)
+void LCD_ShowString_12_6(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, const char *str)
 {
-    // 在 h12w6_sample[] 中查找字符位置
-    int pos = findCharPos(h12w6_sample, &c);
-    if (pos < 0) {
-        // 找不到就用 '?'
-        pos = findCharPos(h12w6_sample, "?");
-        if (pos < 0) return; // 如果 '?' 也没定义，直接返回
+    while (*str) {
+        if (*str != ' ') LCD_DrawGlyph(lcd, &LCD_FONT_12_6, x, y, fc, bc, *str);
+        str++;
+        x += 6;  // 宽度为 6
     }
 
-    // 每字符占 12 字节
-    int k = pos * 12;
+}
 
-    for (int i = 0; i < 12; i++) {    // 12 行
-        for (int j = 0; j < 6; j++) { // 6 列
-            if (h12w6[k + i] & (0x80 >> j))
-                LCD_DrawPoint(x + j, y + i, fc);
-            else
-                LCD_DrawPoint(x + j, y + i, bc);
+
+/* ------------------------------------------------------------------
+  文字排版
+   ------------------------------------------------------------------ */
+
+const lcd_font_t LCD_FONT_48_64 = { h48w64_sample, h48w64, 64, 48, 8, '?' };
+const lcd_font_t LCD_FONT_32_16 = { h32w16_sample, h32w16, 16, 32, 2, '?' };
+const lcd_font_t LCD_FONT_24_12 = { h24w12_sample, h24w12, 12, 24, 2, 'x' };  // 该字模表没有 '?'
+const lcd_font_t LCD_FONT_16_8  = { h16w8_sample,  h16w8,   8, 16, 1, '?' };
+const lcd_font_t LCD_FONT_12_6  = { h12w6_sample,  h12w6,   6, 12, 1, '?' };
+
+#if LCD_GLYPH_CACHE_NUM > 0
+/* 字形缓存条目：展开后的点阵即 DMA 源数据 */
+typedef struct {
+    const lcd_font_t *font;        // NULL 表示空闲
+    st7789_bus_t     *bus;         // 最近一次发送所用总线，淘汰前需等待其完成
+    uint32_t          stamp;       // LRU 时间戳
+    uint16_t          fc, bc;
+    char              ch;
+    uint16_t          px[LCD_GLYPH_MAX_PX];
+} lcd_glyph_t;
+
+static lcd_glyph_t glyph_cache[LCD_GLYPH_CACHE_NUM];
+static uint32_t    glyph_clock;
+#endif
+static uint32_t    glyph_hits, glyph_misses;
+
+/* 字符串像素宽度（等宽字体） */
+uint16_t LCD_TextWidth(const lcd_font_t *font, const char *s)
+{
+    if (font == NULL || s == NULL) return 0;
+    return (uint16_t)(strlen(s) * font->w);
+}
+
+#if LCD_GLYPH_CACHE_NUM > 0
+/* 查找或展开字形；返回 NULL 表示字形过大不缓存 */
+static const lcd_glyph_t *glyph_lookup(const lcd_font_t *font, int pos, char c, uint16_t fc, uint16_t bc)
+{
+    uint32_t npx = (uint32_t)font->w * font->h;
+    if (npx > LCD_GLYPH_MAX_PX) return NULL;
+
+    lcd_glyph_t *victim = &glyph_cache[0];
+    for (int i = 0; i < LCD_GLYPH_CACHE_NUM; i++) {
+        lcd_glyph_t *g = &glyph_cache[i];
+        if (g->font == font && g->ch == c && g->fc == fc && g->bc == bc) {
+            g->stamp = ++glyph_clock;
+            glyph_hits++;
+            return g;
+        }
+        if (g->font == NULL) {
+            victim = g;                        // 优先使用空闲条目
+        } else if (victim->font != NULL && g->stamp < victim->stamp) {
+            victim = g;
         }
     }
+
+    /* 未命中：淘汰最久未用条目，其点阵可能仍在 DMA 队列中 */
+    glyph_misses++;
+    if (victim->bus) ST7789_Sync(victim->bus);
+
+    const unsigned char *src = font->data + (uint32_t)pos * font->row_bytes * font->h;
+    uint16_t *dst = victim->px;
+    for (uint32_t row = 0; row < font->h; row++) {
+        for (uint32_t col = 0; col < font->w; col++) {
+            *dst++ = (src[col >> 3] & (0x80 >> (col & 0x07))) ? fc : bc; /* MSB-first */
+        }
+        src += font->row_bytes;
+    }
+
+    victim->font  = font;
+    victim->bus   = NULL;
+    victim->ch    = c;
+    victim->fc    = fc;
+    victim->bc    = bc;
+    victim->stamp = ++glyph_clock;
+    return victim;
 }
+#endif
 
+/*
+ * 绘制单个字符（不透明）
+ * 空格以背景色填充整格；字模表中不存在的字符用 font->missing 代替
+ */
+void LCD_DrawGlyph(st7789_t *lcd, const lcd_font_t *font, uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, char c)
+{
+    int pos = (c == ' ') ? -1 : findCharPos(font->sample, &c);
+    if (pos < 0 && c != ' ') {
+        c   = font->missing;
+        pos = findCharPos(font->sample, &c);
+    }
+    if (pos < 0) {
+        LCD_Fill(lcd, x, y, x + font->w, y + font->h, bc);
+        return;
+    }
 
-void LCD_ShowString_12_6(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, const char *str)
+#if LCD_GLYPH_CACHE_NUM > 0
+    const lcd_glyph_t *g = glyph_lookup(font, pos, c, fc, bc);
+    if (g == NULL)
+#endif
+    {
+        /* 未开启缓存或大字形：逐点绘制 */
+        LCD_ShowChar(lcd, font->sample, font->data, font->h, font->w, x, y, fc, bc, c);
+        return;
+    }
+#if LCD_GLYPH_CACHE_NUM > 0
+
+    st7789_job_t job = {
+        .lcd  = lcd,
+        .xs   = x,                .ys = y,
+        .xe   = x + font->w - 1,  .ye = y + font->h - 1,
+        .data = g->px,
+        .len  = (uint32_t)font->w * font->h,
+    };
+    ((lcd_glyph_t *)g)->bus = lcd->bus;
+    ST7789_Submit(&job);
+#endif
+}
+
+/* 从 (x, y) 起连续绘制字符串 */
+void LCD_DrawText(st7789_t *lcd, const lcd_font_t *font, uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, const char *s)
 {
-    while (*str) {
-        LCD_ShowChar_12_6(x, y, fc, bc, *str++);
-        x += 6;  // 宽度为 6
+    while (*s) {
+        LCD_DrawGlyph(lcd, font, x, y, fc, bc, *s++);
+        x += font->w;
     }
+}
+
+/*
+ * 在定宽字段内按对齐方式绘制字符串
+ * 字段外的字符被裁掉，字段内空余格用背景色补齐
+ */
+void LCD_FieldDraw(st7789_t *lcd, const lcd_field_t *fd, const char *s)
+{
+    const lcd_font_t *f = fd->font;
+    int len = (int)strlen(s);
+    int start;
+
+    switch (fd->align) {
+        case LCD_ALIGN_RIGHT:
+            start = fd->cells - len;
+            break;
+        case LCD_ALIGN_CENTER:
+            start = (fd->cells - len) / 2;
+            break;
+        case LCD_ALIGN_DECIMAL: {
+            const char *dp = strchr(s, '.');
+            int int_len = dp ? (int)(dp - s) : len;
+            start = fd->dp_cell - int_len;
+            break;
+        }
+        case LCD_ALIGN_LEFT:
+        default:
+            start = 0;
+            break;
+    }
+
+    /* 可见范围 [first, last) 对应字符串下标 */
+    int first = (start < 0) ? -start : 0;
+    int last  = len;
+    if (start + last > fd->cells) last = fd->cells - start;
 
+    int cell_lo = start + first;          // 第一个文字格
+    int cell_hi = start + last;           // 最后一个文字格之后
+    if (cell_hi < cell_lo) cell_lo = cell_hi = (start < 0) ? 0 : start;
+    if (cell_lo > fd->cells) cell_lo = cell_hi = fd->cells;
+
+    /* 左侧留白 */
+    if (cell_lo > 0) {
+        LCD_Fill(lcd, fd->x, fd->y, fd->x + cell_lo * f->w, fd->y + f->h, fd->bc);
+    }
+
+    for (int i = first; i < last; i++) {
+        LCD_DrawGlyph(lcd, f, fd->x + (start + i) * f->w, fd->y, fd->fc, fd->bc, s[i]);
+    }
+
+    /* 右侧留白 */
+    if (cell_hi < fd->cells) {
+        LCD_Fill(lcd, fd->x + cell_hi * f->w, fd->y, fd->x + fd->cells * f->w, fd->y + f->h, fd->bc);
+    }
+}
+
+/* 清空字形缓存（改调色板或换字库后调用） */
+void LCD_GlyphCacheClear(void)
+{
+#if LCD_GLYPH_CACHE_NUM > 0
+    for (int i = 0; i < LCD_GLYPH_CACHE_NUM; i++) {
+        if (glyph_cache[i].bus) ST7789_Sync(glyph_cache[i].bus);
+        glyph_cache[i].font = NULL;
+        glyph_cache[i].bus  = NULL;
+    }
+#endif
+    glyph_hits = glyph_misses = 0;
+}
+
+/* 缓存命中统计 */
+void LCD_GlyphCacheStats(uint32_t *hits, uint32_t *misses)
+{
+    if (hits)   *hits   = glyph_hits;
+    if (misses) *misses = glyph_misses;
 }
 
 
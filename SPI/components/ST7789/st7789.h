@@ -32,50 +32,95 @@ extern "C" {
 #include <stdbool.h>
 
 /* ------------------------------------------------------------------
-   硬件引脚定义
+   面板上下文
+   每块屏由一个 st7789_t 描述：引脚、方向、尺寸与偏移、窗口缓存。
+   多块屏可共享同一个 st7789_bus_t（同一 SPI + DMA 通道），
+   总线上的像素传输以作业队列形式排队，按各屏 CS 交替发出：
+   DMA 发送 A 屏数据的同时，CPU 可以准备 B 屏的下一帧内容。
+
+   参考接线（单屏）：
    DC  -> PA6
    CS  -> PA4
    RES -> PA5
-   BLK -> PA7
+   BLK -> PA7 (TIM17 CH1 PWM)
    ------------------------------------------------------------------ */
 
-/* DC - PA6 */
-#define DC_PIN               LL_GPIO_PIN_6
-#define DC_H()               LL_GPIO_SetOutputPin(GPIOA, DC_PIN)
-#define DC_L()               LL_GPIO_ResetOutputPin(GPIOA, DC_PIN)
-
-/* CS - PA4 */
-#define CS_PIN               LL_GPIO_PIN_4
-#define CS_H()               LL_GPIO_SetOutputPin(GPIOA, CS_PIN)
-#define CS_L()               LL_GPIO_ResetOutputPin(GPIOA, CS_PIN)
-
-/* RES - PA5 */
-#define RST_PIN              LL_GPIO_PIN_5
-#define RST_H()              LL_GPIO_SetOutputPin(GPIOA, RST_PIN)
-#define RST_L()              LL_GPIO_ResetOutputPin(GPIOA, RST_PIN)
-
-/* BLK - PA7 (背光) */
-#define BLK_PIN              LL_GPIO_PIN_7
-#define BLK_H()              LL_GPIO_SetOutputPin(GPIOA, BLK_PIN)
-#define BLK_L()              LL_GPIO_ResetOutputPin(GPIOA, BLK_PIN)
-
-/* SPI 选择（默认使用 SPI1） */
-#ifndef ST7789_SPI
-#define ST7789_SPI           SPI1
-#endif
+/* 默认面板原生尺寸（1.47" 172x320），短边偏移 34 */
+#define ST7789_NATIVE_W      172
+#define ST7789_NATIVE_H      320
+#define ST7789_NATIVE_OFFSET 34
 
-/* 屏幕方向与尺寸 */
-#ifndef USE_HORIZONTAL
-#define USE_HORIZONTAL 2
+/* 每条总线的 DMA 作业队列深度 */
+#ifndef ST7789_QUEUE_LEN
+#define ST7789_QUEUE_LEN     8
 #endif
 
-#if (USE_HORIZONTAL == 0) || (USE_HORIZONTAL == 1)
-#define LCD_W 172
-#define LCD_H 320
-#else
-#define LCD_W 320
-#define LCD_H 172
-#endif
+/* 作业标志 */
+#define ST7789_JOB_FILL      0x01u   /* 单色填充：DMA 内存地址不递增 */
+#define ST7789_JOB_BYTES     0x02u   /* 按字节发送（8 位 SPI），否则按 16 位像素发送 */
+
+typedef struct st7789     st7789_t;
+typedef struct st7789_bus st7789_bus_t;
+
+/* 一次像素传输：窗口 + 数据 */
+typedef struct {
+    st7789_t   *lcd;
+    uint16_t    xs, ys, xe, ye;  // 目标窗口（含端点）
+    const void *data;            // 像素数据；FILL 时忽略
+    uint32_t    len;             // 传输单元数（16 位像素或字节）
+    uint16_t    color;           // FILL 颜色，由作业自身保存，调用者无需保持
+    uint8_t     flags;
+} st7789_job_t;
+
+/* SPI 总线 + DMA 通道，可被多块屏共享 */
+struct st7789_bus {
+    SPI_TypeDef  *spi;
+    DMA_TypeDef  *dma;
+    uint32_t      dma_ch;        // LL_DMA_CHANNEL_x
+    uint8_t       dma_index;     // 通道号 1..7，用于 ISR/IFCR 标志位
+
+    st7789_job_t  queue[ST7789_QUEUE_LEN];
+    volatile uint8_t head;       // 下一个写入位置
+    volatile uint8_t tail;       // 当前/下一个执行的作业
+    volatile uint8_t busy;       // DMA 正在传输 queue[tail]
+    uint32_t      remain;        // 当前作业剩余传输单元（分块 0xFFFF）
+    const uint8_t *cursor;       // 当前作业数据指针
+};
+
+/* 单块屏的静态配置 */
+typedef struct {
+    GPIO_TypeDef      *dc_port;  uint32_t dc_pin;
+    GPIO_TypeDef      *cs_port;  uint32_t cs_pin;
+    GPIO_TypeDef      *rst_port; uint32_t rst_pin;
+    TIM_HandleTypeDef *blk_tim;  uint32_t blk_ch;   // 背光 PWM
+    uint8_t            rotation;                    // 0/1 竖屏，2/3 横屏
+    uint16_t           native_w, native_h;          // 面板原生尺寸（竖屏）
+    uint16_t           offset;                      // 短边显存偏移
+} st7789_cfg_t;
+
+struct st7789 {
+    st7789_bus_t      *bus;
+    st7789_cfg_t       cfg;
+    uint16_t           width;    // 当前方向下的宽高
+    uint16_t           height;
+    uint16_t           x_off;    // 显存坐标偏移
+    uint16_t           y_off;
+
+    /* 窗口缓存：与上一次 CASET/RASET 相同则跳过对应命令 */
+    uint16_t           win_xs, win_xe;
+    uint16_t           win_ys, win_ye;
+    uint8_t            win_valid; // bit0 列有效，bit1 行有效
+};
+
+#define ST7789_PIN_H(port, pin)   LL_GPIO_SetOutputPin((port), (pin))
+#define ST7789_PIN_L(port, pin)   LL_GPIO_ResetOutputPin((port), (pin))
+
+#define DC_H(lcd)   ST7789_PIN_H((lcd)->cfg.dc_port,  (lcd)->cfg.dc_pin)
+#define DC_L(lcd)   ST7789_PIN_L((lcd)->cfg.dc_port,  (lcd)->cfg.dc_pin)
+#define CS_H(lcd)   ST7789_PIN_H((lcd)->cfg.cs_port,  (lcd)->cfg.cs_pin)
+#define CS_L(lcd)   ST7789_PIN_L((lcd)->cfg.cs_port,  (lcd)->cfg.cs_pin)
+#define RST_H(lcd)  ST7789_PIN_H((lcd)->cfg.rst_port, (lcd)->cfg.rst_pin)
+#define RST_L(lcd)  ST7789_PIN_L((lcd)->cfg.rst_port, (lcd)->cfg.rst_pin)
 
 /* 常用颜色（RGB565） */
 #define WHITE 0xFFFF
@@ -105,38 +150,52 @@ extern "C" {
 	 
 /* 非对外函数不展示 */	 
 
+/* ------------------------------------------------------------------
+   总线与面板
+   ------------------------------------------------------------------ */
+void ST7789_BusInit(st7789_bus_t *bus, SPI_TypeDef *spi, DMA_TypeDef *dma, uint32_t dma_ch, uint8_t dma_index);
+void ST7789_Attach(st7789_t *lcd, st7789_bus_t *bus, const st7789_cfg_t *cfg);
+
+int  ST7789_Submit(const st7789_job_t *job);
+void ST7789_BusPoll(st7789_bus_t *bus);
+void ST7789_DMA_IRQHandler(st7789_bus_t *bus);
+void ST7789_Sync(st7789_bus_t *bus);
+
 /* ------------------------------------------------------------------
    初始化硬件函数
    ------------------------------------------------------------------ */
-void LCD_Reset(void);
-void LCD_Init(uint16_t color);
+void LCD_Reset(st7789_t *lcd);
+void LCD_Init(st7789_t *lcd, uint16_t color);
 
 /* ------------------------------------------------------------------
    控制函数
    ------------------------------------------------------------------ */
-void LCD_SpinScreen(uint8_t locate);
-void LCD_BLK(uint8_t io);
+void LCD_SetRegion(st7789_t *lcd, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye);
+void LCD_SpinScreen(st7789_t *lcd, uint8_t locate);
+void LCD_BLK(st7789_t *lcd, uint8_t duty);
 
 /* ------------------------------------------------------------------
    基本绘制
    ------------------------------------------------------------------ */
-void LCD_Fill(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color);
-void LCD_Clear(uint16_t color);	 
+void LCD_Fill(st7789_t *lcd, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color);
+void LCD_Clear(st7789_t *lcd, uint16_t color);	 
 
-void LCD_DrawPoint(uint16_t x, uint16_t y, uint16_t color);
+void LCD_DrawPoint(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t color);
 
-void LCD_DrawCircle(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8_t thickness);
-void LCD_DrawCircle_Fill(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc);
-void LCD_DrawDashedCircle(uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8_t thickness, uint8_t segments);
+void LCD_DrawCircle(st7789_t *lcd, uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8_t thickness);
+void LCD_DrawCircle_Fill(st7789_t *lcd, uint16_t X, uint16_t Y, uint16_t R, uint16_t fc);
+void LCD_DrawDashedCircle(st7789_t *lcd, uint16_t X, uint16_t Y, uint16_t R, uint16_t fc, uint8_t thickness, uint8_t segments);
 
-void LCD_DrawLine(uint16_t x0, uint16_t y0,uint16_t x1, uint16_t y1,uint16_t Color);
+void LCD_DrawLine(st7789_t *lcd, uint16_t x0, uint16_t y0,uint16_t x1, uint16_t y1,uint16_t Color);
 
-void LCD_DrawRect_Fill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t bc);
-void LCD_DrawTriangel(uint16_t x, uint16_t y, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color);
-void LCD_FillRoundRect(uint16_t x, uint16_t y,
+void LCD_DrawRect_Fill(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t bc);
+void LCD_DrawTriangel(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color);
+void LCD_FillRoundRect(st7789_t *lcd,
+                       uint16_t x, uint16_t y,
                        uint16_t w, uint16_t h,
                        uint16_t r, uint16_t color);
-void LCD_DrawRoundRectStroke(uint16_t x, uint16_t y,
+void LCD_DrawRoundRectStroke(st7789_t *lcd,
+                             uint16_t x, uint16_t y,
                              uint16_t w, uint16_t h,
                              uint16_t r, uint16_t t,
                              uint16_t color);
@@ -144,8 +203,8 @@ void LCD_DrawRoundRectStroke(uint16_t x, uint16_t y,
 /* ------------------------------------------------------------------
   集成绘制
    ------------------------------------------------------------------ */
-void LCD_ShowImage(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t *p);
-void LCD_ShowPicture(uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t pic[]);
+void LCD_ShowImage(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t *p);
+void LCD_ShowPicture(st7789_t *lcd, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t pic[]);
 
 typedef struct {
     uint16_t x;        // 左上角 X 坐标
@@ -160,35 +219,93 @@ typedef struct {
 } ProgressBar;
 
 void ProgressBar_Init(ProgressBar *pb, uint16_t x, uint16_t y, uint16_t max_len, uint16_t height, float min_val, float max_val, uint16_t fg_color, uint16_t bg_color);
-void ProgressBar_Update(ProgressBar *pb, float cur_val);
+void ProgressBar_Update(st7789_t *lcd, ProgressBar *pb, float cur_val);
 
 
 
 /* ------------------------------------------------------------------
   字符绘制
    ------------------------------------------------------------------ */
-void LCD_ShowString			  (const char *sample, const unsigned char *data,
+void LCD_ShowString			  (st7789_t *lcd,
+												  const char *sample, const unsigned char *data,
 												  uint8_t w, uint8_t h,
 												  uint16_t x, uint16_t y,
 												  uint16_t fc, uint16_t bc,
 												  char* str);
 
-void LCD_ShowString_48_64(uint16_t x, uint16_t y,
+void LCD_ShowString_48_64(st7789_t *lcd, uint16_t x, uint16_t y,
                           uint16_t fc, uint16_t bc,
                           const char *str);
-void LCD_ShowString_32_16(uint16_t x, uint16_t y, 
+void LCD_ShowString_32_16(st7789_t *lcd, uint16_t x, uint16_t y, 
 													uint16_t fc, uint16_t bc,
 													const char *s);
-void LCD_ShowString_24_12(uint16_t x, uint16_t y, 
+void LCD_ShowString_24_12(st7789_t *lcd, uint16_t x, uint16_t y, 
                           uint16_t fc, uint16_t bc, 
                           const char *c);
-void LCD_ShowString_16_8(uint16_t x,uint16_t y,
+void LCD_ShowString_16_8(st7789_t *lcd, uint16_t x,uint16_t y,
 													uint16_t fc,uint16_t bc,
 													char *c);
-void LCD_ShowString_12_6(uint16_t x, uint16_t y,
+void LCD_ShowString_12_6(st7789_t *lcd, uint16_t x, uint16_t y,
                          uint16_t fc, uint16_t bc,
                          const char *str);
 
+/* ------------------------------------------------------------------
+  文字排版
+  - 等宽字体描述 + 测量、对齐（左/中/右/小数点）与定宽字段
+  - 字段内未被文字覆盖的格用背景色补齐，位数变化时不残留、不抖动
+  - 字形缓存：按 (字体, 字符, 前景色, 背景色) 缓存展开后的 RGB565 点阵，
+    命中时直接 DMA 发送，跳过逐位解包
+   ------------------------------------------------------------------ */
+typedef struct {
+    const char          *sample;    // 字模表字符顺序
+    const unsigned char *data;      // 字模数据，MSB 在左，每行 row_bytes 字节
+    uint8_t              w;         // 字符宽度（像素）
+    uint8_t              h;         // 字符高度（像素）
+    uint8_t              row_bytes; // (w + 7) / 8
+    char                 missing;   // 字模表中不存在的字符用它代替
+} lcd_font_t;
+
+extern const lcd_font_t LCD_FONT_48_64;
+extern const lcd_font_t LCD_FONT_32_16;
+extern const lcd_font_t LCD_FONT_24_12;
+extern const lcd_font_t LCD_FONT_16_8;
+extern const lcd_font_t LCD_FONT_12_6;
+
+typedef enum {
+    LCD_ALIGN_LEFT = 0,
+    LCD_ALIGN_CENTER,
+    LCD_ALIGN_RIGHT,
+    LCD_ALIGN_DECIMAL       // 小数点对齐到 dp_cell 格
+} lcd_align_t;
+
+/* 定宽字段：以字符格为单位 */
+typedef struct {
+    const lcd_font_t *font;
+    uint16_t x, y;          // 字段左上角
+    uint8_t  cells;         // 字段宽度（格）
+    uint8_t  align;         // lcd_align_t
+    uint8_t  dp_cell;       // DECIMAL 对齐时小数点所在格（无小数点时整数部分右对齐到此格之前）
+    uint16_t fc, bc;
+} lcd_field_t;
+
+/* 字形缓存容量：条目数 × 单字最大像素数（更大的字形不缓存，逐点绘制）
+   占用 RAM ≈ 条目数 × (像素数 × 2 + 20) 字节；默认按读数所用的 24x12 字体取 4 条，
+   4 × (288 × 2 + 20) ≈ 2.3 KB。G030 仅 8 KB SRAM，RAM 紧张时设 LCD_GLYPH_CACHE_NUM=0 关闭 */
+#ifndef LCD_GLYPH_CACHE_NUM
+#define LCD_GLYPH_CACHE_NUM     4
+#endif
+#ifndef LCD_GLYPH_MAX_PX
+#define LCD_GLYPH_MAX_PX        (24 * 12)
+#endif
+
+uint16_t LCD_TextWidth(const lcd_font_t *font, const char *s);
+void LCD_DrawGlyph(st7789_t *lcd, const lcd_font_t *font, uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, char c);
+void LCD_DrawText(st7789_t *lcd, const lcd_font_t *font, uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, const char *s);
+void LCD_FieldDraw(st7789_t *lcd, const lcd_field_t *fd, const char *s);
+
+void LCD_GlyphCacheClear(void);
+void LCD_GlyphCacheStats(uint32_t *hits, uint32_t *misses);
+
 /* ------------------------------------------------------------------
   加速缓冲
    ------------------------------------------------------------------ */
@@ -201,48 +318,54 @@ void slot_clear_all(void);
 
 /* ------------------------------------------------------------------
    ST7789 @ SPI
+   轮询发送前先等待总线上排队的 DMA 作业完成，
+   避免与其它屏的 CS 周期交叠
    ------------------------------------------------------------------ */
 
+__STATIC_INLINE void LCD_WaitTx(SPI_TypeDef *spi)
+{
+    while ((LL_SPI_IsActiveFlag_TXE(spi) == 0) || (LL_SPI_IsActiveFlag_BSY(spi) != 0)) { }
+}
+
 /* 发送命令 */
-__STATIC_INLINE void LCD_SendIndex(uint8_t cmd)
+__STATIC_INLINE void LCD_SendIndex(st7789_t *lcd, uint8_t cmd)
 {
-    DC_L();   // 命令模式
-    CS_L();   // 选中屏幕
-//    while ((LL_SPI_IsActiveFlag_TXE(ST7789_SPI) == 0) || (LL_SPI_IsActiveFlag_BSY(ST7789_SPI) != 0)) { }
-    LL_SPI_TransmitData8(ST7789_SPI, cmd);
-    while ((LL_SPI_IsActiveFlag_TXE(ST7789_SPI) == 0) || (LL_SPI_IsActiveFlag_BSY(ST7789_SPI) != 0)) { }
-//		volatile uint32_t tmpreg = SPI1->SR; (void)tmpreg;
-    CS_H();
-    DC_H();   // 恢复为数据模式
+    if (lcd->bus->busy) ST7789_Sync(lcd->bus);
+    DC_L(lcd);   // 命令模式
+    CS_L(lcd);   // 选中屏幕
+    LL_SPI_TransmitData8(lcd->bus->spi, cmd);
+    LCD_WaitTx(lcd->bus->spi);
+    CS_H(lcd);
+    DC_H(lcd);   // 恢复为数据模式
 }
 
 /* 发送 8 位数据 */
-__STATIC_INLINE void LCD_SendData(uint8_t data)
+__STATIC_INLINE void LCD_SendData(st7789_t *lcd, uint8_t data)
 {
-    DC_H();   // 数据模式
-    CS_L();
-//    while ((LL_SPI_IsActiveFlag_TXE(ST7789_SPI) == 0) || (LL_SPI_IsActiveFlag_BSY(ST7789_SPI) != 0)) { }
-    LL_SPI_TransmitData8(ST7789_SPI, data);
-    while ((LL_SPI_IsActiveFlag_TXE(ST7789_SPI) == 0) || (LL_SPI_IsActiveFlag_BSY(ST7789_SPI) != 0)) { }
-//		volatile uint32_t tmpreg = SPI1->SR; (void)tmpreg;
-    CS_H();
+    if (lcd->bus->busy) ST7789_Sync(lcd->bus);
+    DC_H(lcd);   // 数据模式
+    CS_L(lcd);
+    LL_SPI_TransmitData8(lcd->bus->spi, data);
+    LCD_WaitTx(lcd->bus->spi);
+    CS_H(lcd);
 }
 
 /* 发送 16 位数据（分两次 8bit） */
-__STATIC_INLINE void LCD_Send16Bit(uint16_t data)
+__STATIC_INLINE void LCD_Send16Bit(st7789_t *lcd, uint16_t data)
 {
-    DC_H();   // 数据模式
-    CS_L();
-//    while ((LL_SPI_IsActiveFlag_TXE(ST7789_SPI) == 0) || (LL_SPI_IsActiveFlag_BSY(ST7789_SPI) != 0)) { }
+    SPI_TypeDef *spi = lcd->bus->spi;
+
+    if (lcd->bus->busy) ST7789_Sync(lcd->bus);
+    DC_H(lcd);   // 数据模式
+    CS_L(lcd);
     // 高字节
-    LL_SPI_TransmitData8(ST7789_SPI, (uint8_t)(data >> 8));
-    while (LL_SPI_IsActiveFlag_TXE(ST7789_SPI) == 0) { }
+    LL_SPI_TransmitData8(spi, (uint8_t)(data >> 8));
+    while (LL_SPI_IsActiveFlag_TXE(spi) == 0) { }
 
     // 低字节
-    LL_SPI_TransmitData8(ST7789_SPI, (uint8_t)(data & 0xFF));
-    while ((LL_SPI_IsActiveFlag_TXE(ST7789_SPI) == 0) || (LL_SPI_IsActiveFlag_BSY(ST7789_SPI) != 0)) { }
-//		volatile uint32_t tmpreg = SPI1->SR; (void)tmpreg;
-    CS_H();
+    LL_SPI_TransmitData8(spi, (uint8_t)(data & 0xFF));
+    LCD_WaitTx(spi);
+    CS_H(lcd);
 }
 
 
@@ -3,6 +3,10 @@
 //长时间系统时钟
 volatile uint64_t sys = 0;
 
+//显示屏上下文
+st7789_bus_t lcd_bus;
+st7789_t lcd_panel[LCD_PANEL_NUM];
+
 //按钮逻辑传递
 
 volatile uint8_t lock[MAX_KEYS] = {0};//不允许再次触发
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "function.h"
+#include "st7789.h"
 
 
 
@@ -10,6 +11,11 @@
 
 extern volatile uint64_t sys;
 
+//显示：两块屏共享一条 SPI 总线，每通道一块
+#define LCD_PANEL_NUM 2
+extern st7789_bus_t lcd_bus;
+extern st7789_t lcd_panel[LCD_PANEL_NUM];
+
 
 extern volatile uint8_t lock[MAX_KEYS];
 extern volatile uint64_t btn_last_irq[MAX_KEYS];
@@ -1,7 +1,9 @@
 /******************************************************************************
  * @file    function.c
  * @brief   通用功能函数实现
- * @details 包含格式转换、滤波器、数值计算、按键逻辑、电源管理等函数的具体实现。
+ * @details 包含格式转换、滤波器、数值计算、校准、统计、能量累计等函数的具体实现；
+ *          本文件不依赖 HAL 与显示屏，可在主机上编译测试（见 components/INA226/host），
+ *          按键逻辑、电源管理等板级函数见 function_hal.c。
  *
  * @author  Bowen
  * @date    2026-02-10
@@ -53,130 +55,230 @@
    ========================================================================== */
 
 #include "function.h"
-#include "main.h"
-#include "global.h"
-#include "st7789.h"
+#include <stdlib.h>
+#ifdef ESP_PLATFORM
+#include "nvs.h"
+#endif
 
 /* ------------------------------------------------------------------
   格式化变量
    ------------------------------------------------------------------ */
-void formatFloatToStr(float value, char *out, int width, int prec)
+static const uint64_t pow10_u64[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+static void FormatFill(char *out, char c, int width)
 {
-    if (out == NULL || width <= 0) return;
-
-    /* NaN 或 Inf 处理 */
-    if (!isfinite(value)) {
-        memset(out, 'x', width);
-        out[width] = '\0';
-        return;
-    }
-
-    /* 处理符号与绝对值 */
-    int negative = signbit(value) ? 1 : 0;
-    float absval = negative ? -value : value;
-
-    /* 取整数部分（截断） */
-    char intbuf[64];
-    long long intpart = (long long)absval; /* 截断 */
-    snprintf(intbuf, sizeof(intbuf), "%lld", (long long)intpart);
-    int intlen = (int)strlen(intbuf);
-
-    int sign_len = negative ? 1 : 0;
+    memset(out, c, width);
+    out[width] = '\0';
+}
 
-    /* 如果整数部分（含符号）已超出宽度，则无法显示 */
-    if (sign_len + intlen > width) {
-        memset(out, 'x', width);
-        out[width] = '\0';
-        return;
-    }
+/**
+ * @brief 按固定宽度输出已舍入的定点数 r × 10^-prec
+ * @return 0 成功，-1 宽度不够
+ */
+static int FormatEmit(char *out, int negative, uint64_t r, int prec, int width)
+{
+    char digits[20];
+    int  n = 0;
 
-    /* 计算最多能放的小数位数（不超过用户给定的 prec） */
-    int max_frac = 0;
-    if (prec > 0) {
-        int avail = width - (sign_len + intlen + 1); /* 预留小数点 */
-        if (avail > 0) max_frac = avail;
-        else max_frac = 0;
-        if (max_frac > prec) max_frac = prec;
-    } else {
-        max_frac = 0;
+    /* 从低位向高位取数字；能放进 32 位后改用 32 位除法 */
+    while (r > 0xFFFFFFFFULL) {
+        digits[n++] = (char)('0' + (int)(r % 10));
+        r /= 10;
     }
+    uint32_t r32 = (uint32_t)r;
+    do {
+        digits[n++] = (char)('0' + (int)(r32 % 10));
+        r32 /= 10;
+    } while (r32 != 0);
+    while (n < prec + 1) digits[n++] = '0';     // 0.05 之类：补足整数位的 0
 
-    /* 计算实际需要的字符数（含小数点和小数位，如果有） */
-    int needed = sign_len + intlen + (max_frac > 0 ? (1 + max_frac) : 0);
-
-    /* 只要宽度大于需要的字符数，就在整数左侧（符号之后）填充 '0' */
-    int pad_zeros = 0;
-    if (width > needed) {
-        pad_zeros = width - needed;
-    }
+    int intlen = n - prec;
+    int needed = negative + intlen + (prec > 0 ? 1 + prec : 0);
+    if (needed > width) return -1;
 
-    /* 构造输出：符号 -> 填充0（若有） -> 整数部分 -> 小数点 -> 小数部分 */
-    char tmp[128];
     int pos = 0;
-
-    if (negative) {
-        tmp[pos++] = '-';
-    }
-
-    for (int i = 0; i < pad_zeros; ++i) {
-        tmp[pos++] = '0';
+    if (negative) out[pos++] = '-';
+    for (int i = needed; i < width; i++) out[pos++] = '0';
+    while (n > prec) out[pos++] = digits[--n];
+    if (prec > 0) {
+        out[pos++] = '.';
+        while (n > 0) out[pos++] = digits[--n];
     }
+    out[pos] = '\0';
+    return 0;
+}
 
-    memcpy(tmp + pos, intbuf, intlen);
-    pos += intlen;
-
-    if (max_frac > 0) {
-        tmp[pos++] = '.';
-        float frac = absval - (float)intpart;
-        if (frac < 0.0f) frac = 0.0f;
-        for (int i = 0; i < max_frac; ++i) {
-            frac *= 10.0f;
-            int digit = (int)frac;
-            if (digit < 0) digit = 0;
-            if (digit > 9) digit = 9;
-            tmp[pos++] = (char)('0' + digit);
-            frac -= (float)digit;
+/**
+ * @brief 格式化定点数 value × 10^-scale，全程整数运算
+ * @param scale 输入的小数位数（如 μA 为 6），≤ 18
+ * @param prec 期望的小数位数，宽度不够时逐位减少；超过 scale 的部分补 0
+ * @return 0 成功，-1 整数部分放不下（已填 'x'）
+ */
+int FormatFixed(char *out, int64_t value, uint8_t scale, int width, int prec)
+{
+    if (out == NULL || width <= 0) return -1;
+    if (scale > 18) scale = 18;
+    if (prec > 18) prec = 18;
+
+    int negative = value < 0;
+    uint64_t a = negative ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+
+    for (int p = (prec > 0 ? prec : 0); p >= 0; p--) {
+        uint64_t r;
+        if (p >= scale) {
+            uint64_t m = pow10_u64[p - scale];
+            if (a != 0 && a > UINT64_MAX / m) continue;
+            r = a * m;
+        } else {
+            uint64_t d = pow10_u64[scale - p];
+            r = a / d + ((a % d) >= (d + 1) / 2);     // 四舍五入（远离 0）
         }
+        if (FormatEmit(out, negative, r, p, width) == 0) return 0;
     }
+    FormatFill(out, 'x', width);
+    return -1;
+}
 
-    int outlen = pos;
-    if (outlen > width) {
-        memset(out, '.', width);
-        out[width] = '\0';
+/* 浮点版本：在最终的小数位数上只舍入一次 */
+void formatFloatToStr(float value, char *out, int width, int prec)
+{
+    if (out == NULL || width <= 0) return;
+
+    /* NaN 或 Inf 处理 */
+    if (!isfinite(value)) {
+        FormatFill(out, 'x', width);
         return;
     }
 
-    memcpy(out, tmp, outlen);
-    out[outlen] = '\0';
+    int negative = signbit(value) ? 1 : 0;
+    double absval = negative ? -(double)value : (double)value;
+    if (prec > 9) prec = 9;
+
+    for (int p = (prec > 0 ? prec : 0); p >= 0; p--) {
+        double scaled = absval * (double)pow10_u64[p] + 0.5;
+        if (scaled >= 1.8e19) continue;
+        if (FormatEmit(out, negative, (uint64_t)scaled, p, width) == 0) return;
+    }
+    FormatFill(out, 'x', width);
 }
 
 
 /* ------------------------------------------------------------------
   时间生成器
    ------------------------------------------------------------------ */
+/* 非可重入：返回共享静态缓冲，多任务中请使用 FormatTimeString_r */
 char* FormatTimeString(uint64_t sys)
 {
-    static char buf[20];
-    uint32_t total_sec  = sys / 1000;
+    static char buf[FORMAT_TIME_LEN];
+    return FormatTimeString_r(sys, buf, sizeof(buf));
+}
+
+static char *PutTwoDigits(char *p, uint32_t v)
+{
+    p[0] = (char)('0' + v / 10);
+    p[1] = (char)('0' + v % 10);
+    return p + 2;
+}
+
+/**
+ * @brief 可重入版本
+ * @param buf 至少 FORMAT_TIME_LEN 字节；不足时输出空串
+ * @return buf
+ */
+char* FormatTimeString_r(uint64_t sys, char *buf, size_t len)
+{
+    if (buf == NULL || len == 0) return buf;
+    if (len < FORMAT_TIME_LEN) { buf[0] = '\0'; return buf; }
+
+    uint32_t total_sec  = (uint32_t)(sys / 1000);
     uint32_t total_hour = total_sec / 3600;
+    char *p = buf;
 
     if (total_hour <= 99) {
-        uint32_t hh = total_hour;
-        uint32_t mm = (total_sec % 3600) / 60;
-        uint32_t ss = total_sec % 60;
-        snprintf(buf, sizeof(buf), "%02u:%02u:%02u", hh, mm, ss);
+        p = PutTwoDigits(p, total_hour);
+        *p++ = ':';
+        p = PutTwoDigits(p, (total_sec % 3600) / 60);
+        *p++ = ':';
+        p = PutTwoDigits(p, total_sec % 60);
     } else {
         uint32_t days = total_sec / 86400;
         uint32_t rem  = total_sec % 86400;
-        uint32_t hh   = rem / 3600;
-        uint32_t mm   = (rem % 3600) / 60;
-        snprintf(buf, sizeof(buf), "%ud%02uh%02um", days, hh, mm);
+        char d[10];
+        int  n = 0;
+        do { d[n++] = (char)('0' + days % 10); days /= 10; } while (days);
+        while (n) *p++ = d[--n];
+        *p++ = 'd';
+        p = PutTwoDigits(p, rem / 3600);
+        *p++ = 'h';
+        p = PutTwoDigits(p, (rem % 3600) / 60);
+        *p++ = 'm';
     }
-
+    *p = '\0';
     return buf;
 }
 
 
+/* ------------------------------------------------------------------
+  增量运行时钟
+  "HH:MM:SS" 阶段按字符进位：个位秒 +1，满 10/6 再向左进位，每秒平均改动约 1.1 个字符；
+  超过 99 小时后的 "DdHHhMMm" 每分钟才变化一次，整串重新生成即可。
+  落后 60 s 以上（如长时间阻塞）直接整串重新生成。
+   ------------------------------------------------------------------ */
+void UptimeClockInit(UptimeClock *c, uint64_t now_ms)
+{
+    c->total_sec = (uint32_t)(now_ms / 1000);
+    c->next_ms   = ((uint64_t)c->total_sec + 1) * 1000;
+    FormatTimeString_r(now_ms, c->text, sizeof(c->text));
+    c->changed   = (uint8_t)strlen(c->text);         // 首次渲染绘制整串
+}
+
+/* 秒 +1：text 为 "HH:MM:SS"，返回改动的字符数 */
+static uint8_t UptimeClockTick(char *t)
+{
+    static const uint8_t pos[6] = { 7, 6, 4, 3, 1, 0 };
+    static const char    top[6] = { '9', '5', '9', '5', '9', '9' };
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < 6; i++) {
+        n++;
+        if (t[pos[i]] < top[i]) { t[pos[i]]++; return n; }
+        t[pos[i]] = '0';
+    }
+    return n;
+}
+
+/**
+ * @brief 推进时钟到 now_ms
+ * @return 改动的字符数，0 表示文本未变化
+ */
+int UptimeClockUpdate(UptimeClock *c, uint64_t now_ms)
+{
+    if (now_ms < c->next_ms) return 0;
+
+    uint32_t steps = (uint32_t)((now_ms - c->next_ms) / 1000) + 1;
+    uint32_t prev_sec = c->total_sec;
+    c->total_sec += steps;
+    c->next_ms   += (uint64_t)steps * 1000;
+
+    int n = 0;
+    if (c->total_sec < 100UL * 3600 && steps < 60) {
+        while (steps--) n += UptimeClockTick(c->text);
+    } else if (prev_sec / 60 != c->total_sec / 60 || c->total_sec < 100UL * 3600) {
+        char old[FORMAT_TIME_LEN];
+        memcpy(old, c->text, sizeof(old));
+        FormatTimeString_r((uint64_t)c->total_sec * 1000, c->text, sizeof(c->text));
+        for (uint8_t i = 0; i < FORMAT_TIME_LEN && (old[i] || c->text[i]); i++) n += (old[i] != c->text[i]);
+    }
+
+    /* 累计到下一次 UptimeClockRender */
+    c->changed = (uint8_t)((c->changed + n > 255) ? 255 : c->changed + n);
+    return n;
+}
 
 
 /* ------------------------------------------------------------------
@@ -211,6 +313,134 @@ float MovingAverageUpdate(MovingAverageFilter *f, float value) {
     return f->sum / f->count;
 }
 
+/* ------------------------------------------------------------------
+  多通道滑动均值（通道登记表）
+  样本按通道分辨率量化为 int32，累加和为 int64：加减完全抵消，
+  连续运行多天也不会像浮点累加和那样逐渐漂移
+   ------------------------------------------------------------------ */
+#define MA_DEFAULT_RESOLUTION  1e-6f     // 未配置通道：μ 单位（μV / μA / μW）
+
+static MovingAverageChannel ma_ch[MA_MAX_CHANNELS];
+
+/**
+ * @brief 配置通道窗口与量化分辨率，并清空历史
+ * @param window 窗口长度（1..MA_MAX_WINDOW）
+ * @param resolution 量化步长，如 1e-6 表示 1μA；|value / resolution| 需 < 2^31
+ * @return 0 成功，-1 参数无效
+ */
+int MovingAverageConfig(uint8_t ch, uint16_t window, float resolution)
+{
+    if (ch >= MA_MAX_CHANNELS || window == 0 || window > MA_MAX_WINDOW || !(resolution > 0.0f)) {
+        return -1;
+    }
+    MovingAverageChannel *c = &ma_ch[ch];
+    c->window     = window;
+    c->resolution = resolution;
+    c->scale      = 1.0f / resolution;
+    MovingAverageReset(ch);
+    return 0;
+}
+
+void MovingAverageReset(uint8_t ch)
+{
+    if (ch >= MA_MAX_CHANNELS) return;
+    MovingAverageChannel *c = &ma_ch[ch];
+    c->sum       = 0;
+    c->write_idx = 0;
+    c->count     = 0;
+    memset(c->buffer, 0, sizeof(c->buffer));
+}
+
+/* 首次使用且未配置的通道取默认窗口 WINDOW_SIZE */
+static MovingAverageChannel *MovingAverageChan(uint8_t ch)
+{
+    MovingAverageChannel *c = &ma_ch[ch];
+    if (c->window == 0) {
+        MovingAverageConfig(ch, WINDOW_SIZE, MA_DEFAULT_RESOLUTION);
+    }
+    return c;
+}
+
+static inline void MovingAveragePush(MovingAverageChannel *c, int32_t q)
+{
+    c->sum += (int64_t)q - c->buffer[c->write_idx];
+    c->buffer[c->write_idx] = q;
+    if (++c->write_idx >= c->window) c->write_idx = 0;
+    if (c->count < c->window) c->count++;
+}
+
+static inline int32_t MovingAverageQuantize(const MovingAverageChannel *c, float value)
+{
+    float q = value * c->scale;
+    if (q >  2147483520.0f) return INT32_MAX;
+    if (q < -2147483520.0f) return INT32_MIN;
+    return (int32_t)(q >= 0.0f ? q + 0.5f : q - 0.5f);
+}
+
+/* 写入一个样本，返回该通道当前均值 */
+float MovingAverage(uint8_t ch, float value)
+{
+    if (ch >= MA_MAX_CHANNELS) return value;
+    MovingAverageChannel *c = MovingAverageChan(ch);
+
+    MovingAveragePush(c, MovingAverageQuantize(c, value));
+    return (float)c->sum * c->resolution / (float)c->count;
+}
+
+/* 批量写入 n 个样本（如从采样环形缓冲一次取出的一批），只在最后做一次除法 */
+float MovingAverageBatch(uint8_t ch, const float *values, uint16_t n)
+{
+    if (ch >= MA_MAX_CHANNELS) return n ? values[n - 1] : 0.0f;
+    MovingAverageChannel *c = MovingAverageChan(ch);
+
+    for (uint16_t i = 0; i < n; i++) {
+        MovingAveragePush(c, MovingAverageQuantize(c, values[i]));
+    }
+    return c->count ? (float)c->sum * c->resolution / (float)c->count : 0.0f;
+}
+
+/* 整数输入（已是通道分辨率下的定点值，如 μA），全程无浮点 */
+int32_t MovingAverageI32(uint8_t ch, int32_t value)
+{
+    if (ch >= MA_MAX_CHANNELS) return value;
+    MovingAverageChannel *c = MovingAverageChan(ch);
+
+    MovingAveragePush(c, value);
+    return (int32_t)(c->sum / c->count);
+}
+
+
+/* 块处理版本：窗口填满后用倒数乘法代替除法，与逐个调用 MovingAverageUpdate 相差不超过 1 ulp */
+void MovingAverageProcessBlock(MovingAverageFilter *f, const float *in, float *out, uint16_t n) {
+    float * const buf = f->buffer;
+    float   sum   = f->sum;
+    uint8_t idx   = f->write_idx;
+    uint8_t count = f->count;
+    uint16_t i = 0;
+
+    for (; i < n && count < WINDOW_SIZE; i++) {     // 预热：窗口未满
+        float v = in[i];
+        sum += v - buf[idx];
+        buf[idx] = v;
+        if (++idx >= WINDOW_SIZE) idx = 0;
+        count++;
+        out[i] = sum / count;
+    }
+
+    const float inv = 1.0f / WINDOW_SIZE;
+    for (; i < n; i++) {
+        float v = in[i];
+        sum += v - buf[idx];
+        buf[idx] = v;
+        if (++idx >= WINDOW_SIZE) idx = 0;
+        out[i] = sum * inv;
+    }
+
+    f->sum       = sum;
+    f->write_idx = idx;
+    f->count     = count;
+}
+
 /* ------------------------------------------------------------------
   卡尔曼滤波
    ------------------------------------------------------------------ */
@@ -243,6 +473,505 @@ float KalmanUpdate(KalmanFilter *kf, float value, float Q, float R) {
     return kf->x_est;
 }
 
+/* 块处理版本：与逐个调用 KalmanUpdate 结果一致
+   Q、R 固定时 P 与增益 K 不依赖输入，P 收敛到不动点后直接复用 K，省去每个样本的除法 */
+void KalmanProcessBlock(KalmanFilter *kf, const float *in, float *out, uint16_t n, float Q, float R) {
+    uint16_t i = 0;
+
+    if (n == 0) return;
+    if (!kf->initialized) {
+        out[0] = KalmanUpdate(kf, in[0], Q, R);
+        i = 1;
+    }
+
+    float x = kf->x_est;
+    float p = kf->p_est;
+    float K = 0.0f;
+    for (; i < n; i++) {
+        float p_pred = p + Q;
+        K = p_pred / (p_pred + R);
+        x = x + K * (in[i] - x);
+        float p_next = (1.0f - K) * p_pred;
+        out[i] = x;
+        if (p_next == p) { i++; break; }            // 已收敛
+        p = p_next;
+    }
+    for (; i < n; i++) {
+        x = x + K * (in[i] - x);
+        out[i] = x;
+    }
+    kf->x_est = x;
+    kf->p_est = p;
+}
+
+
+/* ------------------------------------------------------------------
+  整数滤波器（μV / μA / μW）
+  无 FPU 的平台上浮点运算全部是软件实现，整数版本避免每个样本的软浮点调用
+   ------------------------------------------------------------------ */
+void MovingAverageInitI32(MovingAverageFilterI32 *f) {
+    f->sum = 0;
+    f->write_idx = 0;
+    f->count = 0;
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        f->buffer[i] = 0;
+    }
+}
+
+/* 累加和用 int64，窗口内不会溢出，也没有浮点累加的误差漂移 */
+int32_t MovingAverageUpdateI32(MovingAverageFilterI32 *f, int32_t value) {
+    f->sum += (int64_t)value - f->buffer[f->write_idx];
+    f->buffer[f->write_idx] = value;
+
+    f->write_idx = (f->write_idx + 1) % WINDOW_SIZE;
+    if (f->count < WINDOW_SIZE) {
+        f->count++;
+    }
+
+    return (int32_t)(f->sum / f->count);
+}
+
+void MovingAverageProcessBlockI32(MovingAverageFilterI32 *f, const int32_t *in, int32_t *out, uint16_t n) {
+    int64_t sum   = f->sum;
+    uint8_t idx   = f->write_idx;
+    uint8_t count = f->count;
+
+    for (uint16_t i = 0; i < n; i++) {
+        int32_t v = in[i];
+        sum += (int64_t)v - f->buffer[idx];
+        f->buffer[idx] = v;
+        if (++idx >= WINDOW_SIZE) idx = 0;
+        if (count < WINDOW_SIZE) count++;
+        out[i] = (int32_t)(sum / count);
+    }
+
+    f->sum       = sum;
+    f->write_idx = idx;
+    f->count     = count;
+}
+
+void KalmanInitI32(KalmanFilterI32 *kf, int32_t init_x, int64_t init_p) {
+    kf->x_est = init_x;
+    kf->p_est = init_p;
+    kf->initialized = 1;
+}
+
+/* 增益 K 用 Q16 定点表示；Q、R、P 与输入单位的平方同单位 */
+int32_t KalmanUpdateI32(KalmanFilterI32 *kf, int32_t value, int64_t Q, int64_t R) {
+    if (!kf->initialized) {
+        kf->x_est = value;
+        kf->p_est = 1;
+        kf->initialized = 1;
+        return value;
+    }
+
+    int64_t p_pred = kf->p_est + Q;
+    int64_t den    = p_pred + R;
+    int64_t K      = den > 0 ? (p_pred * KALMAN_Q16_ONE) / den : KALMAN_Q16_ONE;
+
+    kf->x_est += (int32_t)((K * ((int64_t)value - kf->x_est)) / KALMAN_Q16_ONE);
+    kf->p_est  = ((KALMAN_Q16_ONE - K) * p_pred) / KALMAN_Q16_ONE;
+
+    return kf->x_est;
+}
+
+
+
+/* ------------------------------------------------------------------
+  滑动中值 / Hampel
+  双堆：低半部分为大顶堆，高半部分为小顶堆，两堆元素个数相差不超过 1。
+  窗口满后新样本直接覆盖最旧样本所在的槽位，在该堆内上浮/下沉，
+  若两堆堆顶顺序被破坏再交换一次堆顶，每次更新 O(log N)，无需重新排序。
+   ------------------------------------------------------------------ */
+/* 堆内比较：低半为大顶堆（父 >= 子），高半为小顶堆（父 <= 子） */
+static inline int SmedBefore(const SlidingMedian *m, uint8_t side, uint8_t a, uint8_t b)
+{
+    return side ? (m->val[a] < m->val[b]) : (m->val[a] > m->val[b]);
+}
+
+static inline uint8_t *SmedHeap(SlidingMedian *m, uint8_t side)
+{
+    return side ? m->hi : m->lo;
+}
+
+static inline void SmedSet(SlidingMedian *m, uint8_t side, uint8_t i, uint8_t slot)
+{
+    SmedHeap(m, side)[i] = slot;
+    m->side[slot] = side;
+    m->pos[slot]  = i;
+}
+
+static void SmedSiftUp(SlidingMedian *m, uint8_t side, uint8_t i)
+{
+    uint8_t *h = SmedHeap(m, side);
+    uint8_t slot = h[i];
+    while (i > 0) {
+        uint8_t parent = (uint8_t)((i - 1) / 2);
+        if (!SmedBefore(m, side, slot, h[parent])) break;
+        SmedSet(m, side, i, h[parent]);
+        i = parent;
+    }
+    SmedSet(m, side, i, slot);
+}
+
+static void SmedSiftDown(SlidingMedian *m, uint8_t side, uint8_t i)
+{
+    uint8_t *h = SmedHeap(m, side);
+    uint8_t  n = side ? m->nhi : m->nlo;
+    uint8_t  slot = h[i];
+    for (;;) {
+        uint8_t c = (uint8_t)(2 * i + 1);
+        if (c >= n) break;
+        if (c + 1 < n && SmedBefore(m, side, h[c + 1], h[c])) c++;
+        if (!SmedBefore(m, side, h[c], slot)) break;
+        SmedSet(m, side, i, h[c]);
+        i = c;
+    }
+    SmedSet(m, side, i, slot);
+}
+
+/* 把 from 堆的堆顶移到另一个堆 */
+static void SmedMoveTop(SlidingMedian *m, uint8_t from)
+{
+    uint8_t *h = SmedHeap(m, from);
+    uint8_t slot = h[0];
+
+    if (from) {
+        m->nhi--;
+        if (m->nhi) { SmedSet(m, 1, 0, m->hi[m->nhi]); SmedSiftDown(m, 1, 0); }
+        SmedSet(m, 0, m->nlo, slot);
+        SmedSiftUp(m, 0, m->nlo++);
+    } else {
+        m->nlo--;
+        if (m->nlo) { SmedSet(m, 0, 0, m->lo[m->nlo]); SmedSiftDown(m, 0, 0); }
+        SmedSet(m, 1, m->nhi, slot);
+        SmedSiftUp(m, 1, m->nhi++);
+    }
+}
+
+int SlidingMedianInit(SlidingMedian *m, uint8_t window)
+{
+    if (window == 0 || window > SMEDIAN_MAX_WINDOW) return -1;
+    memset(m, 0, sizeof(*m));
+    m->win = window;
+    return 0;
+}
+
+float SlidingMedianGet(const SlidingMedian *m)
+{
+    if (m->count == 0) return 0.0f;
+    if (m->nlo > m->nhi) return m->val[m->lo[0]];
+    return 0.5f * (m->val[m->lo[0]] + m->val[m->hi[0]]);
+}
+
+float SlidingMedianUpdate(SlidingMedian *m, float value)
+{
+    uint8_t slot = m->idx;
+    if (++m->idx >= m->win) m->idx = 0;
+
+    m->val[slot] = value;
+
+    if (m->count < m->win) {
+        /* 窗口未满：插入新槽位 */
+        m->count++;
+        if (m->nlo == 0 || value <= m->val[m->lo[0]]) {
+            SmedSet(m, 0, m->nlo, slot);
+            SmedSiftUp(m, 0, m->nlo++);
+        } else {
+            SmedSet(m, 1, m->nhi, slot);
+            SmedSiftUp(m, 1, m->nhi++);
+        }
+        if (m->nlo > m->nhi + 1) SmedMoveTop(m, 0);
+        else if (m->nhi > m->nlo) SmedMoveTop(m, 1);
+    } else {
+        /* 窗口已满：覆盖最旧样本，原地调整 */
+        uint8_t side = m->side[slot];
+        SmedSiftUp(m, side, m->pos[slot]);
+        SmedSiftDown(m, side, m->pos[slot]);
+
+        if (m->nhi && m->val[m->lo[0]] > m->val[m->hi[0]]) {
+            uint8_t a = m->lo[0], b = m->hi[0];
+            SmedSet(m, 0, 0, b);
+            SmedSet(m, 1, 0, a);
+            SmedSiftDown(m, 0, 0);
+            SmedSiftDown(m, 1, 0);
+        }
+    }
+    return SlidingMedianGet(m);
+}
+
+/**
+ * @brief Hampel 离群点剔除：|x - 中值| > k × 1.4826 × MAD 时用中值代替 x
+ * @note  MAD 用“偏差入窗时相对当时中值”的滑动中值近似，保持 O(log N)
+ */
+int HampelInit(HampelFilter *h, uint8_t window, float k)
+{
+    if (SlidingMedianInit(&h->med, window) != 0) return -1;
+    SlidingMedianInit(&h->dev, window);
+    h->k        = k;
+    h->outliers = 0;
+    h->samples  = 0;
+    return 0;
+}
+
+float HampelUpdate(HampelFilter *h, float value)
+{
+    float med = SlidingMedianUpdate(&h->med, value);
+    float d   = fabsf(value - med);
+    float mad = SlidingMedianUpdate(&h->dev, d);
+
+    h->samples++;
+    if (h->med.count >= 3 && d > h->k * 1.4826f * mad && mad > 0.0f) {
+        h->outliers++;
+        return med;
+    }
+    return value;
+}
+
+
+/* ------------------------------------------------------------------
+  CIC 抽取 + 补偿 FIR
+  N 级积分器（输入速率）→ 每 R 个样本抽 1 → N 级梳状器（输出速率）→ ÷R^N → 补偿 FIR。
+  CIC 通带内有 sinc^N 衰减，默认补偿器为 3 抽头 [-b, 1+2b, -b]，b = N/24，
+  在低频处按二阶近似抵消衰减；也可传入自行设计的 Q15 系数。
+   ------------------------------------------------------------------ */
+/**
+ * @brief 初始化抽取器
+ * @param order CIC 级数 N（1..CIC_MAX_ORDER）
+ * @param ratio 抽取比 R；输入为 ±2^31 时需 N × log2(R) ≤ 32，保证 64 位寄存器不溢出
+ * @param fir_q15 补偿 FIR 系数（Q15），NULL 使用默认补偿器
+ * @param taps 系数个数；fir_q15 为 NULL 时忽略，传 0 且 fir_q15 非 NULL 表示不做补偿
+ * @return 0 成功，-1 参数无效
+ */
+int CicInit(CicDecimator *c, uint8_t order, uint16_t ratio, const int32_t *fir_q15, uint8_t taps)
+{
+    if (order == 0 || order > CIC_MAX_ORDER || ratio == 0) return -1;
+
+    uint8_t bits = 0;
+    while ((1UL << bits) < ratio) bits++;
+    if ((uint16_t)order * bits > 32) return -1;
+
+    memset(c, 0, sizeof(*c));
+    c->order = order;
+    c->ratio = ratio;
+    c->gain  = 1;
+    for (uint8_t i = 0; i < order; i++) c->gain *= ratio;
+
+    if (fir_q15 == NULL) {
+        int32_t b = (int32_t)order * 32768 / 24;
+        c->fir_default[0] = -b;
+        c->fir_default[1] = 32768 + 2 * b;
+        c->fir_default[2] = -b;
+        c->fir  = c->fir_default;
+        c->taps = 3;
+    } else {
+        if (taps > CIC_FIR_MAX_TAPS) return -1;
+        c->fir  = fir_q15;
+        c->taps = taps;
+    }
+    return 0;
+}
+
+void CicReset(CicDecimator *c)
+{
+    memset(c->integ, 0, sizeof(c->integ));
+    memset(c->comb, 0, sizeof(c->comb));
+    memset(c->hist, 0, sizeof(c->hist));
+    c->phase = 0;
+    c->hidx  = 0;
+}
+
+/* 输出速率下的补偿 FIR */
+static int32_t CicFir(CicDecimator *c, int32_t x)
+{
+    if (c->taps == 0) return x;
+
+    c->hist[c->hidx] = x;
+    int64_t acc = 0;
+    uint8_t k = c->hidx;
+    for (uint8_t i = 0; i < c->taps; i++) {
+        acc += (int64_t)c->fir[i] * c->hist[k];
+        k = (k == 0) ? (uint8_t)(c->taps - 1) : (uint8_t)(k - 1);
+    }
+    if (++c->hidx >= c->taps) c->hidx = 0;
+
+    acc += (acc >= 0) ? 16384 : -16384;            // Q15 四舍五入
+    return (int32_t)(acc / 32768);
+}
+
+/**
+ * @brief 处理一块输入样本（如 μA），输出抽取后的样本
+ * @param out 至少 n / R + 1 个
+ * @return 输出样本数
+ */
+uint16_t CicProcessBlock(CicDecimator *c, const int32_t *in, int32_t *out, uint16_t n)
+{
+    uint16_t m = 0;
+    const uint8_t N = c->order;
+
+    for (uint16_t i = 0; i < n; i++) {
+        /* 积分器 */
+        uint64_t v = (uint64_t)(int64_t)in[i];
+        for (uint8_t k = 0; k < N; k++) {
+            c->integ[k] += v;
+            v = c->integ[k];
+        }
+        if (++c->phase < c->ratio) continue;
+        c->phase = 0;
+
+        /* 梳状器 */
+        for (uint8_t k = 0; k < N; k++) {
+            uint64_t d = v - c->comb[k];
+            c->comb[k] = v;
+            v = d;
+        }
+        int64_t y = (int64_t)v;
+        y = (y >= 0) ? (y + c->gain / 2) / c->gain : (y - c->gain / 2) / c->gain;
+        out[m++] = CicFir(c, (int32_t)y);
+    }
+    return m;
+}
+
+
+/* ------------------------------------------------------------------
+  滤波流水线
+   ------------------------------------------------------------------ */
+/*
+通道配置表：修改某一路的平滑方式只需改这里（或在编译选项中整体替换 FILTER_CHANNEL_TABLE），
+不需要改调用处的代码。FILTER_CHANNEL(通道号, 级1, 级2, ...)
+*/
+#ifndef FILTER_CHANNEL_TABLE
+#define FILTER_CHANNEL_TABLE \
+    FILTER_CHANNEL(0, FILT_MEDIAN(3), FILT_EMA(0.2f))                              /* 母线电压 */ \
+    FILTER_CHANNEL(1, FILT_MEDIAN(5), FILT_KALMAN(0.001f, 0.1f), FILT_DECIMATE(4))  /* 电流 */
+#endif
+
+/* 级数超过 FILTER_MAX_STAGES 时编译报错，而不是运行时退化为原样输出；
+   通道号越界同样会在下面 filt_table 的初始化处报错 */
+#define FILTER_CHANNEL(ch, ...) \
+    static const FilterStageCfg filt_cfg_##ch[] = { __VA_ARGS__ }; \
+    typedef char filt_chk_##ch[(sizeof(filt_cfg_##ch) / sizeof(filt_cfg_##ch[0]) <= FILTER_MAX_STAGES) ? 1 : -1];
+FILTER_CHANNEL_TABLE
+#undef FILTER_CHANNEL
+
+#define FILTER_CHANNEL(ch, ...) [ch] = { filt_cfg_##ch, (uint8_t)(sizeof(filt_cfg_##ch) / sizeof(filt_cfg_##ch[0])) },
+static const struct {
+    const FilterStageCfg *cfg;
+    uint8_t               stages;
+} filt_table[FILTER_MAX_CHANNELS] = { FILTER_CHANNEL_TABLE };
+#undef FILTER_CHANNEL
+
+static FilterPipeline filt_ch[FILTER_MAX_CHANNELS];
+
+/**
+ * @brief 按配置表初始化一条流水线
+ * @return 0 成功，-1 级数或参数超出范围
+ */
+int FilterPipelineInit(FilterPipeline *p, const FilterStageCfg *cfg, uint8_t stages)
+{
+    if (stages > FILTER_MAX_STAGES) return -1;
+    for (uint8_t i = 0; i < stages; i++) {
+        if (cfg[i].type == FILT_STAGE_MEDIAN && (cfg[i].n == 0 || cfg[i].n > FILT_MEDIAN_MAX)) return -1;
+        if (cfg[i].type == FILT_STAGE_DECIMATE && cfg[i].n == 0) return -1;
+    }
+    p->cfg    = cfg;
+    p->stages = stages;
+    FilterPipelineReset(p);
+    return 0;
+}
+
+void FilterPipelineReset(FilterPipeline *p)
+{
+    memset(p->st, 0, sizeof(p->st));
+}
+
+/* 小窗口中值：复制后插入排序 */
+static float FilterMedianStep(FilterStageState *st, uint16_t win, float v)
+{
+    float tmp[FILT_MEDIAN_MAX];
+
+    st->u.med.buf[st->u.med.idx] = v;
+    if (++st->u.med.idx >= win) st->u.med.idx = 0;
+    if (st->u.med.count < win) st->u.med.count++;
+
+    uint8_t n = st->u.med.count;
+    for (uint8_t i = 0; i < n; i++) {
+        float x = st->u.med.buf[i];
+        int8_t j = (int8_t)i - 1;
+        while (j >= 0 && tmp[j] > x) {
+            tmp[j + 1] = tmp[j];
+            j--;
+        }
+        tmp[j + 1] = x;
+    }
+    return tmp[n / 2];
+}
+
+/**
+ * @brief 处理一块样本
+ * @param out 输出缓冲，至少 n 个；有抽取级时输出个数少于 n
+ * @return 输出样本数
+ */
+uint16_t FilterPipelineProcess(FilterPipeline *p, const float *in, float *out, uint16_t n)
+{
+    uint16_t m = 0;
+
+    for (uint16_t i = 0; i < n; i++) {
+        float v = in[i];
+        uint8_t s;
+
+        for (s = 0; s < p->stages; s++) {
+            const FilterStageCfg *c  = &p->cfg[s];
+            FilterStageState     *st = &p->st[s];
+
+            switch (c->type) {
+            case FILT_STAGE_MEDIAN:
+                v = FilterMedianStep(st, c->n, v);
+                break;
+            case FILT_STAGE_KALMAN:
+                v = KalmanUpdate(&st->u.kal, v, c->a, c->b);
+                break;
+            case FILT_STAGE_EMA:
+                if (!st->u.ema.init) {
+                    st->u.ema.y    = v;
+                    st->u.ema.init = 1;
+                } else {
+                    st->u.ema.y += c->a * (v - st->u.ema.y);
+                }
+                v = st->u.ema.y;
+                break;
+            case FILT_STAGE_DECIMATE:
+                st->u.dec.acc += v;
+                if (++st->u.dec.count < c->n) goto next;  // 本样本在此级被吸收
+                v = st->u.dec.acc / (float)c->n;
+                st->u.dec.acc   = 0.0f;
+                st->u.dec.count = 0;
+                break;
+            default:
+                break;
+            }
+        }
+        out[m++] = v;
+next:
+        ;
+    }
+    return m;
+}
+
+/* 按通道号使用配置表中的流水线，首次调用时初始化；未配置的通道原样输出 */
+uint16_t FilterChannelProcess(uint8_t ch, const float *in, float *out, uint16_t n)
+{
+    if (ch >= FILTER_MAX_CHANNELS) return 0;
+
+    FilterPipeline *p = &filt_ch[ch];
+    if (p->cfg == NULL) {
+        if (filt_table[ch].cfg == NULL || FilterPipelineInit(p, filt_table[ch].cfg, filt_table[ch].stages) != 0) {
+            if (out != in) memcpy(out, in, n * sizeof(float));
+            return n;
+        }
+    }
+    return FilterPipelineProcess(p, in, out, n);
+}
 
 
 /* ------------------------------------------------------------------
@@ -250,37 +979,434 @@ float KalmanUpdate(KalmanFilter *kf, float value, float Q, float R) {
    ------------------------------------------------------------------ */
 
 
+/**
+ * @brief 校验并编译校准表：检查 points 严格升序，预算每段斜率
+ * @return 0 成功，-1 点数或顺序无效
+ */
+int CalTableCompile(CalTable *ct)
+{
+    int n = ct->num_points;
+    if (n < 1 || n > MAX_CAL_POINTS) return -1;
+
+    for (int i = 0; i < n - 1; i++) {
+        float dx = ct->points[i + 1] - ct->points[i];
+        if (!(dx > 0.0f)) return -1;
+        ct->slopes[i] = (ct->offsets[i + 1] - ct->offsets[i]) / dx;
+    }
+    ct->slopes[n - 1] = 0.0f;
+    ct->compiled = 1;
+    return 0;
+}
+
+/* 查找 raw 所在段 i，满足 points[i] < raw <= points[i+1]（边界归属左段，与旧实现一致） */
+static int CalFindSegment(const float *points, int n, float raw)
+{
+    int lo = 0, hi = n - 2;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (raw <= points[mid + 1]) hi = mid;
+        else                        lo = mid + 1;
+    }
+    return lo;
+}
+
+static inline float CalApplySegment(const CalTable *ct, int i, float raw)
+{
+    float slope = ct->compiled ? ct->slopes[i]
+                : (ct->offsets[i + 1] - ct->offsets[i]) / (ct->points[i + 1] - ct->points[i]);
+    return raw + ct->offsets[i] + slope * (raw - ct->points[i]);
+}
+
+/**
+ * @brief 分段线性校准；表外使用端点偏移量
+ *        未编译的表仍可使用，只是每次要做一次除法
+ */
 float CalibrateCurrent(const CalTable *ct, float rawCurrent) {
     const float *points = ct->points;
-    const float *offs   = ct->offsets;
     int n = ct->num_points;
 
+    if (n <= 0) return rawCurrent;
     // 低于最小点
     if (rawCurrent <= points[0]) {
-        return rawCurrent + offs[0];
+        return rawCurrent + ct->offsets[0];
     }
     // 高于最大点
     if (rawCurrent >= points[n - 1]) {
-        return rawCurrent + offs[n - 1];
+        return rawCurrent + ct->offsets[n - 1];
+    }
+
+    return CalApplySegment(ct, CalFindSegment(points, n, rawCurrent), rawCurrent);
+}
+
+/**
+ * @brief 批量校准一块样本（允许 in == out）
+ *        相邻样本通常落在同一段，先检查上一段命中，未命中再二分
+ */
+void CalibrateBlock(const CalTable *ct, const float *in, float *out, uint16_t n)
+{
+    const float *points = ct->points;
+    int np = ct->num_points;
+    int seg = -1;
+
+    if (np <= 0) {
+        if (out != in) memcpy(out, in, n * sizeof(float));
+        return;
+    }
+
+    for (uint16_t k = 0; k < n; k++) {
+        float x = in[k];
+        if (x <= points[0]) {
+            out[k] = x + ct->offsets[0];
+        } else if (x >= points[np - 1]) {
+            out[k] = x + ct->offsets[np - 1];
+        } else {
+            if (seg < 0 || !(x > points[seg] && x <= points[seg + 1]))
+                seg = CalFindSegment(points, np, x);
+            out[k] = CalApplySegment(ct, seg, x);
+        }
+    }
+}
+
+
+/* 校准表登记：按 CalTable.id 选择量程/设备对应的表 */
+static const CalTable *cal_tables[CAL_MAX_TABLES];
+
+/**
+ * @brief 登记一张校准表（同 id 覆盖旧表），表需保持有效
+ * @return 0 成功，-1 表满
+ */
+/* id 已登记时返回其槽位，否则返回第一个空槽；-1 已满 */
+static int CalFindSlot(int id)
+{
+    int slot = -1;
+    for (int i = 0; i < CAL_MAX_TABLES; i++) {
+        if (cal_tables[i] != NULL && cal_tables[i]->id == id) return i;
+        if (cal_tables[i] == NULL && slot < 0) slot = i;
     }
+    return slot;
+}
 
-    // 分段线性插值
+int CalRegister(const CalTable *ct)
+{
+    int slot = CalFindSlot(ct->id);
+    if (slot < 0) return -1;
+    cal_tables[slot] = ct;
+    return 0;
+}
+
+const CalTable *CalSelect(int id)
+{
+    for (int i = 0; i < CAL_MAX_TABLES; i++) {
+        if (cal_tables[i] != NULL && cal_tables[i]->id == id) return cal_tables[i];
+    }
+    return NULL;
+}
+
+/* 未登记的 id 原样返回 */
+float CalibrateById(int id, float rawCurrent)
+{
+    const CalTable *ct = CalSelect(id);
+    return ct ? CalibrateCurrent(ct, rawCurrent) : rawCurrent;
+}
+
+
+/* ------------------------------------------------------------------
+  校准拟合
+  模型：ref - raw = Σ o_j · φ_j(raw)，φ_j 为节点上的三角基函数（表外取端点，
+  与 CalibrateCurrent 的外推一致）。每个样本只涉及相邻两个节点，法方程为三对角，
+  追赶法求解。拟合后按残差 MAD 剔除离群点再拟合，最多 3 轮。
+   ------------------------------------------------------------------ */
+void CalFitBegin(CalFitSession *s)
+{
+    s->count    = 0;
+    s->rejected = 0;
+    s->rms      = 0.0f;
+}
+
+/* @return 0 成功，-1 缓冲区已满 */
+int CalFitAdd(CalFitSession *s, float raw, float ref)
+{
+    if (s->count >= CAL_FIT_MAX_SAMPLES) return -1;
+    s->raw[s->count] = raw;
+    s->ref[s->count] = ref;
+    s->count++;
+    return 0;
+}
+
+static int CalFitCmpFloat(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+/* 样本在节点上的分配：seg 段，权重 (1-t, t) */
+static void CalFitBasis(const float *knots, int n, float x, int *seg, float *t)
+{
+    if (n == 1 || x <= knots[0]) { *seg = 0; *t = 0.0f; return; }
+    if (x >= knots[n - 1])       { *seg = n - 2; *t = 1.0f; return; }
+    int i = CalFindSegment(knots, n, x);
+    *seg = i;
+    *t = (x - knots[i]) / (knots[i + 1] - knots[i]);
+}
+
+/* 对 used 样本做一次加权最小二乘，结果写入 off[]；成功返回 0 */
+static int CalFitOnce(CalFitSession *s, const float *knots, int n, float *off)
+{
+    float d[MAX_CAL_POINTS], e[MAX_CAL_POINTS], r[MAX_CAL_POINTS];  // 主对角、次对角、右端
+    memset(d, 0, sizeof(d));
+    memset(e, 0, sizeof(e));
+    memset(r, 0, sizeof(r));
+
+    for (uint16_t k = 0; k < s->count; k++) {
+        if (!s->used[k]) continue;
+        int i; float t;
+        CalFitBasis(knots, n, s->raw[k], &i, &t);
+        float y = s->ref[k] - s->raw[k];
+        if (n == 1) { d[0] += 1.0f; r[0] += y; continue; }
+        float a = 1.0f - t;
+        d[i]     += a * a;
+        d[i + 1] += t * t;
+        e[i]     += a * t;
+        r[i]     += a * y;
+        r[i + 1] += t * y;
+    }
+
+    /* 微弱的相邻节点平滑项，保证无数据的节点也有解 */
+    const float lambda = 1e-4f;
     for (int i = 0; i < n - 1; i++) {
-        float x0 = points[i];
-        float x1 = points[i + 1];
-        if (rawCurrent > x0 && rawCurrent <= x1) { // 边界归属右区间
-            float o0 = offs[i];
-            float o1 = offs[i + 1];
-            float slope = (o1 - o0) / (x1 - x0);
-            float o = o0 + slope * (rawCurrent - x0);
-            return rawCurrent + o;
+        d[i] += lambda; d[i + 1] += lambda; e[i] -= lambda;
+    }
+    if (n == 1 && d[0] <= 0.0f) return -1;
+
+    /* 追赶法 */
+    for (int i = 1; i < n; i++) {
+        if (d[i - 1] <= 0.0f) return -1;
+        float m = e[i - 1] / d[i - 1];
+        d[i] -= m * e[i - 1];
+        r[i] -= m * r[i - 1];
+    }
+    if (d[n - 1] <= 0.0f) return -1;
+    off[n - 1] = r[n - 1] / d[n - 1];
+    for (int i = n - 2; i >= 0; i--) {
+        off[i] = (r[i] - e[i] * off[i + 1]) / d[i];
+    }
+    return 0;
+}
+
+static float CalFitResidual(const CalFitSession *s, const float *knots, int n, const float *off, uint16_t k)
+{
+    int i; float t;
+    CalFitBasis(knots, n, s->raw[k], &i, &t);
+    float o = (n == 1) ? off[0] : off[i] + t * (off[i + 1] - off[i]);
+    return s->ref[k] - s->raw[k] - o;
+}
+
+/**
+ * @brief 拟合校准表
+ * @param knots 节点（升序），NULL 时按原始值分位数自动选取
+ * @param nknots 节点数，1..MAX_CAL_POINTS
+ * @param reject_k 离群阈值（|残差| > k × 1.4826 × MAD 剔除），≤0 不剔除，常用 3
+ * @param out 输出表（id 保留调用者设置的值），成功后已编译
+ * @return 0 成功，-1 样本不足或无解
+ */
+int CalFitSolve(CalFitSession *s, const float *knots, int nknots, float reject_k, CalTable *out)
+{
+    float kn[MAX_CAL_POINTS], off[MAX_CAL_POINTS];
+    uint16_t n = s->count;
+
+    if (nknots < 1 || nknots > MAX_CAL_POINTS || n < (uint16_t)nknots) return -1;
+
+    if (knots != NULL) {
+        memcpy(kn, knots, nknots * sizeof(float));
+    } else {
+        memcpy(s->scratch, s->raw, n * sizeof(float));
+        qsort(s->scratch, n, sizeof(float), CalFitCmpFloat);
+        for (int j = 0; j < nknots; j++) {
+            kn[j] = s->scratch[(nknots == 1) ? n / 2 : (uint32_t)j * (n - 1) / (nknots - 1)];
+        }
+    }
+    for (int j = 0; j < nknots - 1; j++) {
+        if (!(kn[j + 1] > kn[j])) return -1;            // 重复节点（样本过于集中）
+    }
+
+    memset(s->used, 1, n);
+    s->rejected = 0;
+    if (CalFitOnce(s, kn, nknots, off) != 0) return -1;
+
+    for (int pass = 0; pass < 3 && reject_k > 0.0f; pass++) {
+        uint16_t m = 0;
+        for (uint16_t k = 0; k < n; k++) {
+            if (s->used[k]) s->scratch[m++] = fabsf(CalFitResidual(s, kn, nknots, off, k));
+        }
+        qsort(s->scratch, m, sizeof(float), CalFitCmpFloat);
+        float thr = reject_k * 1.4826f * s->scratch[m / 2];
+        if (thr <= 0.0f) break;
+
+        uint16_t dropped = 0;
+        for (uint16_t k = 0; k < n; k++) {
+            if (s->used[k] && fabsf(CalFitResidual(s, kn, nknots, off, k)) > thr) {
+                s->used[k] = 0;
+                dropped++;
+            }
         }
+        if (dropped == 0) break;
+        s->rejected += dropped;
+        if (CalFitOnce(s, kn, nknots, off) != 0) return -1;
     }
 
-    return rawCurrent; // 理论上不会到达
+    float ss = 0.0f;
+    uint16_t m = 0;
+    for (uint16_t k = 0; k < n; k++) {
+        if (!s->used[k]) continue;
+        float rr = CalFitResidual(s, kn, nknots, off, k);
+        ss += rr * rr;
+        m++;
+    }
+    s->rms = (m > 0) ? sqrtf(ss / m) : 0.0f;
+
+    out->num_points = nknots;
+    memcpy(out->points, kn, nknots * sizeof(float));
+    memcpy(out->offsets, off, nknots * sizeof(float));
+    return CalTableCompile(out);
 }
 
 
+/* ------------------------------------------------------------------
+  校准表持久化
+  布局（小端）：magic u32 | version u16 | num_points u16 | id i32 |
+               points f32[n] | offsets f32[n] | crc32 u32（覆盖之前所有字节）
+   ------------------------------------------------------------------ */
+uint32_t Crc32(const void *data, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFFUL;
+    while (len--) {
+        crc ^= *p++;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1UL)));
+        }
+    }
+    return ~crc;
+}
+
+static void CalPutU32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t CalGetU32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* @return 写入字节数，-1 缓冲区不足或表无效 */
+int CalTableSerialize(const CalTable *ct, uint8_t *buf, uint32_t max)
+{
+    int n = ct->num_points;
+    if (n < 1 || n > MAX_CAL_POINTS) return -1;
+    uint32_t len = 12 + 8 * (uint32_t)n + 4;
+    if (len > max) return -1;
+
+    CalPutU32(buf, CAL_BLOB_MAGIC);
+    CalPutU32(buf + 4, (uint32_t)CAL_BLOB_VERSION | ((uint32_t)n << 16));
+    CalPutU32(buf + 8, (uint32_t)ct->id);
+    uint8_t *p = buf + 12;
+    for (int i = 0; i < n; i++, p += 4) { uint32_t v; memcpy(&v, &ct->points[i], 4);  CalPutU32(p, v); }
+    for (int i = 0; i < n; i++, p += 4) { uint32_t v; memcpy(&v, &ct->offsets[i], 4); CalPutU32(p, v); }
+    CalPutU32(p, Crc32(buf, len - 4));
+    return (int)len;
+}
+
+/* 校验 magic / 版本 / 长度 / CRC 后还原并编译；@return 0 成功，-1 数据无效 */
+int CalTableDeserialize(const uint8_t *buf, uint32_t len, CalTable *ct)
+{
+    if (len < 16 || CalGetU32(buf) != CAL_BLOB_MAGIC) return -1;
+    uint32_t w = CalGetU32(buf + 4);
+    uint32_t n = w >> 16;
+    if ((w & 0xFFFF) != CAL_BLOB_VERSION || n < 1 || n > MAX_CAL_POINTS) return -1;
+    if (len != 12 + 8 * n + 4) return -1;
+    if (CalGetU32(buf + len - 4) != Crc32(buf, len - 4)) return -1;
+
+    CalTable t;
+    memset(&t, 0, sizeof(t));
+    t.id = (int)CalGetU32(buf + 8);
+    t.num_points = (int)n;
+    const uint8_t *p = buf + 12;
+    for (uint32_t i = 0; i < n; i++, p += 4) { uint32_t v = CalGetU32(p); memcpy(&t.points[i], &v, 4); }
+    for (uint32_t i = 0; i < n; i++, p += 4) { uint32_t v = CalGetU32(p); memcpy(&t.offsets[i], &v, 4); }
+    if (CalTableCompile(&t) != 0) return -1;
+
+    *ct = t;
+    return 0;
+}
+
+static void CalKey(char *key, int id)
+{
+    snprintf(key, 16, "cal%d", id);
+}
+
+/* @return 0 成功，-1 失败 */
+int CalTableSave(const CalStore *st, const CalTable *ct)
+{
+    uint8_t buf[CAL_BLOB_MAX];
+    char key[16];
+    int len = CalTableSerialize(ct, buf, sizeof(buf));
+    if (len < 0) return -1;
+    CalKey(key, ct->id);
+    return st->write(st->ctx, key, buf, (uint32_t)len);
+}
+
+/**
+ * @brief 开机加载：读取 id 对应的校准块，校验通过后编译并登记到 CalSelect
+ * @param ct 存放加载结果，登记后需保持有效（通常为静态变量）
+ * @return 0 成功，-1 不存在或校验失败（ct 不变）
+ */
+int CalTableLoad(const CalStore *st, int id, CalTable *ct)
+{
+    uint8_t buf[CAL_BLOB_MAX];
+    char key[16];
+    CalTable t;
+    CalKey(key, id);
+    int len = st->read(st->ctx, key, buf, sizeof(buf));
+    if (len <= 0 || CalTableDeserialize(buf, (uint32_t)len, &t) != 0) return -1;
+    if (t.id != id || CalFindSlot(id) < 0) return -1;
+
+    /* 全部检查通过后才改写 ct：ct 可能正登记在 CalSelect 中 */
+    *ct = t;
+    return CalRegister(ct);
+}
+
+#ifdef ESP_PLATFORM
+static int CalNvsWrite(void *ctx, const char *key, const void *data, uint32_t len)
+{
+    nvs_handle_t h;
+    if (nvs_open((const char *)ctx, NVS_READWRITE, &h) != ESP_OK) return -1;
+    esp_err_t err = nvs_set_blob(h, key, data, len);
+    if (err == ESP_OK) err = nvs_commit(h);
+    nvs_close(h);
+    return (err == ESP_OK) ? 0 : -1;
+}
+
+static int CalNvsRead(void *ctx, const char *key, void *data, uint32_t max)
+{
+    nvs_handle_t h;
+    size_t len = max;
+    if (nvs_open((const char *)ctx, NVS_READONLY, &h) != ESP_OK) return -1;
+    esp_err_t err = nvs_get_blob(h, key, data, &len);
+    nvs_close(h);
+    return (err == ESP_OK) ? (int)len : -1;
+}
+
+/* NVS 后端：每张表一个 blob，键名 "cal<id>"；调用前需已执行 nvs_flash_init() */
+void CalStoreNVS_Init(CalStore *st, const char *nvs_namespace)
+{
+    st->write = CalNvsWrite;
+    st->read  = CalNvsRead;
+    st->ctx   = (void *)nvs_namespace;
+}
+#endif
+
+
 /* ------------------------------------------------------------------
   多通道最大值查找
    ------------------------------------------------------------------ */
@@ -307,7 +1433,204 @@ float MaxValue(uint8_t id, float value)
         max_values[id] = value;
     }
 
-    return max_values[id];
+    return max_values[id];
+}
+
+
+/* ------------------------------------------------------------------
+  统计引擎
+  自复位起：Welford 单趟更新（double，样本数超过 2^24 仍能跟随）。窗口：跨度均分为 N 个时间桶，每桶各自做 Welford，
+  查询时用 Chan 并行公式合并 N 个桶，得到最近 (N-1)~N 个桶跨度内的统计量。
+  不保存样本，内存与采样率无关。
+   ------------------------------------------------------------------ */
+static void StatsAccumClear(StatsAccum *a)
+{
+    a->n    = 0;
+    a->mean = 0.0f;
+    a->m2   = 0.0f;
+    a->min  = 0.0f;
+    a->max  = 0.0f;
+}
+
+static inline void StatsAccumAdd(StatsAccum *a, float x)
+{
+    if (a->n == 0) {
+        a->min = a->max = x;
+    } else {
+        if (x < a->min) a->min = x;
+        if (x > a->max) a->max = x;
+    }
+    a->n++;
+    float d = x - a->mean;
+    a->mean += d / (float)a->n;
+    a->m2   += d * (x - a->mean);
+}
+
+static void StatsAccumMerge(StatsAccum *a, const StatsAccum *b)
+{
+    if (b->n == 0) return;
+    if (a->n == 0) { *a = *b; return; }
+
+    float n = (float)a->n + (float)b->n;
+    float d = b->mean - a->mean;
+    a->mean += d * (float)b->n / n;
+    a->m2   += b->m2 + d * d * (float)a->n * (float)b->n / n;
+    if (b->min < a->min) a->min = b->min;
+    if (b->max > a->max) a->max = b->max;
+    a->n += b->n;
+}
+
+static void StatsAccumResult(const StatsAccum *a, StatsResult *out)
+{
+    out->n = a->n;
+    if (a->n == 0) {
+        out->min = out->max = out->mean = out->rms = out->stddev = 0.0f;
+        return;
+    }
+    float var = a->m2 / (float)a->n;
+    if (var < 0.0f) var = 0.0f;
+    out->min    = a->min;
+    out->max    = a->max;
+    out->mean   = a->mean;
+    out->stddev = sqrtf(var);
+    out->rms    = sqrtf(a->mean * a->mean + var);
+}
+
+/* 自复位起累计：同 StatsAccumAdd，均值与 M2 用 double */
+static void StatsTotalClear(StatsTotalAccum *a)
+{
+    a->n    = 0;
+    a->mean = 0.0;
+    a->m2   = 0.0;
+    a->min  = 0.0f;
+    a->max  = 0.0f;
+}
+
+static inline void StatsTotalAdd(StatsTotalAccum *a, float x)
+{
+    if (a->n == 0) {
+        a->min = a->max = x;
+    } else {
+        if (x < a->min) a->min = x;
+        if (x > a->max) a->max = x;
+    }
+    a->n++;
+    double d = (double)x - a->mean;
+    a->mean += d / (double)a->n;
+    a->m2   += d * ((double)x - a->mean);
+}
+
+static void StatsTotalResult(const StatsTotalAccum *a, StatsResult *out)
+{
+    out->n = a->n;
+    if (a->n == 0) {
+        out->min = out->max = out->mean = out->rms = out->stddev = 0.0f;
+        return;
+    }
+    double var = a->m2 / (double)a->n;
+    if (var < 0.0) var = 0.0;
+    out->min    = a->min;
+    out->max    = a->max;
+    out->mean   = (float)a->mean;
+    out->stddev = (float)sqrt(var);
+    out->rms    = (float)sqrt(a->mean * a->mean + var);
+}
+
+void StatsInit(StatsChannel *s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+/* 默认窗口：1 s（10 × 100 ms）与 1 min（12 × 5 s） */
+void StatsInitDefault(StatsChannel *s)
+{
+    StatsInit(s);
+    StatsAddWindow(s, 1000000UL, 10);
+    StatsAddWindow(s, 60000000UL, 12);
+}
+
+/**
+ * @brief 增加一个滑动窗口
+ * @param span_us 窗口跨度
+ * @param nbuckets 分桶数（2..STATS_MAX_BUCKETS），越多窗口边缘越精确
+ * @return 窗口序号，-1 参数无效或窗口已满
+ */
+int StatsAddWindow(StatsChannel *s, uint32_t span_us, uint8_t nbuckets)
+{
+    if (s->nwin >= STATS_MAX_WINDOWS || nbuckets < 2 || nbuckets > STATS_MAX_BUCKETS) return -1;
+    if (span_us < nbuckets) return -1;
+
+    StatsWindow *w = &s->win[s->nwin];
+    memset(w, 0, sizeof(*w));
+    w->nbuckets  = nbuckets;
+    w->bucket_us = span_us / nbuckets;
+    return s->nwin++;
+}
+
+/* 清零自复位起统计与所有窗口，窗口配置保留 */
+void StatsReset(StatsChannel *s)
+{
+    StatsTotalClear(&s->total);
+    for (uint8_t i = 0; i < s->nwin; i++) {
+        StatsWindow *w = &s->win[i];
+        for (uint8_t b = 0; b < w->nbuckets; b++) StatsAccumClear(&w->bucket[b]);
+        w->bucket_end_us = 0;
+        w->head = 0;
+    }
+}
+
+/* 时间推进到 t_us 所在的桶，途经的桶清空 */
+static void StatsWindowAdvance(StatsWindow *w, uint64_t t_us)
+{
+    if (w->bucket_end_us == 0) {
+        w->bucket_end_us = t_us - t_us % w->bucket_us + w->bucket_us;
+        return;
+    }
+    if (t_us < w->bucket_end_us) return;
+
+    uint64_t steps = (t_us - w->bucket_end_us) / w->bucket_us + 1;
+    if (steps >= w->nbuckets) {
+        for (uint8_t b = 0; b < w->nbuckets; b++) StatsAccumClear(&w->bucket[b]);
+    } else {
+        for (uint64_t k = 0; k < steps; k++) {
+            if (++w->head >= w->nbuckets) w->head = 0;
+            StatsAccumClear(&w->bucket[w->head]);
+        }
+    }
+    w->bucket_end_us += steps * w->bucket_us;
+}
+
+/* @param t_us 样本时间戳（μs，单调递增） */
+void StatsUpdate(StatsChannel *s, uint64_t t_us, float x)
+{
+    StatsTotalAdd(&s->total, x);
+    for (uint8_t i = 0; i < s->nwin; i++) {
+        StatsWindow *w = &s->win[i];
+        StatsWindowAdvance(w, t_us);
+        StatsAccumAdd(&w->bucket[w->head], x);
+    }
+}
+
+void StatsTotal(const StatsChannel *s, StatsResult *out)
+{
+    StatsTotalResult(&s->total, out);
+}
+
+/**
+ * @brief 读取窗口统计量
+ * @param now_us 当前时间，用于让长时间无样本的旧桶过期
+ */
+void StatsWindowResult(StatsChannel *s, uint8_t w, uint64_t now_us, StatsResult *out)
+{
+    StatsAccum acc;
+    StatsAccumClear(&acc);
+
+    if (w < s->nwin) {
+        StatsWindow *win = &s->win[w];
+        StatsWindowAdvance(win, now_us);
+        for (uint8_t b = 0; b < win->nbuckets; b++) StatsAccumMerge(&acc, &win->bucket[b]);
+    }
+    StatsAccumResult(&acc, out);
 }
 
 /* ------------------------------------------------------------------
@@ -345,27 +1668,25 @@ typedef enum {
     STATE_SPAN,
     STATE_ON
 } PWM_State;
-uint8_t CalculatePWM(float temperature)
-{
-	/**
+/**
  * 按照 OFF→SPAN→ON→FULL→SPAN→OFF 的入口方向输出占空比：
- * - OFF 区：t < TEMP_OFF，输出 PWM_OFF
- * - SPAN 区：TEMP_OFF ≤ t < TEMP_SPAN
- *      ? 如果上一次非 SPAN 是 OFF → 输出 PWM_OFF
- *      ? 如果上一次非 SPAN 是 ON  → 输出 PWM_SPAN_DOWN
- * - ON 区：t ≥ TEMP_SPAN
- *      ? TEMP_SPAN ≤ t < TEMP_SET：线性 PWM_ON→PWM_MAX
- *      ? t ≥ TEMP_SET：输出 PWM_MAX
+ * - OFF 区：t < t_off，输出 pwm_off
+ * - SPAN 区：t_off ≤ t < t_span
+ *      ? 如果上一次非 SPAN 是 OFF → 输出 pwm_off
+ *      ? 如果上一次非 SPAN 是 ON  → 输出 pwm_span_down
+ * - ON 区：t ≥ t_span
+ *      ? t_span ≤ t < t_set：线性 pwm_on→pwm_max
+ *      ? t ≥ t_set：输出 pwm_max
+ * @param lastNonSpan 记忆上一次的非 SPAN 状态（每个风扇各自一份）
  */
-    // 记忆上一次的非 SPAN 状态（初始假定为 OFF）
-    static PWM_State lastNonSpan = STATE_OFF;
-
+static uint8_t FanCurveEval(const FanCurve *c, uint8_t *lastNonSpan, float temperature)
+{
     // 判定当前区间
     PWM_State curState;
-    if (temperature < TEMP_OFF) {
+    if (temperature < c->t_off) {
         curState = STATE_OFF;
     }
-    else if (temperature < TEMP_SPAN) {
+    else if (temperature < c->t_span) {
         curState = STATE_SPAN;
     }
     else {
@@ -374,30 +1695,30 @@ uint8_t CalculatePWM(float temperature)
 
     // 进入非 SPAN 时，更新 lastNonSpan
     if (curState != STATE_SPAN) {
-        lastNonSpan = curState;
+        *lastNonSpan = (uint8_t)curState;
     }
 
     // 计算 PWM
     uint8_t pwm;
     switch (curState) {
         case STATE_OFF:
-            pwm = PWM_OFF;
+            pwm = c->pwm_off;
             break;
 
         case STATE_SPAN:
             // 从 OFF→SPAN 或从 ON→SPAN 的区分
-            pwm = (lastNonSpan == STATE_OFF) ? PWM_OFF : PWM_SPAN_DOWN;
+            pwm = (*lastNonSpan == STATE_OFF) ? c->pwm_off : c->pwm_span_down;
             break;
 
         case STATE_ON:
         default:
             // ON、FULL 区：先做线性，再满速
-            if (temperature < TEMP_SET) {
-                float ratio = (temperature - TEMP_SPAN) / (TEMP_SET - TEMP_SPAN);
-                pwm = PWM_ON + (uint8_t)((PWM_MAX - PWM_ON) * ratio + 0.5f);
+            if (temperature < c->t_set) {
+                float ratio = (temperature - c->t_span) / (c->t_set - c->t_span);
+                pwm = c->pwm_on + (uint8_t)((c->pwm_max - c->pwm_on) * ratio + 0.5f);
             }
             else {
-                pwm = PWM_MAX;
+                pwm = c->pwm_max;
             }
             break;
     }
@@ -405,32 +1726,330 @@ uint8_t CalculatePWM(float temperature)
     return pwm;
 }
 
+const FanCurve FanCurveDefault = {
+    TEMP_OFF, TEMP_SPAN, TEMP_SET, PWM_OFF, PWM_SPAN_DOWN, PWM_ON, PWM_MAX
+};
+
+uint8_t CalculatePWM(float temperature)
+{
+    // 记忆上一次的非 SPAN 状态（初始假定为 OFF）
+    static uint8_t lastNonSpan = STATE_OFF;
+
+    return FanCurveEval(&FanCurveDefault, &lastNonSpan, temperature);
+}
+
+
+/* ------------------------------------------------------------------
+  风扇控制器
+  目标占空比（曲线或 PID）→ 堵转处理 → 斜率限制 → 输出。
+  PID 的微分项作用于测量值，设定值变化不会产生尖峰；输出饱和时停止积分（抗饱和）。
+   ------------------------------------------------------------------ */
+static void FanCtrlInitCommon(FanCtrl *f, uint8_t sensor)
+{
+    memset(f, 0, sizeof(*f));
+    f->sensor        = sensor;
+    f->last_non_span = STATE_OFF;
+    f->prev_temp     = NAN;
+}
+
+void FanCtrlInitCurve(FanCtrl *f, const FanCurve *curve, uint8_t sensor)
+{
+    FanCtrlInitCommon(f, sensor);
+    f->mode  = FAN_MODE_CURVE;
+    f->curve = curve ? *curve : FanCurveDefault;
+}
+
+void FanCtrlInitPid(FanCtrl *f, const FanPid *pid, uint8_t sensor)
+{
+    FanCtrlInitCommon(f, sensor);
+    f->mode = FAN_MODE_PID;
+    f->pid  = *pid;
+    f->curve.pwm_max = 100;
+    FanCtrlSetTarget(f, pid->setpoint_c);
+}
+
+/**
+ * @brief 启用转速反馈
+ * @param pulses_per_rev 每转脉冲数（常见 2）
+ * @param stall_rpm 堵转判据转速
+ * @param stall_ms 低于 stall_rpm 持续多久判为堵转
+ * @param stall_min_pwm 占空比低于此值不判堵转（风扇本就可能停转）
+ */
+void FanCtrlSetTach(FanCtrl *f, uint8_t pulses_per_rev, uint16_t stall_rpm, uint16_t stall_ms, uint8_t stall_min_pwm)
+{
+    f->pulses_per_rev = pulses_per_rev;
+    f->stall_rpm      = stall_rpm;
+    f->stall_ms       = stall_ms;
+    f->stall_min_pwm  = stall_min_pwm;
+    f->tach_last      = f->tach_pulses;
+    f->tach_acc_ms    = 0;
+    f->rpm_valid      = 0;
+    f->stall_timer_ms = 0;
+    f->stalled        = 0;
+}
+
+/* 修改设定值并重新开始统计调节时间与超调 */
+void FanCtrlSetTarget(FanCtrl *f, float setpoint_c)
+{
+    f->pid.setpoint_c = setpoint_c;
+    f->since_step_ms  = 0;
+    f->settle_ms      = 0;
+    f->overshoot_c    = 0.0f;
+    f->step_sign      = 0;
+}
+
+/* 转速脉冲中断中调用 */
+void FanCtrlTachISR(FanCtrl *f)
+{
+    f->tach_pulses++;
+}
+
+/* 转速测量与堵转判定；至少累计 500 ms 再计算转速，减少低转速下的量化误差；
+   第一个测速周期结束前 rpm 尚无意义，不判堵转 */
+static void FanCtrlTach(FanCtrl *f, uint32_t dt_ms)
+{
+    if (f->pulses_per_rev == 0) return;
+
+    f->tach_acc_ms += dt_ms;
+    if (f->tach_acc_ms >= 500) {
+        uint32_t now = f->tach_pulses;
+        uint32_t pulses = now - f->tach_last;
+        f->tach_last = now;
+        f->rpm = (float)pulses * 60000.0f / ((float)f->pulses_per_rev * (float)f->tach_acc_ms);
+        f->tach_acc_ms = 0;
+        f->rpm_valid   = 1;
+    }
+    if (!f->rpm_valid) return;
+
+    if (f->duty >= f->stall_min_pwm && f->rpm < f->stall_rpm) {
+        f->stall_timer_ms += dt_ms;
+        if (!f->stalled && f->stall_timer_ms >= f->stall_ms) {
+            f->stalled = 1;
+            f->stall_events++;
+        }
+    } else {
+        f->stall_timer_ms = 0;
+        f->stalled = 0;
+    }
+}
+
+static float FanCtrlPid(FanCtrl *f, float temp_c, float dt_s)
+{
+    FanPid *p = &f->pid;
+    float err = temp_c - p->setpoint_c;            // 温度高于设定值 → 加大占空比
+    float d   = isnan(f->prev_temp) ? 0.0f : (temp_c - f->prev_temp) / dt_s;
+    f->prev_temp = temp_c;
+
+    float out = p->kp * err + f->integ + p->kd * d;
+    float lo = (float)f->pwm_min, hi = (float)f->curve.pwm_max;
+    if ((out < hi || err < 0.0f) && (out > lo || err > 0.0f)) {
+        f->integ += p->ki * err * dt_s;
+        out = p->kp * err + f->integ + p->kd * d;
+    }
+    if (out < lo) out = lo;
+    if (out > hi) out = hi;
+
+    /* 指标 */
+    f->since_step_ms += (uint32_t)(dt_s * 1000.0f + 0.5f);
+    if (f->step_sign == 0 && err != 0.0f) f->step_sign = (err > 0.0f) ? 1 : -1;
+    float over = -(float)f->step_sign * err;
+    if (over > f->overshoot_c) f->overshoot_c = over;
+    if (fabsf(err) <= p->settle_band_c) {
+        if (f->settle_ms == 0) f->settle_ms = f->since_step_ms;
+    } else {
+        f->settle_ms = 0;
+    }
+    return out;
+}
+
+/**
+ * @brief 控制器单步
+ * @param temp_c 当前温度
+ * @param dt_ms 距上次调用的时间
+ * @return 占空比 %
+ */
+uint8_t FanCtrlUpdate(FanCtrl *f, float temp_c, uint32_t dt_ms)
+{
+    if (dt_ms == 0) dt_ms = 1;
+
+    float target = (f->mode == FAN_MODE_PID)
+                 ? FanCtrlPid(f, temp_c, (float)dt_ms * 0.001f)
+                 : (float)FanCurveEval(&f->curve, &f->last_non_span, temp_c);
+
+    FanCtrlTach(f, dt_ms);
+
+    if (f->stalled) {
+        f->duty = (float)f->curve.pwm_max;         // 堵转时满占空比尝试重新起转
+    } else if (f->slew_pct_per_s > 0.0f) {
+        float step = f->slew_pct_per_s * (float)dt_ms * 0.001f;
+        if      (target > f->duty + step) f->duty += step;
+        else if (target < f->duty - step) f->duty -= step;
+        else                              f->duty  = target;
+    } else {
+        f->duty = target;
+    }
+    return (uint8_t)(f->duty + 0.5f);
+}
+
+/* 多风扇：fans[i] 使用 temps[fans[i].sensor]，结果写入 duty_out[i] */
+void FanCtrlRunAll(FanCtrl *fans, uint8_t n, const float *temps, uint32_t dt_ms, uint8_t *duty_out)
+{
+    for (uint8_t i = 0; i < n; i++) {
+        duty_out[i] = FanCtrlUpdate(&fans[i], temps[fans[i].sensor], dt_ms);
+    }
+}
+
 
 
 /* ------------------------------------------------------------------
   计算瓦时
    ------------------------------------------------------------------ */
+/* 内部改用 EnergyAcc 整数累计，避免大 float 总量上叠加微小增量造成的精度损失 */
 float calc_wh(uint64_t curr_ms, float power_w) {
-    static uint64_t prev_ms = 0;   // 保存上一次时间戳
-    static float total_wh = 0.0f;  // 累计能量 (Wh)
+    static EnergyAcc acc;          // 全零即为初始状态
+    EnergySnapshot snap;
+
+    EnergyAccFeed(&acc, curr_ms * 1000ULL, 0, (int64_t)llroundf(power_w * 1e6f));   // 32 位 long 只容得下约 2147 W
+    EnergyAccSnapshot(&acc, &snap);
+    return EnergyAccWattHours(&snap);
+}
+
+/* 整数版本：功率 μW，返回累计 μWh；不足 1 μWh 的余量（μW·ms）保留到下次，长时间累计无截断损失 */
+int64_t calc_uwh(uint64_t curr_ms, int64_t power_uw) {
+    static uint64_t prev_ms   = 0;
+    static int64_t  total_uwh = 0;
+    static int64_t  rem       = 0;     // μW·ms，|rem| < 3600000
 
     if (prev_ms == 0) {
-        // 第一次调用，只记录时间戳，不计算
         prev_ms = curr_ms;
-        return total_wh;
+        return total_uwh;
     }
 
-    // 时间差 (毫秒)
     uint64_t delta_ms = curr_ms - prev_ms;
     prev_ms = curr_ms;
 
-    // 转换为小时
-    float delta_h = (float)delta_ms / 3600000.0f;
+    rem += power_uw * (int64_t)delta_ms;
+    total_uwh += rem / 3600000;
+    rem        = rem % 3600000;
+
+    return total_uwh;
+}
+
+
+/* ------------------------------------------------------------------
+  电量/能量累计器
+  相邻两个样本按梯形积分：(a + b) × dt / 2。为免除法与截断，先累加 (a + b) × dt
+  到余量，满 2e6（即 1 μA·s / 1 μW·s）才进位到整数总量。
+  720 W、dt 10 s 时单步为 1.4e16，远小于 int64 上限。
+   ------------------------------------------------------------------ */
+#define ENERGY_UNIT2   2000000LL   // 1 s × 1e6 μs/s × 2（梯形的 1/2）
+
+void EnergyAccInit(EnergyAcc *acc)
+{
+    memset(acc, 0, sizeof(*acc));
+}
+
+/* 清零累计值；保留上一个样本作为新的积分起点，复位前后不丢区间 */
+void EnergyAccReset(EnergyAcc *acc)
+{
+    memset(&acc->tot, 0, sizeof(acc->tot));
+    acc->rem_q = 0;
+    acc->rem_e = 0;
+}
+
+static inline void EnergyCarry(int64_t *total, int64_t *rem)
+{
+    if (*rem >= ENERGY_UNIT2 || *rem <= -ENERGY_UNIT2) {
+        int64_t q = *rem / ENERGY_UNIT2;
+        *total += q;
+        *rem   -= q * ENERGY_UNIT2;
+    }
+}
+
+/**
+ * @brief 送入一个样本
+ * @param t_us 样本时间戳（μs，单调递增，如 INA226_Snapshot.t_us）
+ * @param current_ua 电流 μA（不需要电荷时传 0）
+ * @param power_uw 功率 μW
+ */
+void EnergyAccFeed(EnergyAcc *acc, uint64_t t_us, int32_t current_ua, int64_t power_uw)
+{
+    if (acc->started && t_us > acc->last_us) {
+        int64_t dt = (int64_t)(t_us - acc->last_us);
+
+        acc->rem_q += ((int64_t)acc->last_ua + current_ua) * dt;
+        acc->rem_e += (acc->last_uw + power_uw) * dt;
+        EnergyCarry(&acc->tot.uas, &acc->rem_q);
+        EnergyCarry(&acc->tot.uws, &acc->rem_e);
+
+        acc->tot.elapsed_us += (uint64_t)dt;
+    }
+    acc->last_us = t_us;
+    acc->last_ua = current_ua;
+    acc->last_uw = power_uw;
+    acc->started = 1;
+    acc->tot.samples++;
+}
+
+/* 在其他任务中读取时，调用者需保证与 EnergyAccFeed 互斥 */
+void EnergyAccSnapshot(const EnergyAcc *acc, EnergySnapshot *out)
+{
+    *out = acc->tot;
+}
+
+/* 1 mAh = 3.6e6 μA·s */
+float EnergyAccMilliAmpHours(const EnergySnapshot *snap)
+{
+    return (float)((double)snap->uas / 3.6e6);
+}
+
+/* 1 Wh = 3.6e9 μW·s */
+float EnergyAccWattHours(const EnergySnapshot *snap)
+{
+    return (float)((double)snap->uws / 3.6e9);
+}
+
 
-    // 累加能量
-    total_wh += power_w * delta_h;
+/* ------------------------------------------------------------------
+  采样环消费者
+  采样任务经 INA226_MgrSetSink(&mgr, INA226_RingSink, &ring) 把每个读数写入采样环，
+  本消费者在自己的任务/主循环中按块取出某一设备的读数，做能量累计与电流统计；
+  取得慢了只会丢样本（计入 overrun），不会拖慢采样
+   ------------------------------------------------------------------ */
+#define MEASURE_DRAIN_BLOCK  16
+
+/**
+ * @brief 注册为采样环的一个消费者，从环中当前最新位置开始
+ * @return 0 成功；-1 环的消费者已满
+ */
+int MeasureConsumerInit(MeasureConsumer *mc, INA226_Ring *ring, uint8_t dev)
+{
+    memset(mc, 0, sizeof(*mc));
+    mc->ring = ring;
+    mc->dev  = dev;
+    EnergyAccInit(&mc->energy);
+    StatsInitDefault(&mc->current);
+    mc->id = INA226_RingAddConsumer(ring);
+    return mc->id < 0 ? -1 : 0;
+}
 
-    return total_wh;
+/* 取出全部待读样本；返回处理的（属于该设备的）样本数 */
+uint32_t MeasureConsumerDrain(MeasureConsumer *mc)
+{
+    INA226_RingItem blk[MEASURE_DRAIN_BLOCK];
+    uint32_t n, done = 0;
+
+    while ((n = INA226_RingRead(mc->ring, mc->id, blk, MEASURE_DRAIN_BLOCK)) > 0) {
+        for (uint32_t i = 0; i < n; i++) {
+            const INA226_Snapshot *s = &blk[i].snap;
+            if (blk[i].dev != mc->dev) continue;
+            EnergyAccFeed(&mc->energy, s->t_us, s->current_ua, s->power_uw);
+            StatsUpdate(&mc->current, s->t_us, s->current_a);
+            done++;
+        }
+    }
+    mc->overrun = INA226_RingOverrun(mc->ring, mc->id);
+    return done;
 }
 
 
@@ -475,442 +2094,410 @@ float Voltage_To_Temperature(float voltage)
 }
 #endif
 
+
 /* ------------------------------------------------------------------
-  多按钮逻辑判断
+  NTC 查表
+  表项为 ADC 码 k·2^shift 处的温度（0.01 °C），码值落在两表项之间时线性插值。
+  两端点（分压比 0 或 1）换算无意义，按半个码处的温度代替。
    ------------------------------------------------------------------ */
-//void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
-//{
-//    uint8_t idx;
-//    switch(GPIO_Pin)
-//    {
-//        case SW_WKUP_Pin: idx = 0; break;
-//        case SW_FUNC_Pin: idx = 1; break;
-//        default: return;
-//    }
+static NtcChannel ntc_ch[NTC_MAX_CHANNELS];
 
-//    btn_last_irq[idx] = sys;
-//}
-
-void HAL_GPIO_EXTI_Rising_Callback(uint16_t GPIO_Pin)
+/**
+ * @brief 按热敏电阻模型直接计算温度（生成查表与基准测试用）
+ * @param ratio ADC 读数 / 满量程，(0, 1)
+ * @return 温度 °C，分压比无效时返回 -273.15
+ */
+float NtcModelTemperature(const NtcParams *p, float ratio)
 {
-    uint8_t idx;
-    switch(GPIO_Pin)
-    {
-        case SW_WKUP_Pin: idx = 0; break;
-        case SW_FUNC_Pin: idx = 1; break;
-        default: return;
+    if (ratio <= 0.0f || ratio >= 1.0f) return -273.15f;
+
+    float r = (p->scheme == 2) ? p->r_fixed * (1.0f - ratio) / ratio
+                               : p->r_fixed * ratio / (1.0f - ratio);
+    float inv_T;
+    if (p->model == NTC_MODEL_SH) {
+        float l = logf(r);
+        inv_T = p->sh_a + p->sh_b * l + p->sh_c * l * l * l;
+    } else {
+        inv_T = 1.0f / (p->t0_c + 273.15f) + logf(r / p->r0) / p->beta;
     }
-
-    btn_last_irq[idx] = sys;
+    return 1.0f / inv_T - 273.15f;
 }
 
-void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin)
+static int16_t NtcClampCenti(float t)
 {
-    uint8_t idx;
-    switch(GPIO_Pin)
-    {
-        case SW_WKUP_Pin: idx = 0; break;
-        case SW_FUNC_Pin: idx = 1; break;
-        default: return;
-    }
-
-    btn_last_irq[idx] = sys;
+    t *= 100.0f;
+    if (t >  32767.0f) return  32767;
+    if (t < -32768.0f) return -32768;
+    return (int16_t)lroundf(t);
 }
 
-
-
-#define DEBOUNCE_TIME 10
-volatile uint64_t btn_press_start[MAX_KEYS] = {0};
-volatile uint64_t btn_press_duration[MAX_KEYS] = {0};
-volatile uint8_t btn_flag[MAX_KEYS] = {0};
-
-// 在主循环或定时器中周期性调用此函数
-void Debounce_Process(void)
+/**
+ * @brief 配置一路热敏电阻并生成查表（开机或参数变化时调用）
+ * @return 0 成功，-1 通道或参数无效
+ */
+int NtcConfigure(uint8_t ch, const NtcParams *p)
 {
-		static volatile uint8_t  btn_stable_state[MAX_KEYS] = {0};
-		
-    for (uint8_t i = 0; i < MAX_KEYS; i++) {
-        if (btn_last_irq[i] == 0) continue;  // 没有触发
-
-        if ((sys - btn_last_irq[i]) >= DEBOUNCE_TIME) {
-            // 已经过了消抖时间，读取稳定电平
-            uint8_t cur_level;
-            if (i == 0) cur_level = (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_0) == GPIO_PIN_SET) ? 1 : 0;
-            else if (i == 1) cur_level = (HAL_GPIO_ReadPin(GPIOC, GPIO_PIN_15) == GPIO_PIN_SET) ? 1 : 0;
-
-            // 状态变化才更新对外变量
-            if (cur_level != btn_stable_state[i]) {
-                if (cur_level == 1) {
-                    // 按下
-                    btn_press_start[i] = sys;
-                    btn_flag[i] = 1;
-                } else {
-                    // 松开
-                    btn_press_duration[i] = sys - btn_press_start[i];
-                    btn_flag[i] = 0;
-                }
-                btn_stable_state[i] = cur_level;
-            }
-
-            // 清零触发时间，避免重复处理
-            btn_last_irq[i] = 0;
-        }
+    if (ch >= NTC_MAX_CHANNELS || p->adc_bits < NTC_LUT_BITS || p->adc_bits > 16) return -1;
+
+    NtcChannel *c = &ntc_ch[ch];
+    c->ready = 0;
+    c->p     = *p;
+    c->shift = (uint8_t)(p->adc_bits - NTC_LUT_BITS);
+
+    float full = (float)(1UL << p->adc_bits);
+    for (uint32_t k = 0; k <= (1UL << NTC_LUT_BITS); k++) {
+        float code = (float)(k << c->shift);
+        if (code < 0.5f)        code = 0.5f;
+        if (code > full - 0.5f) code = full - 0.5f;
+        c->lut[k] = NtcClampCenti(NtcModelTemperature(p, code / full));
     }
+    c->ready = 1;
+    return 0;
 }
 
+/* @return 温度（0.01 °C），通道未配置返回 INT16_MIN */
+int16_t NtcTemperatureCenti(uint8_t ch, uint16_t code)
+{
+    if (ch >= NTC_MAX_CHANNELS || !ntc_ch[ch].ready) return INT16_MIN;
 
-/*
-按钮逻辑中：
-	访问一次就会更新一次按钮状态
-	会读取全局变量：按钮是否按下，按钮按下时间，系统时间
-	一旦松开或者超时，就会返回对应值 并 上锁，无法再次触发
+    const NtcChannel *c = &ntc_ch[ch];
+    uint32_t idx  = (uint32_t)code >> c->shift;
+    uint32_t frac = (uint32_t)code & ((1UL << c->shift) - 1);
+    if (idx >= (1UL << NTC_LUT_BITS)) return c->lut[1 << NTC_LUT_BITS];
 
+    int32_t t0 = c->lut[idx];
+    int32_t t1 = c->lut[idx + 1];
+    return (int16_t)(t0 + (((t1 - t0) * (int32_t)frac) >> c->shift));
+}
 
-注意：调用该函数后应当立即调用判断函数，它仅会返回一次变化值，之后返回空值
+float NtcTemperature(uint8_t ch, uint16_t code)
+{
+    int16_t t = NtcTemperatureCenti(ch, code);
+    return (t == INT16_MIN) ? -273.15f : (float)t * 0.01f;
+}
 
-*/
 
+/* ------------------------------------------------------------------
+  基准测试：浮点 vs 整数测量链路
+  同一组原始寄存器值分别走 换算 → 滑动均值 → 卡尔曼 → 能量累计，
+  比较两条链路每批样本的总耗时。计时源可用 BENCH_TIME_US 替换。
+   ------------------------------------------------------------------ */
+#ifdef FUNCTION_BENCH
+#include "INA226.h"
 
+#ifndef BENCH_TIME_US
+#define BENCH_TIME_US()   INA226_TIMESTAMP_US()
+#endif
 
-#define LONG_PRESS_THRESHOLD   1000   // 长按阈值，单位 ms
-#define DOUBLE_CLICK_THRESHOLD 350   // 双击最大间隔，单位 ms
-
-// 返回值定义
-#define BTN_NONE   0
-#define BTN_LONG   1
-#define BTN_SHORT  2
-#define BTN_DOUBLE 3
-
-//每次只能触发一次长按
-
-//不带双击版本
-//uint8_t btnLogic(uint8_t num)
-//{
-//    // 参数检查（假设最多3个按钮）
-//    if (num >= MAX_KEYS) return BTN_NONE;
-
-//    // 静态保存上次返回值和锁
-//    static uint8_t lastValue[MAX_KEYS] = {BTN_NONE};
-
-
-//    // 读取共享变量到本地，减少并发问题
-//		__disable_irq();
-//    uint8_t  btEN 			= 	btn_flag[num]; 
-//		uint64_t sys_inline = 	sys; 
-//		uint64_t btn_start 	= 	btn_press_start[num]; 
-//		uint64_t duration 	=  	sys_inline - btn_start;
-//		__enable_irq();
-//		
-
-//    // 如果已经触发过，返回
-//    if (lock[num]) {
-//			return BTN_NONE;
-//    }
-
-//    // 1) 长按判定：按下且超过阈值 -> 立即触发长按并加锁
-//    if (btEN && duration >= LONG_PRESS_THRESHOLD && !longFlag[num]) {
-//      lock[num] = 1;
-//      lastValue[num] = BTN_LONG;
-//			longFlag[num] = 1;//松开前不允许再次触发
-//      return lastValue[num];
-//    }
-
-//    // 2) 短按判定：按键已松开且有记录的按下时长
-//    //    这里 btn_press_duration[num] 在按键松开时被中断设置为实际时长（非0）
-//    if (!btEN && btn_press_duration[num] > 0) {
-//        // 如果持续时间小于长按阈值，判定为短按
-//        if ((uint64_t)btn_press_duration[num] < LONG_PRESS_THRESHOLD) {
-//            lock[num] = 1;
-//            lastValue[num] = BTN_SHORT;
-//            // 清除持续时间，避免重复判定
-//            btn_press_duration[num] = 0;
-//            return lastValue[num];
-//        } else {
-////            lock[num] = 1;
-////            lastValue[num] = BTN_LONG;
-////            return lastValue[num];
-//					//长按按钮松开
-//					btn_press_duration[num] = 0;
-//					longFlag[num] = 0;
-//					return BTN_NONE;
-//        }
-//    }
-
-//    // 3) 无事件，返回 NONE（不更新 lastValue）
-//    return BTN_NONE;
-//}
-
-
-
-
-//带双击版本
-#define LONG_PRESS_THRESHOLD   1000   // 长按阈值，单位 ms
-#define DOUBLE_CLICK_THRESHOLD 350   // 双击最大间隔，单位 ms
-
-// 返回值定义
-#define BTN_NONE   0
-#define BTN_LONG   1
-#define BTN_SHORT  2
-#define BTN_DOUBLE 3
-
-uint8_t btnLogic(uint8_t num)
-{
-    if (num >= MAX_KEYS) return BTN_NONE;
-
-    static uint8_t lastValue[MAX_KEYS] = {BTN_NONE};
-    static uint8_t pendingShort[MAX_KEYS] = {0};
-    static uint64_t lastReleaseTime[MAX_KEYS] = {0};
-
-    __disable_irq();
-    uint8_t  btEN        = btn_flag[num]; 
-    uint64_t sys_inline  = sys; 
-    uint64_t btn_start   = btn_press_start[num]; 
-    uint64_t duration    = sys_inline - btn_start;
-    __enable_irq();
-
-    if (lock[num]) {
-        return BTN_NONE;
-    }
-
-    // 1) 长按判定
-    if (btEN && duration >= LONG_PRESS_THRESHOLD && !longFlag[num]) {
-        lock[num] = 1;
-        lastValue[num] = BTN_LONG;
-        longFlag[num] = 1;
-        return lastValue[num];
-    }
-
-    // 2) 短按/双击判定
-    if (!btEN && btn_press_duration[num] > 0) {
-        if ((uint64_t)btn_press_duration[num] < LONG_PRESS_THRESHOLD) {
-            uint64_t now = sys_inline;
-            if (pendingShort[num] && (now - lastReleaseTime[num] <= DOUBLE_CLICK_THRESHOLD)) {
-                // 第二次短按在阈值内 -> 双击
-                pendingShort[num] = 0;
-                lock[num] = 1;
-                lastValue[num] = BTN_DOUBLE;
-                btn_press_duration[num] = 0;
-                return lastValue[num];
-            } else {
-                // 第一次短按，先挂起
-                pendingShort[num] = 1;
-                lastReleaseTime[num] = now;
-                btn_press_duration[num] = 0;
-                return BTN_NONE; // 暂时不返回，等待第二次
-            }
-        } else {
-            // 长按松开
-            btn_press_duration[num] = 0;
-            longFlag[num] = 0;
-            return BTN_NONE;
-        }
+void PipelineBench(uint32_t samples, PipelineBenchResult *res)
+{
+    MovingAverageFilter    ma_f;
+    MovingAverageFilterI32 ma_i;
+    KalmanFilter           kf_f;
+    KalmanFilterI32        kf_i;
+    INA226_Dev             dev;
+    INA226_Snapshot        snap;
+    volatile float   sink_f = 0.0f;
+    volatile int64_t sink_i = 0;
+    uint32_t lfsr = 0xACE1u;
+    uint64_t t0;
+
+    memset(&dev, 0, sizeof(dev));
+    memset(&snap, 0, sizeof(snap));
+    dev.cal            = INA226_CALIBRATION_VALUE;
+    dev.current_lsb    = 0.00512f / (INA226_CALIBRATION_VALUE * 0.01f);
+    dev.power_lsb      = dev.current_lsb * 25.0f;
+    dev.current_lsb_pa = 500000;   // 0.5 mA（CAL=1024，R=10mΩ）
+
+    /* 浮点链路 */
+    MovingAverageInit(&ma_f);
+    KalmanInit(&kf_f, 0.0f, 1.0f);
+    float wh = 0.0f;
+    t0 = BENCH_TIME_US();
+    for (uint32_t i = 0; i < samples; i++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        snap.current_raw = (int16_t)(4000 + (lfsr & 0xFF));
+        snap.bus_raw     = (uint16_t)(9600 + (lfsr & 0x3F));
+        snap.power_raw   = (uint16_t)(1900 + (lfsr & 0x7F));
+        INA226_SnapshotToFloat(&dev, &snap);
+        float a = MovingAverageUpdate(&ma_f, snap.current_a);
+        a = KalmanUpdate(&kf_f, a, 0.001f, 0.1f);
+        wh += snap.power_w * (1.0f / 3600000.0f);          // 1 ms/样本
+        sink_f = a + wh;
     }
-
-    // 3) 检查挂起的短按是否超时
-    if (pendingShort[num] && (sys_inline - lastReleaseTime[num] > DOUBLE_CLICK_THRESHOLD)) {
-        pendingShort[num] = 0;
-        lock[num] = 1;
-        lastValue[num] = BTN_SHORT;
-        return lastValue[num];
+    res->float_us = (uint32_t)(BENCH_TIME_US() - t0);
+
+    /* 整数链路 */
+    lfsr = 0xACE1u;
+    MovingAverageInitI32(&ma_i);
+    KalmanInitI32(&kf_i, 0, 1);
+    int64_t uwms = 0;
+    t0 = BENCH_TIME_US();
+    for (uint32_t i = 0; i < samples; i++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        snap.current_raw = (int16_t)(4000 + (lfsr & 0xFF));
+        snap.bus_raw     = (uint16_t)(9600 + (lfsr & 0x3F));
+        snap.power_raw   = (uint16_t)(1900 + (lfsr & 0x7F));
+        INA226_SnapshotToInt(&dev, &snap);
+        int32_t a = MovingAverageUpdateI32(&ma_i, snap.current_ua);
+        a = KalmanUpdateI32(&kf_i, a, 1000, 100000);
+        uwms += snap.power_uw;                               // 1 ms/样本
+        sink_i = a + uwms / 3600000;
     }
+    res->int_us = (uint32_t)(BENCH_TIME_US() - t0);
 
-    return BTN_NONE;
+    res->samples = samples;
+    (void)sink_f;
+    (void)sink_i;
 }
 
-
-//可触发多次长按,外部锁定
-uint8_t btnLogic_withExtLongFlag(uint8_t num)
+/* 逐样本调用 vs 块处理：滑动均值 + 卡尔曼串联，每块 block_len 个样本（≤ 256） */
+void FilterBlockBench(uint32_t blocks, uint16_t block_len, FilterBlockBenchResult *res)
 {
-    if (num >= MAX_KEYS) return BTN_NONE;
+    static float in[256], out_s[256], out_b[256];
+    MovingAverageFilter ma_s, ma_b;
+    KalmanFilter        kf_s, kf_b;
+    uint32_t lfsr = 0xACE1u;
+    uint64_t t_scalar = 0, t_block = 0, t0;
+    float    max_diff = 0.0f;
+
+    if (block_len > 256) block_len = 256;
+    MovingAverageInit(&ma_s);
+    MovingAverageInit(&ma_b);
+    KalmanInit(&kf_s, 0.0f, 1.0f);
+    KalmanInit(&kf_b, 0.0f, 1.0f);
+
+    for (uint32_t b = 0; b < blocks; b++) {
+        for (uint16_t i = 0; i < block_len; i++) {
+            lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+            in[i] = 2.0f + (float)(lfsr & 0x3FF) * 1e-4f;
+        }
 
-    static uint8_t lastValue[MAX_KEYS] = {BTN_NONE};
-    static uint8_t pendingShort[MAX_KEYS] = {0};
-    static uint64_t lastReleaseTime[MAX_KEYS] = {0};
+        t0 = BENCH_TIME_US();
+        for (uint16_t i = 0; i < block_len; i++) {
+            out_s[i] = KalmanUpdate(&kf_s, MovingAverageUpdate(&ma_s, in[i]), 0.001f, 0.1f);
+        }
+        t_scalar += BENCH_TIME_US() - t0;
 
-    __disable_irq();
-    uint8_t  btEN        = btn_flag[num]; 
-    uint64_t sys_inline  = sys; 
-    uint64_t btn_start   = btn_press_start[num]; 
-    uint64_t duration    = sys_inline - btn_start;
-    __enable_irq();
+        t0 = BENCH_TIME_US();
+        MovingAverageProcessBlock(&ma_b, in, out_b, block_len);
+        KalmanProcessBlock(&kf_b, out_b, out_b, block_len, 0.001f, 0.1f);
+        t_block += BENCH_TIME_US() - t0;
 
-    if (lock[num]) {
-        return BTN_NONE;
+        for (uint16_t i = 0; i < block_len; i++) {
+            float d = fabsf(out_s[i] - out_b[i]);
+            if (d > max_diff) max_diff = d;
+        }
     }
 
-    // 1) 长按判定
-    if (btEN && duration >= LONG_PRESS_THRESHOLD && !longFlag[num]) {
-        lock[num] = 1;
-        lastValue[num] = BTN_LONG;
-//        longFlag[num] = 1;
-        return lastValue[num];
+    res->blocks    = blocks;
+    res->block_len = block_len;
+    res->scalar_us = (uint32_t)t_scalar;
+    res->block_us  = (uint32_t)t_block;
+    res->max_diff  = max_diff;
+}
+
+/* NTC：logf 模型 vs 查表，遍历 12 位 ADC 码（占用通道 0 的查表） */
+void NtcBench(uint32_t samples, NtcBenchResult *res)
+{
+    const NtcParams p = {
+        .model = NTC_MODEL_BETA, .scheme = 1, .adc_bits = 12,
+        .r_fixed = 10000.0f, .r0 = 10000.0f, .t0_c = 25.0f, .beta = 3950.0f,
+    };
+    volatile float   sink_f = 0.0f;
+    volatile int32_t sink_i = 0;
+    uint64_t t0;
+    float    max_err = 0.0f;
+
+    NtcConfigure(0, &p);
+
+    t0 = BENCH_TIME_US();
+    for (uint32_t i = 0; i < samples; i++) {
+        uint16_t code = (uint16_t)(200 + (i * 7) % 3700);
+        sink_f = NtcModelTemperature(&p, (float)code / 4096.0f);
     }
+    res->logf_us = (uint32_t)(BENCH_TIME_US() - t0);
 
-    // 2) 短按/双击判定
-    if (!btEN && btn_press_duration[num] > 0) {
-        if ((uint64_t)btn_press_duration[num] < LONG_PRESS_THRESHOLD) {
-            uint64_t now = sys_inline;
-            if (pendingShort[num] && (now - lastReleaseTime[num] <= DOUBLE_CLICK_THRESHOLD)) {
-                // 第二次短按在阈值内 -> 双击
-                pendingShort[num] = 0;
-                lock[num] = 1;
-                lastValue[num] = BTN_DOUBLE;
-                btn_press_duration[num] = 0;
-                return lastValue[num];
-            } else {
-                // 第一次短按，先挂起
-                pendingShort[num] = 1;
-                lastReleaseTime[num] = now;
-                btn_press_duration[num] = 0;
-                return BTN_NONE; // 暂时不返回，等待第二次
-            }
-        } else {
-            // 长按松开
-            btn_press_duration[num] = 0;
-            longFlag[num] = 0;
-            return BTN_NONE;
-        }
+    t0 = BENCH_TIME_US();
+    for (uint32_t i = 0; i < samples; i++) {
+        uint16_t code = (uint16_t)(200 + (i * 7) % 3700);
+        sink_i = NtcTemperatureCenti(0, code);
     }
+    res->lut_us = (uint32_t)(BENCH_TIME_US() - t0);
 
-    // 3) 检查挂起的短按是否超时
-    if (pendingShort[num] && (sys_inline - lastReleaseTime[num] > DOUBLE_CLICK_THRESHOLD)) {
-        pendingShort[num] = 0;
-        lock[num] = 1;
-        lastValue[num] = BTN_SHORT;
-        return lastValue[num];
+    for (uint16_t code = 200; code < 3900; code++) {
+        float e = fabsf(NtcTemperature(0, code) - NtcModelTemperature(&p, (float)code / 4096.0f));
+        if (e > max_err) max_err = e;
     }
 
-    return BTN_NONE;
+    res->samples   = samples;
+    res->max_err_c = max_err;
+    (void)sink_f;
+    (void)sink_i;
 }
 
+/* 旧实现（对照用）：整数部分 snprintf，小数逐位乘 10 截断 */
+static void formatFloatToStrLegacy(float value, char *out, int width, int prec)
+{
+    if (out == NULL || width <= 0) return;
 
+    /* NaN 或 Inf 处理 */
+    if (!isfinite(value)) {
+        memset(out, 'x', width);
+        out[width] = '\0';
+        return;
+    }
 
+    /* 处理符号与绝对值 */
+    int negative = signbit(value) ? 1 : 0;
+    float absval = negative ? -value : value;
 
+    /* 取整数部分（截断） */
+    char intbuf[64];
+    long long intpart = (long long)absval; /* 截断 */
+    snprintf(intbuf, sizeof(intbuf), "%lld", (long long)intpart);
+    int intlen = (int)strlen(intbuf);
 
+    int sign_len = negative ? 1 : 0;
 
+    /* 如果整数部分（含符号）已超出宽度，则无法显示 */
+    if (sign_len + intlen > width) {
+        memset(out, 'x', width);
+        out[width] = '\0';
+        return;
+    }
 
+    /* 计算最多能放的小数位数（不超过用户给定的 prec） */
+    int max_frac = 0;
+    if (prec > 0) {
+        int avail = width - (sign_len + intlen + 1); /* 预留小数点 */
+        if (avail > 0) max_frac = avail;
+        else max_frac = 0;
+        if (max_frac > prec) max_frac = prec;
+    } else {
+        max_frac = 0;
+    }
 
+    /* 计算实际需要的字符数（含小数点和小数位，如果有） */
+    int needed = sign_len + intlen + (max_frac > 0 ? (1 + max_frac) : 0);
 
+    /* 只要宽度大于需要的字符数，就在整数左侧（符号之后）填充 '0' */
+    int pad_zeros = 0;
+    if (width > needed) {
+        pad_zeros = width - needed;
+    }
 
+    /* 构造输出：符号 -> 填充0（若有） -> 整数部分 -> 小数点 -> 小数部分 */
+    char tmp[128];
+    int pos = 0;
 
+    if (negative) {
+        tmp[pos++] = '-';
+    }
 
+    for (int i = 0; i < pad_zeros; ++i) {
+        tmp[pos++] = '0';
+    }
 
-/* ------------------------------------------------------------------
-  关机相关程序
-   ------------------------------------------------------------------ */
-
-////适用Cortex_M3
-//void Enter_StandbyMode(void)
-//{
-//    /**
-//     * @brief  进入 Standby 模式，PA0 上升沿唤醒
-//     */
-
-//    /* 1. 使能 PWR 外设时钟 */
-//    __HAL_RCC_PWR_CLK_ENABLE();
-
-//    /* 2. 清除 Wake-Up 标志，确保下次能正确唤醒 */
-//    __HAL_PWR_CLEAR_FLAG(PWR_FLAG_WUF);
-////	  __HAL_PWR_CLEAR_FLAG(PWR_FLAG_WU);
-
-//    /* 3. 使能 WKUP 引脚（PA0） */
-//    HAL_PWR_EnableWakeUpPin(PWR_WAKEUP_PIN1);
-
-//    /* 4. 设置 Cortex-M3 进入深度睡眠 */
-//    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
-
-//    /* 5. 进入 Standby 模式，不会返回，除非由 PA0 唤醒 */
-//    HAL_PWR_EnterSTANDBYMode();
-//}
-
-//void GPIO_To_AnalogInput(void)
-//{
-//    GPIO_InitTypeDef GPIO_InitStruct = {0};
-
-//    __HAL_RCC_GPIOA_CLK_ENABLE();
-//    __HAL_RCC_GPIOB_CLK_ENABLE();
-//    __HAL_RCC_GPIOC_CLK_ENABLE();
-//    __HAL_RCC_GPIOD_CLK_ENABLE();
-
-//    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
-//    GPIO_InitStruct.Pull = GPIO_NOPULL;
-
-//    // A 端口
-//    GPIO_InitStruct.Pin = GPIO_PIN_All & (~GPIO_PIN_0);
-//    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
-
-//    // B 端口
-//    GPIO_InitStruct.Pin = GPIO_PIN_All;
-//    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
-
-//    // C 端口
-//    GPIO_InitStruct.Pin = GPIO_PIN_All;
-//    HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
-
-//    // D 端口（如果有）
-//    GPIO_InitStruct.Pin = GPIO_PIN_All;
-//    HAL_GPIO_Init(GPIOD, &GPIO_InitStruct);
-//}
-
-
-
-
-//适用Cortex_M0+
-void Enter_StandbyMode(void)
-{
-    /**
-     * @brief  进入 Standby 模式，PA0 上升沿唤醒
-     */
-
-    /* 1. 使能 PWR 外设时钟 */
-    __HAL_RCC_PWR_CLK_ENABLE();
-
-    /* 2. 清除 Wake-Up 标志，确保下次能正确唤醒 */
-    __HAL_PWR_CLEAR_FLAG(PWR_FLAG_WUF);
+    memcpy(tmp + pos, intbuf, intlen);
+    pos += intlen;
 
-    /* 3. 使能 WKUP 引脚（PA0） */
-    HAL_PWR_EnableWakeUpPin(PWR_WAKEUP_PIN1);
+    if (max_frac > 0) {
+        tmp[pos++] = '.';
+        float frac = absval - (float)intpart;
+        if (frac < 0.0f) frac = 0.0f;
+        for (int i = 0; i < max_frac; ++i) {
+            frac *= 10.0f;
+            int digit = (int)frac;
+            if (digit < 0) digit = 0;
+            if (digit > 9) digit = 9;
+            tmp[pos++] = (char)('0' + digit);
+            frac -= (float)digit;
+        }
+    }
 
-    /* 4. 设置 Cortex-M0+ 进入深度睡眠 */
-    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    int outlen = pos;
+    if (outlen > width) {
+        memset(out, '.', width);
+        out[width] = '\0';
+        return;
+    }
 
-    /* 5. 进入 Standby 模式，不会返回，除非由 PA0 唤醒 */
-    HAL_PWR_EnterSTANDBYMode();
+    memcpy(out, tmp, outlen);
+    out[outlen] = '\0';
 }
-void GPIO_To_AnalogInput(void)
+
+/* 数字格式化：旧实现 / snprintf / formatFloatToStr / FormatFixed，宽度 7、2 位小数 */
+void FormatBench(uint32_t samples, FormatBenchResult *res)
 {
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    char buf[16], ref[16];
+    uint32_t lfsr = 0xACE1u;
+    uint64_t t0;
+
+    res->mismatches = 0;
+    for (uint32_t i = 0; i < samples; i++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        float v = (float)(int32_t)(lfsr - 0x8000u) * 0.00137f;
+        formatFloatToStr(v, buf, 7, 2);
+        snprintf(ref, sizeof(ref), "%07.2f", v);
+        if (strcmp(buf, ref) != 0) res->mismatches++;
+    }
 
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-    __HAL_RCC_GPIOB_CLK_ENABLE();
-    __HAL_RCC_GPIOC_CLK_ENABLE();
-    // G030 没有 GPIOD，去掉
+    lfsr = 0xACE1u;
+    t0 = BENCH_TIME_US();
+    for (uint32_t i = 0; i < samples; i++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        formatFloatToStrLegacy((float)(int32_t)(lfsr - 0x8000u) * 0.00137f, buf, 7, 2);
+    }
+    res->legacy_us = (uint32_t)(BENCH_TIME_US() - t0);
 
-    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    lfsr = 0xACE1u;
+    t0 = BENCH_TIME_US();
+    for (uint32_t i = 0; i < samples; i++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        snprintf(buf, sizeof(buf), "%07.2f", (float)(int32_t)(lfsr - 0x8000u) * 0.00137f);
+    }
+    res->snprintf_us = (uint32_t)(BENCH_TIME_US() - t0);
 
-    // A 端口，保留 PA0 作为 WKUP 引脚
-    GPIO_InitStruct.Pin = GPIO_PIN_All & (~GPIO_PIN_0);
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+    lfsr = 0xACE1u;
+    t0 = BENCH_TIME_US();
+    for (uint32_t i = 0; i < samples; i++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        formatFloatToStr((float)(int32_t)(lfsr - 0x8000u) * 0.00137f, buf, 7, 2);
+    }
+    res->float_us = (uint32_t)(BENCH_TIME_US() - t0);
 
-    // B 端口
-    GPIO_InitStruct.Pin = GPIO_PIN_All;
-    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+    lfsr = 0xACE1u;
+    t0 = BENCH_TIME_US();
+    for (uint32_t i = 0; i < samples; i++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        FormatFixed(buf, (int64_t)(int32_t)(lfsr - 0x8000u) * 1370, 6, 7, 2);
+    }
+    res->fixed_us = (uint32_t)(BENCH_TIME_US() - t0);
 
-    // C 端口
-    GPIO_InitStruct.Pin = GPIO_PIN_All;
-    HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+    res->samples = samples;
 }
 
-void power_off(void)
+/* 自复位起统计的长时间回归：per_phase 个 1.0±0.01 后接 per_phase 个 2.0，
+   per_phase 超过 2^24 时 float Welford 的均值会停在 1.0 附近 */
+void StatsLongRunCheck(uint32_t per_phase, StatsLongRunResult *res)
 {
-	LCD_Clear(BLACK);LCD_BLK(100);
-	LCD_ShowString_24_12(100,65,RED,BLACK,"POWEROFF");
-	// 假设主频 72MHz，大约 6400000 次循环 ≈ 1 秒
-  for (volatile uint32_t i = 0; i < 6400000; i++) {__NOP();}
-	LCD_BLK(0);
-	LCD_Clear(BLACK);
-	GPIO_To_AnalogInput();
-	Enter_StandbyMode();
-}
+    static StatsChannel st;
+    StatsResult r;
+    uint32_t lfsr = 0xACE1u;
+
+    StatsInit(&st);
+    for (uint32_t i = 0; i < per_phase; i++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        StatsUpdate(&st, i, 1.0f + ((lfsr & 1u) ? 0.01f : -0.01f));
+    }
+    for (uint32_t i = 0; i < per_phase; i++) {
+        StatsUpdate(&st, (uint64_t)per_phase + i, 2.0f);
+    }
+    StatsTotal(&st, &r);
 
+    res->per_phase = per_phase;
+    res->mean      = r.mean;
+    res->stddev    = r.stddev;
+}
+#endif
@@ -15,7 +15,7 @@
  *   - 系统控制：电源关闭
  *
  * @note
- *   - 本头文件仅声明接口，具体实现见 function.c
+ *   - 本头文件仅声明接口，具体实现见 function.c（纯计算）与 function_hal.c（板级）
  *   - 所有函数均为通用工具函数，可在不同模块中复用
  ******************************************************************************/
 
@@ -29,16 +29,34 @@
 #include "string.h"
 #include "stdio.h"
 #include "stdint.h"
+#include "INA226_ring.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
-/* 格式转换 */
+/* 格式转换：out 至少 width + 1 字节，输出恰好 width 个字符（符号后补 0），
+   小数位放不下时自动减少，整数部分放不下时填 'x'；四舍五入，可重入 */
 void formatFloatToStr(float value, char *out, int width, int prec);
+int  FormatFixed(char *out, int64_t value, uint8_t scale, int width, int prec);
 char* FormatTimeString(uint64_t msTicks);
 
+/* 运行时间：≤ 99 小时为 "HH:MM:SS"，之后为 "DdHHhMMm"；_r 版本写入调用者缓冲，可重入 */
+#define FORMAT_TIME_LEN  16
+char* FormatTimeString_r(uint64_t msTicks, char *buf, size_t len);
+
+/* 增量运行时钟：每秒只改动变化的数字字符，配合 slot_diff 每秒通常只重绘一个字形 */
+typedef struct {
+    char     text[FORMAT_TIME_LEN];
+    uint64_t next_ms;                   // 下一次秒进位的时刻
+    uint32_t total_sec;
+    uint8_t  changed;                   // 自上次渲染以来改动的字符数
+} UptimeClock;
+void UptimeClockInit(UptimeClock *c, uint64_t now_ms);
+int  UptimeClockUpdate(UptimeClock *c, uint64_t now_ms);
+int  UptimeClockRender(UptimeClock *c, uint16_t slot, char *out);
+
 
 /* 滤波器 */
 #define WINDOW_SIZE 20
@@ -49,7 +67,29 @@ typedef struct {
     uint8_t count;              // 已填充数量
 } MovingAverageFilter;
 void MovingAverageInit(MovingAverageFilter *f);
+
+/* 多通道滑动均值：按通道号登记，窗口可分别设置，内部用整数累加，长时间运行无累加漂移
+   静态占用 ≈ MA_MAX_CHANNELS × (MA_MAX_WINDOW × 4 + 24) 字节，默认约 0.6 KB */
+#ifndef MA_MAX_CHANNELS
+#define MA_MAX_CHANNELS  4
+#endif
+#ifndef MA_MAX_WINDOW
+#define MA_MAX_WINDOW    32
+#endif
+typedef struct {
+    int32_t  buffer[MA_MAX_WINDOW];  // 定点样本 = round(value / resolution)
+    int64_t  sum;
+    float    scale;                  // 1 / resolution
+    float    resolution;
+    uint16_t window;
+    uint16_t write_idx;
+    uint16_t count;
+} MovingAverageChannel;
+int   MovingAverageConfig(uint8_t ch, uint16_t window, float resolution);
+void  MovingAverageReset(uint8_t ch);
 float MovingAverage(uint8_t ch, float value);
+float MovingAverageBatch(uint8_t ch, const float *values, uint16_t n);
+int32_t MovingAverageI32(uint8_t ch, int32_t value);
 
 
 typedef struct {
@@ -60,25 +100,388 @@ typedef struct {
 void KalmanInit(KalmanFilter *kf, float init_x, float init_p);
 float KalmanUpdate(KalmanFilter *kf, float value, float Q, float R);
 
+/* 块处理：一次处理 n 个样本，滤波器状态在整块内保存在局部变量中；out 可与 in 相同 */
+void MovingAverageProcessBlock(MovingAverageFilter *f, const float *in, float *out, uint16_t n);
+void KalmanProcessBlock(KalmanFilter *kf, const float *in, float *out, uint16_t n, float Q, float R);
+
+
+/* 整数滤波器：输入 μV / μA / μW 等整数量，无 FPU 平台使用 */
+typedef struct {
+    int32_t buffer[WINDOW_SIZE];
+    int64_t sum;
+    uint8_t write_idx;
+    uint8_t count;
+} MovingAverageFilterI32;
+void MovingAverageInitI32(MovingAverageFilterI32 *f);
+int32_t MovingAverageUpdateI32(MovingAverageFilterI32 *f, int32_t value);
+
+#define KALMAN_Q16_ONE  65536
+typedef struct {
+    int32_t x_est;       // 当前估计值（与输入同单位）
+    int64_t p_est;       // 当前协方差（单位^2）
+    uint8_t initialized;
+} KalmanFilterI32;
+void KalmanInitI32(KalmanFilterI32 *kf, int32_t init_x, int64_t init_p);
+int32_t KalmanUpdateI32(KalmanFilterI32 *kf, int32_t value, int64_t Q, int64_t R);
+void MovingAverageProcessBlockI32(MovingAverageFilterI32 *f, const int32_t *in, int32_t *out, uint16_t n);
+
+
+/* 滑动中值（双堆，每次更新 O(log N)）与 Hampel 离群点剔除 */
+#define SMEDIAN_MAX_WINDOW  63
+typedef struct {
+    float   val[SMEDIAN_MAX_WINDOW];   // 环形样本
+    uint8_t side[SMEDIAN_MAX_WINDOW];  // 样本所在堆：0 低半（大顶堆），1 高半（小顶堆）
+    uint8_t pos[SMEDIAN_MAX_WINDOW];   // 样本在所在堆中的下标
+    uint8_t lo[SMEDIAN_MAX_WINDOW];    // 低半堆，存样本槽位号
+    uint8_t hi[SMEDIAN_MAX_WINDOW];    // 高半堆
+    uint8_t nlo, nhi;
+    uint8_t win, idx, count;
+} SlidingMedian;
+int   SlidingMedianInit(SlidingMedian *m, uint8_t window);
+float SlidingMedianUpdate(SlidingMedian *m, float value);
+float SlidingMedianGet(const SlidingMedian *m);
+
+typedef struct {
+    SlidingMedian med;        // 样本中值
+    SlidingMedian dev;        // |x - 中值| 的滑动中值（MAD 估计）
+    float    k;               // 门限倍数，常用 3
+    uint32_t outliers;        // 已剔除的离群点数
+    uint32_t samples;
+} HampelFilter;
+int   HampelInit(HampelFilter *h, uint8_t window, float k);
+float HampelUpdate(HampelFilter *h, float value);
+
+
+/* CIC 抽取 + 补偿 FIR（定点）：高速采样流（如 140μs 转换）降到 10~100Hz 输出，
+   每个输入样本只有 N 次 64 位加法，梳状器与 FIR 只在输出速率下运行 */
+#define CIC_MAX_ORDER     5
+#define CIC_FIR_MAX_TAPS  15
+typedef struct {
+    uint64_t integ[CIC_MAX_ORDER];      // 积分器（按模 2^64 运算，溢出自然抵消）
+    uint64_t comb[CIC_MAX_ORDER];       // 梳状器延迟单元
+    int64_t  gain;                      // 直流增益 R^N
+    uint8_t  order;                     // N
+    uint16_t ratio;                     // R
+    uint16_t phase;
+    const int32_t *fir;                 // 补偿 FIR 系数（Q15，系数和 = 32768）
+    int32_t  fir_default[3];
+    uint8_t  taps;
+    int32_t  hist[CIC_FIR_MAX_TAPS];    // FIR 输入历史（输出速率）
+    uint8_t  hidx;
+} CicDecimator;
+int      CicInit(CicDecimator *c, uint8_t order, uint16_t ratio, const int32_t *fir_q15, uint8_t taps);
+void     CicReset(CicDecimator *c);
+uint16_t CicProcessBlock(CicDecimator *c, const int32_t *in, int32_t *out, uint16_t n);
+
+
+/* 滤波流水线：每个测量通道由若干级串联（如 中值 → 卡尔曼 → EMA → 抽取），
+   配置为常量表，处理时对整块样本逐点走完全部级（单循环），抽取级之后的样本不再输出
+   默认尺寸按 function.c 中的 FILTER_CHANNEL_TABLE（2 路，最多 3 级，中值窗口 5）取，
+   静态占用 ≈ FILTER_MAX_CHANNELS × (8 + FILTER_MAX_STAGES × 24) 字节，默认约 160 B；
+   替换配置表时需同时在编译选项中放大这三项 */
+#ifndef FILTER_MAX_STAGES
+#define FILTER_MAX_STAGES    3
+#endif
+#ifndef FILTER_MAX_CHANNELS
+#define FILTER_MAX_CHANNELS  2
+#endif
+#ifndef FILT_MEDIAN_MAX
+#define FILT_MEDIAN_MAX      5
+#endif
+
+typedef enum {
+    FILT_STAGE_MEDIAN = 1,   // n = 窗口（奇数，≤ FILT_MEDIAN_MAX）
+    FILT_STAGE_KALMAN,       // a = Q，b = R
+    FILT_STAGE_EMA,          // a = alpha
+    FILT_STAGE_DECIMATE      // n = 抽取倍数，输出 n 个样本的均值
+} FilterStageType;
+
+typedef struct {
+    uint8_t  type;
+    uint16_t n;
+    float    a;
+    float    b;
+} FilterStageCfg;
+
+#define FILT_MEDIAN(win)      { FILT_STAGE_MEDIAN,   (win), 0.0f,    0.0f }
+#define FILT_KALMAN(q, r)     { FILT_STAGE_KALMAN,   0,     (q),     (r)  }
+#define FILT_EMA(alpha)       { FILT_STAGE_EMA,      0,     (alpha), 0.0f }
+#define FILT_DECIMATE(factor) { FILT_STAGE_DECIMATE, (factor), 0.0f, 0.0f }
+
+typedef struct {
+    union {
+        struct { float buf[FILT_MEDIAN_MAX]; uint8_t idx, count; } med;
+        KalmanFilter kal;
+        struct { float y; uint8_t init; } ema;
+        struct { float acc; uint16_t count; } dec;
+    } u;
+} FilterStageState;
+
+typedef struct {
+    const FilterStageCfg *cfg;
+    uint8_t               stages;
+    FilterStageState      st[FILTER_MAX_STAGES];
+} FilterPipeline;
 
-/* 插值校准 */
-#define MAX_CAL_POINTS 10
+int      FilterPipelineInit(FilterPipeline *p, const FilterStageCfg *cfg, uint8_t stages);
+void     FilterPipelineReset(FilterPipeline *p);
+uint16_t FilterPipelineProcess(FilterPipeline *p, const float *in, float *out, uint16_t n);
+uint16_t FilterChannelProcess(uint8_t ch, const float *in, float *out, uint16_t n);
+
+
+/* 插值校准：points 升序；CalTableCompile 预算各段斜率后查表只需二分 + 一次乘加 */
+#define MAX_CAL_POINTS 32
+#define CAL_MAX_TABLES 4
 typedef struct {
-    int id;
+    int id;                             // 量程/设备编号，用于 CalSelect
     int num_points;
     float points[MAX_CAL_POINTS];
     float offsets[MAX_CAL_POINTS];
+    float slopes[MAX_CAL_POINTS];       // slopes[i]：第 i 段偏移量斜率，CalTableCompile 生成
+    uint8_t compiled;
 } CalTable;
+int   CalTableCompile(CalTable *ct);
 float CalibrateCurrent(const CalTable *ct, float rawCurrent);
+void  CalibrateBlock(const CalTable *ct, const float *in, float *out, uint16_t n);
+int   CalRegister(const CalTable *ct);
+const CalTable *CalSelect(int id);
+float CalibrateById(int id, float rawCurrent);
+
+/* 校准拟合：采集 (原始值, 参考值) 对，最小二乘拟合各节点偏移量，MAD 剔除离群点 */
+#ifndef CAL_FIT_MAX_SAMPLES
+#define CAL_FIT_MAX_SAMPLES 128
+#endif
+typedef struct {
+    float raw[CAL_FIT_MAX_SAMPLES];
+    float ref[CAL_FIT_MAX_SAMPLES];
+    float scratch[CAL_FIT_MAX_SAMPLES];
+    uint8_t  used[CAL_FIT_MAX_SAMPLES];
+    uint16_t count;
+    uint16_t rejected;                  // 最近一次拟合剔除的样本数
+    float    rms;                       // 最近一次拟合的残差 RMS
+} CalFitSession;
+void CalFitBegin(CalFitSession *s);
+int  CalFitAdd(CalFitSession *s, float raw, float ref);
+int  CalFitSolve(CalFitSession *s, const float *knots, int nknots, float reject_k, CalTable *out);
+
+/* 校准表持久化：带版本号与 CRC32 的二进制块，存储后端由 CalStore 提供 */
+#define CAL_BLOB_MAGIC    0x424C4143UL  // "CALB"
+#define CAL_BLOB_VERSION  1
+#define CAL_BLOB_MAX      (20 + 8 * MAX_CAL_POINTS)
+typedef struct {
+    int (*write)(void *ctx, const char *key, const void *data, uint32_t len);
+    int (*read)(void *ctx, const char *key, void *data, uint32_t max);     // 返回读取字节数，-1 失败
+    void *ctx;
+} CalStore;
+uint32_t Crc32(const void *data, uint32_t len);
+int  CalTableSerialize(const CalTable *ct, uint8_t *buf, uint32_t max);
+int  CalTableDeserialize(const uint8_t *buf, uint32_t len, CalTable *ct);
+int  CalTableSave(const CalStore *st, const CalTable *ct);
+int  CalTableLoad(const CalStore *st, int id, CalTable *ct);
+#ifdef ESP_PLATFORM
+void CalStoreNVS_Init(CalStore *st, const char *nvs_namespace);
+#endif
 
 
 /* 数值处理 */
 float MaxValue(uint8_t id, float value);
+
+/* 统计引擎：每通道一个上下文，自复位起（Welford）与若干时间窗口（分桶环形缓冲）的
+   min/max/mean/RMS/stddev，更新 O(1)；窗口按桶粒度滑动 */
+#ifndef STATS_MAX_WINDOWS
+#define STATS_MAX_WINDOWS  3
+#endif
+#ifndef STATS_MAX_BUCKETS
+#define STATS_MAX_BUCKETS  12
+#endif
+typedef struct {
+    uint32_t n;
+    float    mean;
+    float    m2;                        // Σ(x - mean)^2
+    float    min;
+    float    max;
+} StatsAccum;
+
+/* 自复位起累计：样本数可远超 2^24，float 的 mean += d/n 会舍入为 0 而停止更新，改用 double */
+typedef struct {
+    uint32_t n;
+    double   mean;
+    double   m2;
+    float    min;
+    float    max;
+} StatsTotalAccum;
+
+typedef struct {
+    uint32_t n;
+    float    min;
+    float    max;
+    float    mean;
+    float    rms;
+    float    stddev;                    // 总体标准差
+} StatsResult;
+
+typedef struct {
+    StatsAccum bucket[STATS_MAX_BUCKETS];
+    uint32_t   bucket_us;
+    uint64_t   bucket_end_us;           // 当前桶的结束时刻
+    uint8_t    nbuckets;
+    uint8_t    head;                    // 当前桶
+} StatsWindow;
+
+typedef struct {
+    StatsTotalAccum total;
+    StatsWindow win[STATS_MAX_WINDOWS];
+    uint8_t     nwin;
+} StatsChannel;
+void    StatsInit(StatsChannel *s);
+void    StatsInitDefault(StatsChannel *s);
+int     StatsAddWindow(StatsChannel *s, uint32_t span_us, uint8_t nbuckets);
+void    StatsReset(StatsChannel *s);
+void    StatsUpdate(StatsChannel *s, uint64_t t_us, float x);
+void    StatsTotal(const StatsChannel *s, StatsResult *out);
+void    StatsWindowResult(StatsChannel *s, uint8_t w, uint64_t now_us, StatsResult *out);
 const char* check_sign_str(float x, const char* neg_str, const char* pos_str);
 uint8_t CalculatePWM(float temperature);
+
+/* 风扇控制器：每个风扇一个对象，曲线（CalculatePWM 的迟滞曲线）或 PID，
+   转速反馈堵转检测、占空比斜率限制，PID 模式下统计调节时间与超调 */
+typedef enum {
+    FAN_MODE_CURVE = 0,
+    FAN_MODE_PID,
+} FanMode;
+
+typedef struct {
+    float   t_off;                      // OFF → SPAN 临界温度 °C
+    float   t_span;                     // SPAN → ON 临界温度
+    float   t_set;                      // ON → FULL 临界温度
+    uint8_t pwm_off;
+    uint8_t pwm_span_down;              // 降温进入 SPAN 时的占空比
+    uint8_t pwm_on;                     // ON 区线性起点
+    uint8_t pwm_max;
+} FanCurve;
+extern const FanCurve FanCurveDefault;      // CalculatePWM 使用的曲线（TEMP_* / PWM_*）
+
+typedef struct {
+    float setpoint_c;
+    float kp, ki, kd;                   // 输出单位：% 占空比
+    float settle_band_c;                // 调节时间判据：|误差| ≤ band
+} FanPid;
+
+typedef struct {
+    FanMode  mode;
+    FanCurve curve;
+    FanPid   pid;
+    uint8_t  sensor;                    // FanCtrlRunAll 中使用的温度通道
+    uint8_t  pwm_min;                   // PID 输出下限（0 = 允许停转）
+    float    slew_pct_per_s;            // 占空比最大变化率，0 不限制
+
+    /* 转速反馈：pulses_per_rev 为 0 时不检测 */
+    uint8_t  pulses_per_rev;
+    uint16_t stall_rpm;                 // 低于此转速视为堵转
+    uint16_t stall_ms;                  // 持续时间（应大于 500 ms 的测速周期）
+    uint8_t  stall_min_pwm;             // 占空比低于此值时不判堵转
+    volatile uint32_t tach_pulses;      // FanCtrlTachISR 累加
+
+    /* 状态 */
+    float    duty;                      // 当前输出 %
+    float    integ;
+    float    prev_temp;
+    uint8_t  last_non_span;
+    uint8_t  stalled;
+    uint8_t  rpm_valid;                 // 已完成第一个测速周期，此前不判堵转
+    uint32_t stall_events;
+    float    rpm;
+    uint32_t tach_last;
+    uint32_t tach_acc_ms;
+    uint32_t stall_timer_ms;
+
+    /* PID 指标（自 FanCtrlSetTarget 起） */
+    uint32_t since_step_ms;
+    uint32_t settle_ms;                 // 处于误差带内时为进入时刻，带外为 0
+    float    overshoot_c;               // 越过设定值的最大幅度
+    int8_t   step_sign;                 // 阶跃时误差符号
+} FanCtrl;
+void    FanCtrlInitCurve(FanCtrl *f, const FanCurve *curve, uint8_t sensor);
+void    FanCtrlInitPid(FanCtrl *f, const FanPid *pid, uint8_t sensor);
+void    FanCtrlSetTach(FanCtrl *f, uint8_t pulses_per_rev, uint16_t stall_rpm, uint16_t stall_ms, uint8_t stall_min_pwm);
+void    FanCtrlSetTarget(FanCtrl *f, float setpoint_c);
+void    FanCtrlTachISR(FanCtrl *f);
+uint8_t FanCtrlUpdate(FanCtrl *f, float temp_c, uint32_t dt_ms);
+void    FanCtrlRunAll(FanCtrl *fans, uint8_t n, const float *temps, uint32_t dt_ms, uint8_t *duty_out);
 float calc_wh(uint64_t curr_ms, float power_w);
+int64_t calc_uwh(uint64_t curr_ms, int64_t power_uw);
 float Voltage_To_Temperature(float voltage);
 
+/* NTC 查表：开机按热敏电阻参数生成以 ADC 码为索引的插值表，换算只需整数乘加 */
+#ifndef NTC_MAX_CHANNELS
+#define NTC_MAX_CHANNELS  2
+#endif
+#ifndef NTC_LUT_BITS
+#define NTC_LUT_BITS      7             // 2^7 段，12 位 ADC 时每段 32 码
+#endif
+typedef enum {
+    NTC_MODEL_BETA = 0,                 // 1/T = 1/T0 + ln(R/R0)/B
+    NTC_MODEL_SH,                       // Steinhart–Hart：1/T = A + B·lnR + C·(lnR)^3
+} NtcModel;
+
+typedef struct {
+    NtcModel model;
+    uint8_t  scheme;                    // 1=上拉电阻，2=下拉电阻（同 NTC_SCHEME）
+    uint8_t  adc_bits;
+    float    r_fixed;                   // 分压电阻 Ω
+    float    r0;                        // BETA：T0 时阻值 Ω
+    float    t0_c;                      // BETA：参考温度 °C
+    float    beta;
+    float    sh_a, sh_b, sh_c;          // SH 系数（R 单位 Ω，T 单位 K）
+} NtcParams;
+
+typedef struct {
+    NtcParams p;
+    int16_t   lut[(1 << NTC_LUT_BITS) + 1];   // 0.01 °C
+    uint8_t   shift;                    // adc_bits - NTC_LUT_BITS
+    uint8_t   ready;
+} NtcChannel;
+float   NtcModelTemperature(const NtcParams *p, float ratio);
+int     NtcConfigure(uint8_t ch, const NtcParams *p);
+int16_t NtcTemperatureCenti(uint8_t ch, uint16_t code);
+float   NtcTemperature(uint8_t ch, uint16_t code);
+
+/* 电量/能量累计器：每通道一个上下文，带时间戳梯形积分，整数累加 + 余量进位，长时间无漂移 */
+typedef struct {
+    int64_t  uas;                       // 累计电荷 μA·s
+    int64_t  uws;                       // 累计能量 μW·s
+    uint64_t elapsed_us;                // 自复位起的积分时长
+    uint32_t samples;
+} EnergySnapshot;
+
+typedef struct {
+    EnergySnapshot tot;
+    int64_t  rem_q;                     // 电荷余量，单位 μA·μs × 2，|rem_q| < 2e6
+    int64_t  rem_e;                     // 能量余量，单位 μW·μs × 2，|rem_e| < 2e6
+    uint64_t last_us;
+    int32_t  last_ua;
+    int64_t  last_uw;
+    uint8_t  started;
+} EnergyAcc;
+void  EnergyAccInit(EnergyAcc *acc);
+void  EnergyAccReset(EnergyAcc *acc);
+void  EnergyAccFeed(EnergyAcc *acc, uint64_t t_us, int32_t current_ua, int64_t power_uw);
+void  EnergyAccSnapshot(const EnergyAcc *acc, EnergySnapshot *out);
+float EnergyAccMilliAmpHours(const EnergySnapshot *snap);
+float EnergyAccWattHours(const EnergySnapshot *snap);
+
+/* 采样环消费者：从 INA226 采样环按块取出某一设备的读数，做能量累计与电流统计 */
+typedef struct {
+    INA226_Ring  *ring;
+    int           id;                   // 环中的消费者编号
+    uint8_t       dev;                  // 只处理该设备（管理器槽位号）的读数
+    uint32_t      overrun;              // 读取过慢丢失的样本数（环中所有设备）
+    EnergyAcc     energy;
+    StatsChannel  current;              // A
+} MeasureConsumer;
+int      MeasureConsumerInit(MeasureConsumer *mc, INA226_Ring *ring, uint8_t dev);
+uint32_t MeasureConsumerDrain(MeasureConsumer *mc);
+
 
 /* SYSTEM */
 #define MAX_KEYS 2
@@ -89,6 +492,51 @@ void Debounce_Process(void);
 void power_off(void);
 
 
+/* 基准测试：浮点与整数测量链路耗时对比（定义 FUNCTION_BENCH 时编译） */
+#ifdef FUNCTION_BENCH
+typedef struct {
+    uint32_t samples;
+    uint32_t float_us;
+    uint32_t int_us;
+} PipelineBenchResult;
+void PipelineBench(uint32_t samples, PipelineBenchResult *res);
+
+typedef struct {
+    uint32_t blocks;
+    uint16_t block_len;
+    uint32_t scalar_us;     // 逐样本调用 MovingAverageUpdate + KalmanUpdate
+    uint32_t block_us;      // *_ProcessBlock
+    float    max_diff;      // 两种方式输出的最大差值（滑动均值倒数乘法，≤ 1 ulp）
+} FilterBlockBenchResult;
+void FilterBlockBench(uint32_t blocks, uint16_t block_len, FilterBlockBenchResult *res);
+
+typedef struct {
+    uint32_t samples;
+    uint32_t logf_us;       // NtcModelTemperature（除法 + logf）
+    uint32_t lut_us;        // NtcTemperatureCenti
+    float    max_err_c;     // 查表相对模型的最大误差 °C
+} NtcBenchResult;
+void NtcBench(uint32_t samples, NtcBenchResult *res);
+
+typedef struct {
+    uint32_t samples;
+    uint32_t legacy_us;     // 旧 formatFloatToStr（snprintf + 逐位乘 10，截断）
+    uint32_t snprintf_us;   // snprintf("%0*.*f")
+    uint32_t float_us;      // formatFloatToStr
+    uint32_t fixed_us;      // FormatFixed（μA 定点输入）
+    uint32_t mismatches;    // 与 snprintf 不一致的次数：仅恰为 .5 的值（此处远离 0 舍入，printf 为偶数舍入）
+} FormatBenchResult;
+void FormatBench(uint32_t samples, FormatBenchResult *res);
+
+typedef struct {
+    uint32_t per_phase;     // 每段样本数
+    float    mean;          // 自复位起均值，两段各半时应为 1.5
+    float    stddev;        // 应约为 0.5
+} StatsLongRunResult;
+void StatsLongRunCheck(uint32_t per_phase, StatsLongRunResult *res);
+#endif
+
+
 
 
 #endif
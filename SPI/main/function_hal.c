@@ -0,0 +1,487 @@
+/******************************************************************************
+ * @file    function_hal.c
+ * @brief   依赖硬件的功能函数实现
+ * @details 按键逻辑、电源管理，以及运行时钟的 slot 差异渲染；
+ *          与 HAL / 显示屏 / 全局变量无关的格式化、滤波、校准、统计、能量累计等
+ *          见 function.c，可在主机上单独编译测试。
+ *
+ * @author  Bowen
+ * @note    接口声明见 function.h，许可与 function.c 相同（CC BY-NC-SA 4.0）
+ ******************************************************************************/
+
+#include "function.h"
+#include "main.h"
+#include "global.h"
+#include "st7789.h"
+
+
+/* ------------------------------------------------------------------
+  增量运行时钟：slot 差异渲染
+   ------------------------------------------------------------------ */
+/**
+ * @brief 送入 slot 差异渲染：未变化的位置输出空格，只需重绘变化的字形
+ * @param out 长度 BUF_LEN + 1，任何返回值下都是 BUF_LEN 个字符并以 '\0' 结尾
+ * @return 需要重绘的字形数（out 中的非空格字符，时间串本身不含空格）；
+ *         0 文本未变化；-1 无可用 slot（out 全为空格，改动保留到下次渲染）
+ */
+int UptimeClockRender(UptimeClock *c, uint16_t slot, char *out)
+{
+    int n = 0;
+
+    if (c->changed == 0) {
+        memset(out, ' ', BUF_LEN);
+    } else if (slot_diff_from_cstr(slot, c->text, out) != 0) {
+        memset(out, ' ', BUF_LEN);
+        n = -1;
+    } else {
+        c->changed = 0;
+        for (uint16_t i = 0; i < BUF_LEN; i++) n += (out[i] != ' ');
+    }
+    out[BUF_LEN] = '\0';
+    return n;
+}
+
+
+/* ------------------------------------------------------------------
+  多按钮逻辑判断
+   ------------------------------------------------------------------ */
+//void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+//{
+//    uint8_t idx;
+//    switch(GPIO_Pin)
+//    {
+//        case SW_WKUP_Pin: idx = 0; break;
+//        case SW_FUNC_Pin: idx = 1; break;
+//        default: return;
+//    }
+
+//    btn_last_irq[idx] = sys;
+//}
+
+void HAL_GPIO_EXTI_Rising_Callback(uint16_t GPIO_Pin)
+{
+    uint8_t idx;
+    switch(GPIO_Pin)
+    {
+        case SW_WKUP_Pin: idx = 0; break;
+        case SW_FUNC_Pin: idx = 1; break;
+        default: return;
+    }
+
+    btn_last_irq[idx] = sys;
+}
+
+void HAL_GPIO_EXTI_Falling_Callback(uint16_t GPIO_Pin)
+{
+    uint8_t idx;
+    switch(GPIO_Pin)
+    {
+        case SW_WKUP_Pin: idx = 0; break;
+        case SW_FUNC_Pin: idx = 1; break;
+        default: return;
+    }
+
+    btn_last_irq[idx] = sys;
+}
+
+
+
+#define DEBOUNCE_TIME 10
+volatile uint64_t btn_press_start[MAX_KEYS] = {0};
+volatile uint64_t btn_press_duration[MAX_KEYS] = {0};
+volatile uint8_t btn_flag[MAX_KEYS] = {0};
+
+// 在主循环或定时器中周期性调用此函数
+void Debounce_Process(void)
+{
+		static volatile uint8_t  btn_stable_state[MAX_KEYS] = {0};
+		
+    for (uint8_t i = 0; i < MAX_KEYS; i++) {
+        if (btn_last_irq[i] == 0) continue;  // 没有触发
+
+        if ((sys - btn_last_irq[i]) >= DEBOUNCE_TIME) {
+            // 已经过了消抖时间，读取稳定电平
+            uint8_t cur_level;
+            if (i == 0) cur_level = (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_0) == GPIO_PIN_SET) ? 1 : 0;
+            else if (i == 1) cur_level = (HAL_GPIO_ReadPin(GPIOC, GPIO_PIN_15) == GPIO_PIN_SET) ? 1 : 0;
+
+            // 状态变化才更新对外变量
+            if (cur_level != btn_stable_state[i]) {
+                if (cur_level == 1) {
+                    // 按下
+                    btn_press_start[i] = sys;
+                    btn_flag[i] = 1;
+                } else {
+                    // 松开
+                    btn_press_duration[i] = sys - btn_press_start[i];
+                    btn_flag[i] = 0;
+                }
+                btn_stable_state[i] = cur_level;
+            }
+
+            // 清零触发时间，避免重复处理
+            btn_last_irq[i] = 0;
+        }
+    }
+}
+
+
+/*
+按钮逻辑中：
+	访问一次就会更新一次按钮状态
+	会读取全局变量：按钮是否按下，按钮按下时间，系统时间
+	一旦松开或者超时，就会返回对应值 并 上锁，无法再次触发
+
+
+注意：调用该函数后应当立即调用判断函数，它仅会返回一次变化值，之后返回空值
+
+*/
+
+
+
+#define LONG_PRESS_THRESHOLD   1000   // 长按阈值，单位 ms
+#define DOUBLE_CLICK_THRESHOLD 350   // 双击最大间隔，单位 ms
+
+// 返回值定义
+#define BTN_NONE   0
+#define BTN_LONG   1
+#define BTN_SHORT  2
+#define BTN_DOUBLE 3
+
+//每次只能触发一次长按
+
+//不带双击版本
+//uint8_t btnLogic(uint8_t num)
+//{
+//    // 参数检查（假设最多3个按钮）
+//    if (num >= MAX_KEYS) return BTN_NONE;
+
+//    // 静态保存上次返回值和锁
+//    static uint8_t lastValue[MAX_KEYS] = {BTN_NONE};
+
+
+//    // 读取共享变量到本地，减少并发问题
+//		__disable_irq();
+//    uint8_t  btEN 			= 	btn_flag[num]; 
+//		uint64_t sys_inline = 	sys; 
+//		uint64_t btn_start 	= 	btn_press_start[num]; 
+//		uint64_t duration 	=  	sys_inline - btn_start;
+//		__enable_irq();
+//		
+
+//    // 如果已经触发过，返回
+//    if (lock[num]) {
+//			return BTN_NONE;
+//    }
+
+//    // 1) 长按判定：按下且超过阈值 -> 立即触发长按并加锁
+//    if (btEN && duration >= LONG_PRESS_THRESHOLD && !longFlag[num]) {
+//      lock[num] = 1;
+//      lastValue[num] = BTN_LONG;
+//			longFlag[num] = 1;//松开前不允许再次触发
+//      return lastValue[num];
+//    }
+
+//    // 2) 短按判定：按键已松开且有记录的按下时长
+//    //    这里 btn_press_duration[num] 在按键松开时被中断设置为实际时长（非0）
+//    if (!btEN && btn_press_duration[num] > 0) {
+//        // 如果持续时间小于长按阈值，判定为短按
+//        if ((uint64_t)btn_press_duration[num] < LONG_PRESS_THRESHOLD) {
+//            lock[num] = 1;
+//            lastValue[num] = BTN_SHORT;
+//            // 清除持续时间，避免重复判定
+//            btn_press_duration[num] = 0;
+//            return lastValue[num];
+//        } else {
+////            lock[num] = 1;
+////            lastValue[num] = BTN_LONG;
+////            return lastValue[num];
+//					//长按按钮松开
+//					btn_press_duration[num] = 0;
+//					longFlag[num] = 0;
+//					return BTN_NONE;
+//        }
+//    }
+
+//    // 3) 无事件，返回 NONE（不更新 lastValue）
+//    return BTN_NONE;
+//}
+
+
+
+
+//带双击版本
+#define LONG_PRESS_THRESHOLD   1000   // 长按阈值，单位 ms
+#define DOUBLE_CLICK_THRESHOLD 350   // 双击最大间隔，单位 ms
+
+// 返回值定义
+#define BTN_NONE   0
+#define BTN_LONG   1
+#define BTN_SHORT  2
+#define BTN_DOUBLE 3
+
+uint8_t btnLogic(uint8_t num)
+{
+    if (num >= MAX_KEYS) return BTN_NONE;
+
+    static uint8_t lastValue[MAX_KEYS] = {BTN_NONE};
+    static uint8_t pendingShort[MAX_KEYS] = {0};
+    static uint64_t lastReleaseTime[MAX_KEYS] = {0};
+
+    __disable_irq();
+    uint8_t  btEN        = btn_flag[num]; 
+    uint64_t sys_inline  = sys; 
+    uint64_t btn_start   = btn_press_start[num]; 
+    uint64_t duration    = sys_inline - btn_start;
+    __enable_irq();
+
+    if (lock[num]) {
+        return BTN_NONE;
+    }
+
+    // 1) 长按判定
+    if (btEN && duration >= LONG_PRESS_THRESHOLD && !longFlag[num]) {
+        lock[num] = 1;
+        lastValue[num] = BTN_LONG;
+        longFlag[num] = 1;
+        return lastValue[num];
+    }
+
+    // 2) 短按/双击判定
+    if (!btEN && btn_press_duration[num] > 0) {
+        if ((uint64_t)btn_press_duration[num] < LONG_PRESS_THRESHOLD) {
+            uint64_t now = sys_inline;
+            if (pendingShort[num] && (now - lastReleaseTime[num] <= DOUBLE_CLICK_THRESHOLD)) {
+                // 第二次短按在阈值内 -> 双击
+                pendingShort[num] = 0;
+                lock[num] = 1;
+                lastValue[num] = BTN_DOUBLE;
+                btn_press_duration[num] = 0;
+                return lastValue[num];
+            } else {
+                // 第一次短按，先挂起
+                pendingShort[num] = 1;
+                lastReleaseTime[num] = now;
+                btn_press_duration[num] = 0;
+                return BTN_NONE; // 暂时不返回，等待第二次
+            }
+        } else {
+            // 长按松开
+            btn_press_duration[num] = 0;
+            longFlag[num] = 0;
+            return BTN_NONE;
+        }
+    }
+
+    // 3) 检查挂起的短按是否超时
+    if (pendingShort[num] && (sys_inline - lastReleaseTime[num] > DOUBLE_CLICK_THRESHOLD)) {
+        pendingShort[num] = 0;
+        lock[num] = 1;
+        lastValue[num] = BTN_SHORT;
+        return lastValue[num];
+    }
+
+    return BTN_NONE;
+}
+
+
+//可触发多次长按,外部锁定
+uint8_t btnLogic_withExtLongFlag(uint8_t num)
+{
+    if (num >= MAX_KEYS) return BTN_NONE;
+
+    static uint8_t lastValue[MAX_KEYS] = {BTN_NONE};
+    static uint8_t pendingShort[MAX_KEYS] = {0};
+    static uint64_t lastReleaseTime[MAX_KEYS] = {0};
+
+    __disable_irq();
+    uint8_t  btEN        = btn_flag[num]; 
+    uint64_t sys_inline  = sys; 
+    uint64_t btn_start   = btn_press_start[num]; 
+    uint64_t duration    = sys_inline - btn_start;
+    __enable_irq();
+
+    if (lock[num]) {
+        return BTN_NONE;
+    }
+
+    // 1) 长按判定
+    if (btEN && duration >= LONG_PRESS_THRESHOLD && !longFlag[num]) {
+        lock[num] = 1;
+        lastValue[num] = BTN_LONG;
+//        longFlag[num] = 1;
+        return lastValue[num];
+    }
+
+    // 2) 短按/双击判定
+    if (!btEN && btn_press_duration[num] > 0) {
+        if ((uint64_t)btn_press_duration[num] < LONG_PRESS_THRESHOLD) {
+            uint64_t now = sys_inline;
+            if (pendingShort[num] && (now - lastReleaseTime[num] <= DOUBLE_CLICK_THRESHOLD)) {
+                // 第二次短按在阈值内 -> 双击
+                pendingShort[num] = 0;
+                lock[num] = 1;
+                lastValue[num] = BTN_DOUBLE;
+                btn_press_duration[num] = 0;
+                return lastValue[num];
+            } else {
+                // 第一次短按，先挂起
+                pendingShort[num] = 1;
+                lastReleaseTime[num] = now;
+                btn_press_duration[num] = 0;
+                return BTN_NONE; // 暂时不返回，等待第二次
+            }
+        } else {
+            // 长按松开
+            btn_press_duration[num] = 0;
+            longFlag[num] = 0;
+            return BTN_NONE;
+        }
+    }
+
+    // 3) 检查挂起的短按是否超时
+    if (pendingShort[num] && (sys_inline - lastReleaseTime[num] > DOUBLE_CLICK_THRESHOLD)) {
+        pendingShort[num] = 0;
+        lock[num] = 1;
+        lastValue[num] = BTN_SHORT;
+        return lastValue[num];
+    }
+
+    return BTN_NONE;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+/* ------------------------------------------------------------------
+  关机相关程序
+   ------------------------------------------------------------------ */
+
+////适用Cortex_M3
+//void Enter_StandbyMode(void)
+//{
+//    /**
+//     * @brief  进入 Standby 模式，PA0 上升沿唤醒
+//     */
+
+//    /* 1. 使能 PWR 外设时钟 */
+//    __HAL_RCC_PWR_CLK_ENABLE();
+
+//    /* 2. 清除 Wake-Up 标志，确保下次能正确唤醒 */
+//    __HAL_PWR_CLEAR_FLAG(PWR_FLAG_WUF);
+////	  __HAL_PWR_CLEAR_FLAG(PWR_FLAG_WU);
+
+//    /* 3. 使能 WKUP 引脚（PA0） */
+//    HAL_PWR_EnableWakeUpPin(PWR_WAKEUP_PIN1);
+
+//    /* 4. 设置 Cortex-M3 进入深度睡眠 */
+//    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+
+//    /* 5. 进入 Standby 模式，不会返回，除非由 PA0 唤醒 */
+//    HAL_PWR_EnterSTANDBYMode();
+//}
+
+//void GPIO_To_AnalogInput(void)
+//{
+//    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+//    __HAL_RCC_GPIOA_CLK_ENABLE();
+//    __HAL_RCC_GPIOB_CLK_ENABLE();
+//    __HAL_RCC_GPIOC_CLK_ENABLE();
+//    __HAL_RCC_GPIOD_CLK_ENABLE();
+
+//    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+//    GPIO_InitStruct.Pull = GPIO_NOPULL;
+
+//    // A 端口
+//    GPIO_InitStruct.Pin = GPIO_PIN_All & (~GPIO_PIN_0);
+//    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+//    // B 端口
+//    GPIO_InitStruct.Pin = GPIO_PIN_All;
+//    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+//    // C 端口
+//    GPIO_InitStruct.Pin = GPIO_PIN_All;
+//    HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+
+//    // D 端口（如果有）
+//    GPIO_InitStruct.Pin = GPIO_PIN_All;
+//    HAL_GPIO_Init(GPIOD, &GPIO_InitStruct);
+//}
+
+
+
+
+//适用Cortex_M0+
+void Enter_StandbyMode(void)
+{
+    /**
+     * @brief  进入 Standby 模式，PA0 上升沿唤醒
+     */
+
+    /* 1. 使能 PWR 外设时钟 */
+    __HAL_RCC_PWR_CLK_ENABLE();
+
+    /* 2. 清除 Wake-Up 标志，确保下次能正确唤醒 */
+    __HAL_PWR_CLEAR_FLAG(PWR_FLAG_WUF);
+
+    /* 3. 使能 WKUP 引脚（PA0） */
+    HAL_PWR_EnableWakeUpPin(PWR_WAKEUP_PIN1);
+
+    /* 4. 设置 Cortex-M0+ 进入深度睡眠 */
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+
+    /* 5. 进入 Standby 模式，不会返回，除非由 PA0 唤醒 */
+    HAL_PWR_EnterSTANDBYMode();
+}
+void GPIO_To_AnalogInput(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    __HAL_RCC_GPIOC_CLK_ENABLE();
+    // G030 没有 GPIOD，去掉
+
+    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+
+    // A 端口，保留 PA0 作为 WKUP 引脚
+    GPIO_InitStruct.Pin = GPIO_PIN_All & (~GPIO_PIN_0);
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    // B 端口
+    GPIO_InitStruct.Pin = GPIO_PIN_All;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+    // C 端口
+    GPIO_InitStruct.Pin = GPIO_PIN_All;
+    HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
+}
+
+void power_off(void)
+{
+	for (uint8_t i = 0; i < LCD_PANEL_NUM; i++) {
+		LCD_Clear(&lcd_panel[i], BLACK);LCD_BLK(&lcd_panel[i], 100);
+		LCD_ShowString_24_12(&lcd_panel[i], 100,65,RED,BLACK,"POWEROFF");
+	}
+	// 假设主频 72MHz，大约 6400000 次循环 ≈ 1 秒
+  for (volatile uint32_t i = 0; i < 6400000; i++) {__NOP();}
+	for (uint8_t i = 0; i < LCD_PANEL_NUM; i++) {
+		LCD_BLK(&lcd_panel[i], 0);
+		LCD_Clear(&lcd_panel[i], BLACK);
+	}
+	ST7789_Sync(&lcd_bus);
+	GPIO_To_AnalogInput();
+	Enter_StandbyMode();
+}